@@ -0,0 +1,210 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace memory
+{
+	// A monotonic bump allocator.
+	// Memory is carved out of large blocks and only given back all at once, when the arena is destroyed (or released).
+	class Arena final
+	{
+	public:
+		using size_type = std::size_t;
+
+		constexpr static size_type default_block_size = 64 * 1024;
+
+	private:
+		struct block_deleter
+		{
+			auto operator()(std::byte* block) const noexcept -> void { ::operator delete(block, std::align_val_t{alignof(std::max_align_t)}); }
+		};
+
+		using block_type = std::unique_ptr<std::byte, block_deleter>;
+
+		size_type block_size_;
+		std::vector<block_type> blocks_;
+
+		std::byte* current_;
+		std::byte* end_;
+
+		size_type bytes_used_;
+		size_type bytes_reserved_;
+
+		auto grow(const size_type minimum_size) -> void
+		{
+			const auto size = minimum_size > block_size_ ? minimum_size : block_size_;
+
+			auto* block = static_cast<std::byte*>(::operator new(size, std::align_val_t{alignof(std::max_align_t)}));
+			blocks_.emplace_back(block);
+
+			current_ = block;
+			end_ = block + size;
+			bytes_reserved_ += size;
+		}
+
+	public:
+		explicit Arena(const size_type block_size = default_block_size) noexcept
+			: block_size_{block_size},
+			current_{nullptr},
+			end_{nullptr},
+			bytes_used_{0},
+			bytes_reserved_{0} {}
+
+		Arena(const Arena&) = delete;
+		Arena& operator=(const Arena&) = delete;
+		// pools keep a pointer to their arena
+		Arena(Arena&&) = delete;
+		Arena& operator=(Arena&&) = delete;
+		~Arena() noexcept = default;
+
+		[[nodiscard]] auto allocate(const size_type size, const size_type alignment) -> void*
+		{
+			const auto align_up = [alignment](std::byte* p) -> std::byte*
+			{
+				const auto address = reinterpret_cast<std::uintptr_t>(p);
+				return p + ((alignment - (address % alignment)) % alignment);
+			};
+
+			auto* begin = align_up(current_);
+			if (current_ == nullptr || begin + size > end_)
+			{
+				// the worst case padding is (alignment - 1)
+				grow(size + alignment - 1);
+				begin = align_up(current_);
+			}
+
+			current_ = begin + size;
+			bytes_used_ += size;
+			return begin;
+		}
+
+		// Trivially destructible objects only, nobody will ever call the destructor.
+		// Use ObjectPool for everything else.
+		template<typename T, typename... Args>
+			requires std::is_trivially_destructible_v<T>
+		[[nodiscard]] auto make(Args&&... args) -> T*
+		{
+			return ::new(allocate(sizeof(T), alignof(T))) T{std::forward<Args>(args)...};
+		}
+
+		// Give back every block at once.
+		auto release() noexcept -> void
+		{
+			blocks_.clear();
+			current_ = nullptr;
+			end_ = nullptr;
+			bytes_used_ = 0;
+			bytes_reserved_ = 0;
+		}
+
+		[[nodiscard]] auto bytes_used() const noexcept -> size_type { return bytes_used_; }
+
+		[[nodiscard]] auto bytes_reserved() const noexcept -> size_type { return bytes_reserved_; }
+	};
+
+	// Typed storage on top of an Arena.
+	// Objects are constructed in place in slabs taken from the arena, and destroyed (in reverse order) together with the pool.
+	// The pool must not outlive the arena it allocates from.
+	template<typename T>
+	class ObjectPool final
+	{
+	public:
+		using value_type = T;
+		using size_type = std::size_t;
+
+		constexpr static size_type initial_slab_capacity = 16;
+		constexpr static size_type max_slab_capacity = 4096;
+
+	private:
+		struct slab
+		{
+			T* data;
+			size_type size;
+			size_type capacity;
+		};
+
+		Arena* arena_;
+		std::vector<slab> slabs_;
+		size_type size_;
+
+		auto destroy() noexcept -> void
+		{
+			if constexpr (!std::is_trivially_destructible_v<T>)
+			{
+				for (auto it = slabs_.rbegin(); it != slabs_.rend(); ++it)
+				{
+					for (auto i = it->size; i != 0; --i) { std::destroy_at(it->data + (i - 1)); }
+				}
+			}
+
+			slabs_.clear();
+			size_ = 0;
+		}
+
+	public:
+		explicit ObjectPool(Arena& arena) noexcept
+			: arena_{&arena},
+			size_{0} {}
+
+		ObjectPool(const ObjectPool&) = delete;
+		ObjectPool& operator=(const ObjectPool&) = delete;
+
+		ObjectPool(ObjectPool&& other) noexcept
+			: arena_{other.arena_},
+			slabs_{std::exchange(other.slabs_, {})},
+			size_{std::exchange(other.size_, 0)} {}
+
+		ObjectPool& operator=(ObjectPool&& other) noexcept
+		{
+			if (this != &other)
+			{
+				destroy();
+				arena_ = other.arena_;
+				slabs_ = std::exchange(other.slabs_, {});
+				size_ = std::exchange(other.size_, 0);
+			}
+			return *this;
+		}
+
+		~ObjectPool() noexcept { destroy(); }
+
+		template<typename... Args>
+		[[nodiscard]] auto make(Args&&... args) -> T*
+		{
+			if (slabs_.empty() || slabs_.back().size == slabs_.back().capacity)
+			{
+				// double the slab capacity each time, so that the number of slabs stays logarithmic
+				const auto capacity = slabs_.empty() ? initial_slab_capacity : std::min(slabs_.back().capacity * 2, max_slab_capacity);
+				slabs_.push_back({.data = static_cast<T*>(arena_->allocate(sizeof(T) * capacity, alignof(T))), .size = 0, .capacity = capacity});
+			}
+
+			auto& current = slabs_.back();
+			auto* result = ::new(current.data + current.size) T{std::forward<Args>(args)...};
+			// only count the object once it is fully constructed
+			++current.size;
+			++size_;
+			return result;
+		}
+
+		// Calls `function` for every living object, in creation order.
+		template<typename Function>
+		auto for_each(Function&& function) const -> void
+		{
+			for (const auto& s: slabs_)
+			{
+				for (size_type i = 0; i < s.size; ++i) { function(s.data[i]); }
+			}
+		}
+
+		[[nodiscard]] auto size() const noexcept -> size_type { return size_; }
+
+		[[nodiscard]] auto empty() const noexcept -> bool { return size_ == 0; }
+	};
+}
@@ -0,0 +1,403 @@
+#pragma once
+
+#include <CMakeTemplateProject/arena.hpp>
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace backend
+{
+	using symbol_name_type = std::string;
+	using symbol_name_view_type = std::string_view;
+
+	// index of a local/block inside its function, dense and in declaration order
+	using slot_type = std::uint32_t;
+	constexpr slot_type invalid_slot = std::numeric_limits<slot_type>::max();
+	// index of a function/global inside its module, dense and in declaration order
+	using index_type = std::uint32_t;
+
+	// $i32, see builtin.hpp for the whole set
+	class BuiltinType
+	{
+	public:
+		enum class id_type : std::uint8_t
+		{
+			i8,
+			i16,
+			i32,
+			i64,
+			u8,
+			u16,
+			u32,
+			u64,
+			f32,
+			f64,
+			ptr,
+		};
+
+		id_type id{};
+		symbol_name_view_type name{};
+		// in bytes
+		std::uint8_t size{};
+	};
+
+	// The content of a global, kept the way it was written (literal bytes, repetitions and concatenations of both)
+	// and only expanded when emitted, so that `[00]*16777216` costs the same as `[00]*1`.
+	class data_type
+	{
+	public:
+		using size_type = std::uint64_t;
+
+		struct segment
+		{
+			// either raw bytes...
+			std::string bytes;
+			// ...or (if not null) a nested expression
+			std::shared_ptr<const data_type> nested;
+			// the pattern (bytes or nested) is repeated `count` times
+			size_type count;
+
+			[[nodiscard]] auto pattern_size() const noexcept -> size_type { return nested ? nested->size() : bytes.size(); }
+
+			[[nodiscard]] auto size() const noexcept -> size_type { return pattern_size() * count; }
+		};
+
+	private:
+		std::vector<segment> segments_;
+		// expanded size
+		size_type size_;
+		// the expanded size does not fit in size_type
+		bool too_large_;
+
+		auto push_back(segment&& s) -> void;
+
+	public:
+		data_type() noexcept
+			: size_{0},
+			too_large_{false} {}
+
+		// literal bytes
+		explicit data_type(std::string bytes);
+
+		// The content of `payload`, sharing its storage with every other data made from the same payload (see DataPool).
+		[[nodiscard]] static auto shared(std::shared_ptr<const data_type> payload) -> data_type;
+
+		// `too_large` if the repeated size does not fit
+		[[nodiscard]] static auto repeat(data_type&& pattern, size_type count) -> data_type;
+
+		// concatenation
+		auto append(data_type&& other) -> void;
+
+		[[nodiscard]] auto empty() const noexcept -> bool { return size_ == 0; }
+
+		[[nodiscard]] auto size() const noexcept -> size_type { return size_; }
+
+		// The expanded size overflowed (e.g. `[[00] * 4294967296] * 4294967296`), `size` means nothing then.
+		// Such data must not be emitted, see global_declaration.
+		[[nodiscard]] auto too_large() const noexcept -> bool { return too_large_; }
+
+		[[nodiscard]] auto segments() const noexcept -> std::span<const segment> { return segments_; }
+
+		// Calls `function(std::string_view)` for consecutive pieces of the expansion, nothing is materialized.
+		// Short patterns are handed out a few KB at a time rather than once per repetition.
+		auto for_each_chunk(const std::function<void(std::string_view)>& function) const -> void;
+
+		[[nodiscard]] auto expand() const -> std::string;
+
+		// every expanded byte is zero (an empty data is all zero too)
+		[[nodiscard]] auto all_zero() const noexcept -> bool;
+
+		// the bytes actually held (the literal bytes of every segment), nested data counted each time it is used
+		[[nodiscard]] auto stored_size() const noexcept -> size_type;
+
+		// The data whose storage this one shares (made by `shared`, or a single nested pattern used once), null if there is none.
+		// Data with the same payload has the same content.
+		[[nodiscard]] auto payload() const noexcept -> const data_type*;
+
+		// A hash of the segments, stable across runs like hashing::stable_hash.
+		// The same segments hash the same, data written differently (`[00]*2` and `00, 00`) may not.
+		[[nodiscard]] auto hash() const noexcept -> std::uint64_t;
+
+		// same segments, see hash
+		friend auto operator==(const data_type& lhs, const data_type& rhs) noexcept -> bool;
+	};
+
+	// Immutable data hash-consed by content: identical data is stored once, every global made of it shares that storage.
+	// The pool does not own the data, a payload is released with the last global holding it.
+	// Thread-safe, a single pool may serve every module of the process (see share_across_modules).
+	class DataPool final
+	{
+	public:
+		using size_type = data_type::size_type;
+
+		struct statistics
+		{
+			// distinct payloads added
+			std::size_t payloads;
+			// data found already in the pool
+			std::size_t reused;
+			// storage that was not duplicated, see data_type::stored_size
+			size_type bytes_saved;
+			// the same, expanded
+			size_type expanded_bytes_saved;
+			// hashes currently tracked
+			std::size_t buckets;
+		};
+
+	private:
+		constexpr static std::size_t shard_count = 16;
+		constexpr static std::size_t min_sweep = 64;
+
+		struct shard
+		{
+			std::mutex mutex;
+			// hash => the live payloads with that hash
+			std::unordered_map<std::uint64_t, std::vector<std::weak_ptr<const data_type>>> payloads;
+			statistics stats{};
+			// the buckets left empty by released payloads are dropped once the map reaches this size
+			std::size_t sweep_at{min_sweep};
+		};
+
+		mutable std::array<shard, shard_count> shards_;
+
+		static std::atomic<bool> share_across_modules_;
+
+	public:
+		DataPool() = default;
+
+		DataPool(const DataPool&) = delete;
+		DataPool& operator=(const DataPool&) = delete;
+		DataPool(DataPool&&) = delete;
+		DataPool& operator=(DataPool&&) = delete;
+		~DataPool() noexcept = default;
+
+		// The payload with the same content as `data` if there is one, otherwise `data` becomes a payload.
+		[[nodiscard]] auto intern(data_type&& data) -> std::shared_ptr<const data_type>;
+
+		[[nodiscard]] auto stats() const -> statistics;
+
+		// shared by the modules created while share_across_modules is enabled
+		[[nodiscard]] static auto process() -> DataPool&;
+
+		// Whether the modules created from now on intern their immutable data into `process()` (shared with each other),
+		// rather than into a pool of their own (the default).
+		static auto share_across_modules(bool enable) noexcept -> void;
+
+		[[nodiscard]] static auto sharing_across_modules() noexcept -> bool;
+	};
+
+	class Block;
+
+	class Global
+	{
+	public:
+		enum class kind_type
+		{
+			// global const @x = ...;
+			mutable_data,
+			// global @x = ...;
+			immutable_data,
+		};
+
+		symbol_name_type name;
+		kind_type kind;
+		data_type data;
+		index_type index;
+
+		Global(symbol_name_type name, const kind_type kind, data_type&& data, const index_type index)
+			: name{std::move(name)},
+			kind{kind},
+			data{std::move(data)},
+			index{index} {}
+	};
+
+	class Local
+	{
+	public:
+		symbol_name_type name;
+		slot_type slot;
+
+		Local(symbol_name_type name, const slot_type slot)
+			: name{std::move(name)},
+			slot{slot} {}
+	};
+
+	class Function
+	{
+	public:
+		struct signature
+		{
+			using size_type = std::uint8_t;
+
+			size_type input;
+			size_type output;
+		};
+
+		signature sig;
+		symbol_name_type name;
+		index_type index;
+		// in declaration order (indexed by slot), empty for a forward declaration
+		// the first block is the entry of the function
+		std::vector<Local*> locals;
+		std::vector<Block*> blocks;
+
+		Function(const signature sig, symbol_name_type name, const index_type index)
+			: sig{sig},
+			name{std::move(name)},
+			index{index} {}
+	};
+
+	// $add, see builtin.hpp for the whole set
+	class BuiltinFunction
+	{
+	public:
+		enum class id_type : std::uint8_t
+		{
+			add,
+			sub,
+			mul,
+			div,
+			rem,
+			bit_and,
+			bit_or,
+			bit_xor,
+			shl,
+			shr,
+			eq,
+			ne,
+			lt,
+			le,
+			load,
+			store,
+			dup,
+			drop,
+			swap,
+		};
+
+		id_type id{};
+		symbol_name_view_type name{};
+		// stack effect
+		Function::signature sig{};
+	};
+
+	// function body
+	class Block
+	{
+	public:
+		Function::signature sig;
+		slot_type slot;
+		// encoded instructions, see bytecode.hpp
+		std::vector<std::uint8_t> code;
+
+		Block(const Function::signature sig, const slot_type slot)
+			: sig{sig},
+			slot{slot} {}
+	};
+
+	class Module
+	{
+	public:
+		symbol_name_type module_name;
+
+	private:
+		// every object created while parsing this module lives here and is released together with the module
+		// note: the pools must be declared after (destroyed before) the arena
+		memory::Arena arena_;
+		memory::ObjectPool<Function> functions_;
+		memory::ObjectPool<Global> globals_;
+		memory::ObjectPool<Local> locals_;
+		memory::ObjectPool<Block> blocks_;
+
+		// where the immutable data is interned, `own_data_` or DataPool::process()
+		DataPool own_data_;
+		DataPool* data_pool_;
+
+		friend class LocalBuilder;
+
+	public:
+		explicit Module(symbol_name_type&& module_name)
+			: module_name{std::move(module_name)},
+			functions_{arena_},
+			globals_{arena_},
+			locals_{arena_},
+			blocks_{arena_},
+			data_pool_{DataPool::sharing_across_modules() ? &DataPool::process() : &own_data_} {}
+
+		Module(const Module&) = delete;
+		Module& operator=(const Module&) = delete;
+		Module(Module&&) = delete;
+		Module& operator=(Module&&) = delete;
+		~Module() noexcept = default;
+
+		// the name is copied into the module, `identifier` may point into the source
+		auto register_function(const symbol_name_view_type identifier, const Function::signature sig) -> Function*
+		{
+			return functions_.make(sig, symbol_name_type{identifier}, static_cast<index_type>(functions_.size()));
+		}
+
+		auto register_global_mutable_data(const symbol_name_view_type identifier, data_type&& data) -> Global*
+		{
+			return globals_.make(symbol_name_type{identifier}, Global::kind_type::mutable_data, std::move(data), static_cast<index_type>(globals_.size()));
+		}
+
+		// the data is interned, identical data shares its storage with the other globals holding it (see DataPool)
+		auto register_global_immutable_data(const symbol_name_view_type identifier, data_type&& data) -> Global*
+		{
+			return globals_.make(symbol_name_type{identifier}, Global::kind_type::immutable_data, data_type::shared(data_pool_->intern(std::move(data))), static_cast<index_type>(globals_.size()));
+		}
+
+		// in creation order
+		[[nodiscard]] auto functions() const noexcept -> const memory::ObjectPool<Function>& { return functions_; }
+
+		[[nodiscard]] auto globals() const noexcept -> const memory::ObjectPool<Global>& { return globals_; }
+
+		[[nodiscard]] auto locals() const noexcept -> const memory::ObjectPool<Local>& { return locals_; }
+
+		[[nodiscard]] auto blocks() const noexcept -> const memory::ObjectPool<Block>& { return blocks_; }
+
+		// the pool of the immutable data, its statistics tell how much storage was shared
+		[[nodiscard]] auto data_pool() const noexcept -> const DataPool& { return *data_pool_; }
+	};
+
+	class LocalBuilder
+	{
+	public:
+		explicit LocalBuilder(Module& mod)
+			: mod_{&mod},
+			function_{nullptr} {}
+
+		// the following locals and blocks belong to `function`
+		auto begin_function(Function& function) -> void { function_ = &function; }
+
+		// the slot of a local/block is the number of locals/blocks of the function before it (invalid_slot outside of a function)
+		auto register_local(const symbol_name_view_type identifier) -> Local*
+		{
+			auto* local = mod_->locals_.make(symbol_name_type{identifier}, function_ != nullptr ? slot_of(function_->locals.size()) : invalid_slot);
+			if (function_ != nullptr) { function_->locals.push_back(local); }
+			return local;
+		}
+
+		auto register_block(const Function::signature signature) -> Block*
+		{
+			auto* block = mod_->blocks_.make(signature, function_ != nullptr ? slot_of(function_->blocks.size()) : invalid_slot);
+			if (function_ != nullptr) { function_->blocks.push_back(block); }
+			return block;
+		}
+
+	private:
+		Module* mod_;
+		Function* function_;
+
+		[[nodiscard]] static auto slot_of(const std::size_t index) noexcept -> slot_type { return index < invalid_slot ? static_cast<slot_type>(index) : invalid_slot; }
+	};
+}
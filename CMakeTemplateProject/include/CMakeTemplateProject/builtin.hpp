@@ -0,0 +1,133 @@
+#pragma once
+
+#include <CMakeTemplateProject/backend.hpp>
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <string_view>
+
+namespace backend::builtin
+{
+	// FNV-1a, with a seed so that the tables below can look for one without collisions
+	[[nodiscard]] constexpr auto hash(const std::string_view name, const std::uint32_t seed) noexcept -> std::uint32_t
+	{
+		auto h = 0x811c'9dc5u ^ seed;
+		for (const auto c: name)
+		{
+			h ^= static_cast<unsigned char>(c);
+			h *= 0x0100'0193u;
+		}
+		return h ^ (h >> 15);
+	}
+
+	// A perfect hash over a fixed set of (named) entries, the seed is searched at compile time.
+	// Every entry gets a slot of its own, so a lookup is one hash and one comparison.
+	template<typename T, std::size_t N>
+	class PerfectHashTable final
+	{
+	public:
+		using size_type = std::size_t;
+
+		// at most half full, a seed is found after a few tries
+		constexpr static size_type table_size = std::bit_ceil(N * 2);
+
+	private:
+		std::array<T, N> entries_;
+		// index + 1 into `entries_`, 0 => empty
+		std::array<std::uint8_t, table_size> slots_;
+		std::uint32_t seed_;
+
+		static_assert(N < 255);
+
+		[[nodiscard]] constexpr static auto slot_of(const std::string_view name, const std::uint32_t seed) noexcept -> size_type { return hash(name, seed) & (table_size - 1); }
+
+	public:
+		consteval explicit PerfectHashTable(const std::array<T, N>& entries)
+			: entries_{entries},
+			slots_{},
+			seed_{0}
+		{
+			for (;; ++seed_)
+			{
+				slots_ = {};
+
+				bool collision = false;
+				for (size_type i = 0; i < N && !collision; ++i)
+				{
+					auto& slot = slots_[slot_of(entries_[i].name, seed_)];
+					collision = slot != 0;
+					slot = static_cast<std::uint8_t>(i + 1);
+				}
+
+				if (!collision) { return; }
+			}
+		}
+
+		[[nodiscard]] constexpr auto find(const std::string_view name) const noexcept -> const T*
+		{
+			const auto slot = slots_[slot_of(name, seed_)];
+			if (slot == 0) { return nullptr; }
+
+			const auto& entry = entries_[slot - 1];
+			return entry.name == name ? &entry : nullptr;
+		}
+
+		[[nodiscard]] constexpr auto entries() const noexcept -> std::span<const T> { return entries_; }
+	};
+
+	using type_id = BuiltinType::id_type;
+	using function_id = BuiltinFunction::id_type;
+
+	// $name => type, read-only and shared by every parse
+	constexpr PerfectHashTable types{
+			std::array{
+					BuiltinType{.id = type_id::i8, .name = "i8", .size = 1},
+					BuiltinType{.id = type_id::i16, .name = "i16", .size = 2},
+					BuiltinType{.id = type_id::i32, .name = "i32", .size = 4},
+					BuiltinType{.id = type_id::i64, .name = "i64", .size = 8},
+					BuiltinType{.id = type_id::u8, .name = "u8", .size = 1},
+					BuiltinType{.id = type_id::u16, .name = "u16", .size = 2},
+					BuiltinType{.id = type_id::u32, .name = "u32", .size = 4},
+					BuiltinType{.id = type_id::u64, .name = "u64", .size = 8},
+					BuiltinType{.id = type_id::f32, .name = "f32", .size = 4},
+					BuiltinType{.id = type_id::f64, .name = "f64", .size = 8},
+					BuiltinType{.id = type_id::ptr, .name = "ptr", .size = 8},
+			}};
+
+	// $name => function, read-only and shared by every parse
+	constexpr PerfectHashTable functions{
+			std::array{
+					BuiltinFunction{.id = function_id::add, .name = "add", .sig = {.input = 2, .output = 1}},
+					BuiltinFunction{.id = function_id::sub, .name = "sub", .sig = {.input = 2, .output = 1}},
+					BuiltinFunction{.id = function_id::mul, .name = "mul", .sig = {.input = 2, .output = 1}},
+					BuiltinFunction{.id = function_id::div, .name = "div", .sig = {.input = 2, .output = 1}},
+					BuiltinFunction{.id = function_id::rem, .name = "rem", .sig = {.input = 2, .output = 1}},
+					BuiltinFunction{.id = function_id::bit_and, .name = "and", .sig = {.input = 2, .output = 1}},
+					BuiltinFunction{.id = function_id::bit_or, .name = "or", .sig = {.input = 2, .output = 1}},
+					BuiltinFunction{.id = function_id::bit_xor, .name = "xor", .sig = {.input = 2, .output = 1}},
+					BuiltinFunction{.id = function_id::shl, .name = "shl", .sig = {.input = 2, .output = 1}},
+					BuiltinFunction{.id = function_id::shr, .name = "shr", .sig = {.input = 2, .output = 1}},
+					BuiltinFunction{.id = function_id::eq, .name = "eq", .sig = {.input = 2, .output = 1}},
+					BuiltinFunction{.id = function_id::ne, .name = "ne", .sig = {.input = 2, .output = 1}},
+					BuiltinFunction{.id = function_id::lt, .name = "lt", .sig = {.input = 2, .output = 1}},
+					BuiltinFunction{.id = function_id::le, .name = "le", .sig = {.input = 2, .output = 1}},
+					// address => value
+					BuiltinFunction{.id = function_id::load, .name = "load", .sig = {.input = 1, .output = 1}},
+					// address, value =>
+					BuiltinFunction{.id = function_id::store, .name = "store", .sig = {.input = 2, .output = 0}},
+					BuiltinFunction{.id = function_id::dup, .name = "dup", .sig = {.input = 1, .output = 2}},
+					BuiltinFunction{.id = function_id::drop, .name = "drop", .sig = {.input = 1, .output = 0}},
+					BuiltinFunction{.id = function_id::swap, .name = "swap", .sig = {.input = 2, .output = 2}},
+			}};
+
+	// the tables are indexed by id
+	static_assert([]
+	{
+		for (std::size_t i = 0; i < types.entries().size(); ++i) { if (static_cast<std::size_t>(types.entries()[i].id) != i) { return false; } }
+		for (std::size_t i = 0; i < functions.entries().size(); ++i) { if (static_cast<std::size_t>(functions.entries()[i].id) != i) { return false; } }
+		return true;
+	}());
+}
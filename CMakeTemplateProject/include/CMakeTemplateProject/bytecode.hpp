@@ -0,0 +1,192 @@
+#pragma once
+
+#include <CMakeTemplateProject/backend.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace backend::bytecode
+{
+	// The code of a block is a stream of variable-length instructions: one opcode byte followed by its operands.
+	// Operands are LEB128 encoded, so the indices of a module with less than 128 locals/blocks/functions/globals take one byte each.
+	//
+	// Every value on the stack is 64 bits wide, a block (and a function) takes `sig.input` values and leaves `sig.output` values.
+	enum class opcode : std::uint8_t
+	{
+		// the builtin functions come first, with the same values as BuiltinFunction::id_type
+		add,
+		sub,
+		mul,
+		div,
+		rem,
+		bit_and,
+		bit_or,
+		bit_xor,
+		shl,
+		shr,
+		eq,
+		ne,
+		lt,
+		le,
+		load,
+		store,
+		dup,
+		drop,
+		swap,
+
+		// dummy
+		nop,
+		// push <signed immediate>
+		push,
+		// get <local slot>, pushes the local
+		get,
+		// set <local slot>, pops into the local
+		set,
+		// address <global index>, pushes the address of the global
+		address,
+		// call <function index>
+		call,
+		// call <block slot>, runs the block of the same function in place
+		call_block,
+		// if <block slot>, pops a condition and runs the block if it is not zero
+		if_,
+		// if <block slot> else <block slot>
+		if_else,
+		// loop <block slot>, runs the block and pops a condition, again and again until it is zero
+		loop,
+	};
+
+	constexpr std::size_t builtin_opcode_count = static_cast<std::size_t>(BuiltinFunction::id_type::swap) + 1;
+	constexpr std::size_t opcode_count = static_cast<std::size_t>(opcode::loop) + 1;
+
+	static_assert(static_cast<std::size_t>(opcode::swap) + 1 == builtin_opcode_count);
+
+	[[nodiscard]] constexpr auto builtin_opcode(const BuiltinFunction::id_type id) noexcept -> opcode { return static_cast<opcode>(id); }
+
+	[[nodiscard]] constexpr auto is_builtin(const opcode op) noexcept -> bool { return static_cast<std::size_t>(op) < builtin_opcode_count; }
+
+	[[nodiscard]] constexpr auto operand_count(const opcode op) noexcept -> std::size_t
+	{
+		if (is_builtin(op) || op == opcode::nop) { return 0; }
+		return op == opcode::if_else ? 2 : 1;
+	}
+
+	using code_type = std::vector<std::uint8_t>;
+
+	// at most 10 bytes per operand
+	constexpr std::size_t max_operand_size = 10;
+	constexpr std::size_t max_instruction_size = 1 + 2 * max_operand_size;
+
+	inline auto emit_unsigned(code_type& code, std::uint64_t value) -> void
+	{
+		while (value >= 0x80)
+		{
+			code.push_back(static_cast<std::uint8_t>(value | 0x80));
+			value >>= 7;
+		}
+		code.push_back(static_cast<std::uint8_t>(value));
+	}
+
+	// zigzag, small negative numbers stay short
+	inline auto emit_signed(code_type& code, const std::int64_t value) -> void { emit_unsigned(code, (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63)); }
+
+	inline auto emit(code_type& code, const opcode op) -> void { code.push_back(static_cast<std::uint8_t>(op)); }
+
+	inline auto emit(code_type& code, const opcode op, const std::uint64_t operand) -> void
+	{
+		emit(code, op);
+		emit_unsigned(code, operand);
+	}
+
+	inline auto emit(code_type& code, const opcode op, const std::uint64_t first, const std::uint64_t second) -> void
+	{
+		emit(code, op, first);
+		emit_unsigned(code, second);
+	}
+
+	inline auto emit_push(code_type& code, const std::int64_t immediate) -> void
+	{
+		emit(code, opcode::push);
+		emit_signed(code, immediate);
+	}
+
+	struct instruction
+	{
+		opcode op;
+		// unused operands are 0, the immediate of `push` is stored as its two's complement
+		std::uint64_t operands[2];
+		// offset of the next instruction
+		std::size_t next;
+
+		[[nodiscard]] constexpr auto immediate() const noexcept -> std::int64_t { return static_cast<std::int64_t>(operands[0]); }
+	};
+
+	// Reads the unsigned operand at `offset`, nullopt if it is truncated or does not fit in 64 bits.
+	[[nodiscard]] constexpr auto decode_unsigned(const std::span<const std::uint8_t> code, std::size_t& offset) noexcept -> std::optional<std::uint64_t>
+	{
+		std::uint64_t result = 0;
+		for (unsigned shift = 0; offset < code.size() && shift < 64; shift += 7)
+		{
+			const auto byte = code[offset++];
+			// the tenth byte holds the last bit, anything more would be silently dropped
+			if (shift == 63 && byte > 1) { return std::nullopt; }
+			result |= static_cast<std::uint64_t>(byte & 0x7f) << shift;
+			if ((byte & 0x80) == 0) { return result; }
+		}
+		return std::nullopt;
+	}
+
+	// The instruction at `offset`, nullopt if the code is malformed (an image is checked with it before it is used).
+	[[nodiscard]] constexpr auto decode(const std::span<const std::uint8_t> code, std::size_t offset) noexcept -> std::optional<instruction>
+	{
+		if (offset >= code.size() || code[offset] >= opcode_count) { return std::nullopt; }
+
+		instruction result{.op = static_cast<opcode>(code[offset]), .operands = {0, 0}, .next = 0};
+		++offset;
+
+		for (std::size_t i = 0; i < operand_count(result.op); ++i)
+		{
+			const auto operand = decode_unsigned(code, offset);
+			if (!operand.has_value()) { return std::nullopt; }
+			result.operands[i] = *operand;
+		}
+		if (result.op == opcode::push) { result.operands[0] = (result.operands[0] >> 1) ^ (~(result.operands[0] & 1) + 1); }
+
+		result.next = offset;
+		return result;
+	}
+
+	// Calls `function(const instruction&)` for every instruction of `code` in order, false if the code is malformed.
+	template<typename Function>
+	constexpr auto for_each_instruction(const std::span<const std::uint8_t> code, Function&& function) -> bool
+	{
+		for (std::size_t offset = 0; offset != code.size();)
+		{
+			const auto current = decode(code, offset);
+			if (!current.has_value()) { return false; }
+
+			function(*current);
+			offset = current->next;
+		}
+		return true;
+	}
+
+	// Re-encodes `code` at the end of `out`, every operand replaced by `function(opcode, operand position, operand)` (the immediate
+	// of `push` is kept as it is), false if the code is malformed (`out` then holds the part before the error).
+	template<typename Function>
+	auto rewrite_operands(const std::span<const std::uint8_t> code, code_type& out, Function&& function) -> bool
+	{
+		return for_each_instruction(
+				code,
+				[&](const instruction& current)
+				{
+					if (current.op == opcode::push) { return emit_push(out, current.immediate()); }
+
+					emit(out, current.op);
+					for (std::size_t i = 0; i < operand_count(current.op); ++i) { emit_unsigned(out, function(current.op, i, current.operands[i])); }
+				});
+	}
+}
@@ -0,0 +1,210 @@
+#pragma once
+
+#include <CMakeTemplateProject/backend.hpp>
+#include <CMakeTemplateProject/mapped_file.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <variant>
+#include <vector>
+
+namespace backend
+{
+	// On-disk layout of a compiled module.
+	// Everything is stored in native byte order, naturally aligned and addressed by offsets from the start of the image,
+	// so that a mapped image can be used in place.
+	//
+	// header | function_record[] | global_record[] | data_segment[] | block_record[] | strings | data
+	//
+	// The data of a global is not expanded, it is stored as the segment tree of its `data_type`.
+	// The code of the blocks is stored in the data pool as it is, see bytecode.hpp.
+	namespace image
+	{
+		constexpr std::array<char, 8> magic{'C', 'T', 'P', 'M', 'O', 'D', '\0', '\0'};
+		// bump it whenever the layout changes
+		constexpr std::uint32_t version = 4;
+		// reads back as something else on a machine with another byte order
+		constexpr std::uint32_t byte_order_mark = 0x0102'0304;
+
+		// [offset, offset + size) in the string pool
+		struct string_ref
+		{
+			std::uint32_t offset;
+			std::uint32_t size;
+		};
+
+		struct header
+		{
+			std::array<char, 8> magic;
+			std::uint32_t version;
+			std::uint32_t byte_order_mark;
+
+			// the source this image was compiled from
+			std::uint64_t source_hash;
+			std::uint64_t source_size;
+
+			string_ref module_name;
+
+			std::uint32_t function_count;
+			std::uint32_t global_count;
+			std::uint32_t block_count;
+			std::uint32_t segment_count;
+
+			std::uint64_t functions_offset;
+			std::uint64_t globals_offset;
+			std::uint64_t segments_offset;
+			std::uint64_t blocks_offset;
+			std::uint64_t strings_offset;
+			std::uint64_t strings_size;
+			std::uint64_t data_offset;
+			std::uint64_t data_size;
+			std::uint64_t image_size;
+		};
+
+		struct function_record
+		{
+			string_ref name;
+			Function::signature::size_type input;
+			Function::signature::size_type output;
+			std::uint16_t reserved;
+			// the blocks of a function are stored next to each other
+			std::uint32_t first_block;
+			std::uint32_t block_count;
+			// the names of the locals are not stored, their slots are all an executor needs
+			std::uint32_t local_count;
+		};
+
+		struct global_record
+		{
+			string_ref name;
+			// Global::kind_type
+			std::uint32_t kind;
+			// the top level segments of the data are stored next to each other
+			std::uint32_t first_segment;
+			std::uint32_t segment_count;
+			// expanded size
+			std::uint64_t data_size;
+		};
+
+		// data_type::segment
+		struct data_segment
+		{
+			// [offset, offset + size) in the data pool, empty for a nested segment
+			std::uint64_t bytes_offset;
+			std::uint64_t bytes_size;
+			std::uint64_t count;
+			// the segments of a nested pattern, always stored after their parent
+			std::uint32_t first_child;
+			std::uint32_t child_count;
+		};
+
+		struct block_record
+		{
+			std::uint32_t function;
+			Function::signature::size_type input;
+			Function::signature::size_type output;
+			std::uint16_t reserved;
+			// [offset, offset + size) in the data pool
+			std::uint64_t code_offset;
+			std::uint64_t code_size;
+		};
+
+		static_assert(std::is_trivially_copyable_v<header> && sizeof(header) == 128);
+		static_assert(std::is_trivially_copyable_v<function_record> && sizeof(function_record) == 24);
+		static_assert(std::is_trivially_copyable_v<global_record> && sizeof(global_record) == 32);
+		static_assert(std::is_trivially_copyable_v<data_segment> && sizeof(data_segment) == 32);
+		static_assert(std::is_trivially_copyable_v<block_record> && sizeof(block_record) == 24);
+	}
+
+	// Serializes `mod` into an image, `source_hash` and `source_size` identify the text it was parsed from.
+	[[nodiscard]] auto serialize(const Module& mod, std::uint64_t source_hash, std::uint64_t source_size) -> std::vector<std::byte>;
+
+	// A read-only view of an image, either mapped from disk or held in memory.
+	// Nothing is deserialized, names and data are handed out as views into the image.
+	class CompiledModule final
+	{
+	public:
+		using size_type = std::size_t;
+
+	private:
+		std::variant<io::MappedFile, std::vector<std::byte>> storage_;
+		std::span<const std::byte> bytes_;
+
+		CompiledModule() = default;
+
+		// checks the header, the bounds of every section and every reference
+		[[nodiscard]] auto validate() const -> bool;
+
+		[[nodiscard]] auto data(std::span<const image::data_segment> segments) const -> data_type;
+
+		template<typename T>
+		[[nodiscard]] auto section(const std::uint64_t offset, const std::uint32_t count) const noexcept -> std::span<const T>
+		{
+			return {reinterpret_cast<const T*>(bytes_.data() + offset), count};
+		}
+
+	public:
+		// nullopt if the file does not exist or is not a valid image (of this version)
+		[[nodiscard]] static auto open(const char* path) -> std::optional<CompiledModule>;
+
+		[[nodiscard]] static auto from_bytes(std::vector<std::byte>&& bytes) -> std::optional<CompiledModule>;
+
+		[[nodiscard]] auto header() const noexcept -> const image::header& { return *reinterpret_cast<const image::header*>(bytes_.data()); }
+
+		[[nodiscard]] auto source_hash() const noexcept -> std::uint64_t { return header().source_hash; }
+
+		[[nodiscard]] auto source_size() const noexcept -> std::uint64_t { return header().source_size; }
+
+		[[nodiscard]] auto module_name() const noexcept -> std::string_view { return string(header().module_name); }
+
+		[[nodiscard]] auto functions() const noexcept -> std::span<const image::function_record> { return section<image::function_record>(header().functions_offset, header().function_count); }
+
+		[[nodiscard]] auto globals() const noexcept -> std::span<const image::global_record> { return section<image::global_record>(header().globals_offset, header().global_count); }
+
+		[[nodiscard]] auto segments() const noexcept -> std::span<const image::data_segment> { return section<image::data_segment>(header().segments_offset, header().segment_count); }
+
+		[[nodiscard]] auto segments_of(const image::global_record& global) const noexcept -> std::span<const image::data_segment> { return segments().subspan(global.first_segment, global.segment_count); }
+
+		[[nodiscard]] auto children_of(const image::data_segment& segment) const noexcept -> std::span<const image::data_segment> { return segments().subspan(segment.first_child, segment.child_count); }
+
+		[[nodiscard]] auto blocks() const noexcept -> std::span<const image::block_record> { return section<image::block_record>(header().blocks_offset, header().block_count); }
+
+		[[nodiscard]] auto blocks_of(const image::function_record& function) const noexcept -> std::span<const image::block_record> { return blocks().subspan(function.first_block, function.block_count); }
+
+		[[nodiscard]] auto code(const image::block_record& block) const noexcept -> std::span<const std::uint8_t>
+		{
+			return {reinterpret_cast<const std::uint8_t*>(bytes_.data() + header().data_offset + block.code_offset), static_cast<size_type>(block.code_size)};
+		}
+
+		[[nodiscard]] auto string(const image::string_ref ref) const noexcept -> std::string_view
+		{
+			return {reinterpret_cast<const char*>(bytes_.data() + header().strings_offset + ref.offset), ref.size};
+		}
+
+		// the literal bytes of a segment (repeated `count` times)
+		[[nodiscard]] auto pattern(const image::data_segment& segment) const noexcept -> std::string_view
+		{
+			return {reinterpret_cast<const char*>(bytes_.data() + header().data_offset + segment.bytes_offset), static_cast<size_type>(segment.bytes_size)};
+		}
+
+		[[nodiscard]] auto data(const image::global_record& global) const -> data_type;
+
+		// the data of `global`, fully expanded
+		[[nodiscard]] auto expand(const image::global_record& global) const -> std::string;
+
+		// the whole image, e.g. to write it out
+		[[nodiscard]] auto bytes() const noexcept -> std::span<const std::byte> { return bytes_; }
+
+		// Builds a regular module out of the image, for the consumers that need the objects.
+		[[nodiscard]] auto load() const -> std::unique_ptr<Module>;
+	};
+
+	// Writes the image next to `path` first and renames it, so that readers never see a partial file.
+	auto write_compiled_module(std::span<const std::byte> image, const char* path) -> bool;
+}
@@ -0,0 +1,147 @@
+#pragma once
+
+#include <CMakeTemplateProject/backend.hpp>
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+namespace backend
+{
+	// The parts of the ELF64 format (System V gABI) a relocatable object with data needs.
+	namespace elf
+	{
+		constexpr std::array<std::uint8_t, 4> magic{0x7f, 'E', 'L', 'F'};
+
+		// e_ident
+		constexpr std::size_t ident_class = 4;
+		constexpr std::size_t ident_data = 5;
+		constexpr std::size_t ident_version = 6;
+		constexpr std::uint8_t class_64 = 2;
+		constexpr std::uint8_t data_little_endian = 1;
+		constexpr std::uint8_t data_big_endian = 2;
+		constexpr std::uint8_t current_version = 1;
+
+		// e_type
+		constexpr std::uint16_t type_relocatable = 1;
+
+		// e_machine, the data does not depend on it but the linker only takes objects of its own machine
+		constexpr std::uint16_t machine_none = 0;
+		constexpr std::uint16_t machine_x86_64 = 62;
+		constexpr std::uint16_t machine_aarch64 = 183;
+		constexpr std::uint16_t machine_riscv = 243;
+
+		#if defined(__x86_64__) || defined(_M_X64)
+		constexpr std::uint16_t native_machine = machine_x86_64;
+		#elif defined(__aarch64__) || defined(_M_ARM64)
+		constexpr std::uint16_t native_machine = machine_aarch64;
+		#elif defined(__riscv) && __riscv_xlen == 64
+		constexpr std::uint16_t native_machine = machine_riscv;
+		#else
+		constexpr std::uint16_t native_machine = machine_none;
+		#endif
+
+		// sh_type
+		constexpr std::uint32_t section_null = 0;
+		constexpr std::uint32_t section_progbits = 1;
+		constexpr std::uint32_t section_symtab = 2;
+		constexpr std::uint32_t section_strtab = 3;
+		// occupies no bytes in the file, zero when loaded
+		constexpr std::uint32_t section_nobits = 8;
+
+		// sh_flags
+		constexpr std::uint64_t flag_write = 0x1;
+		constexpr std::uint64_t flag_alloc = 0x2;
+
+		// st_info
+		constexpr std::uint8_t bind_local = 0;
+		constexpr std::uint8_t bind_global = 1;
+		constexpr std::uint8_t symbol_object = 1;
+		constexpr std::uint8_t symbol_file = 4;
+
+		[[nodiscard]] constexpr auto symbol_info(const std::uint8_t bind, const std::uint8_t type) noexcept -> std::uint8_t { return static_cast<std::uint8_t>(bind << 4 | (type & 0xf)); }
+
+		// st_shndx of a symbol that is not in a section
+		constexpr std::uint16_t section_index_absolute = 0xfff1;
+
+		struct file_header
+		{
+			std::array<std::uint8_t, 16> ident;
+			std::uint16_t type;
+			std::uint16_t machine;
+			std::uint32_t version;
+			std::uint64_t entry;
+			std::uint64_t program_headers_offset;
+			std::uint64_t section_headers_offset;
+			std::uint32_t flags;
+			std::uint16_t header_size;
+			std::uint16_t program_header_size;
+			std::uint16_t program_header_count;
+			std::uint16_t section_header_size;
+			std::uint16_t section_header_count;
+			// the section holding the section names
+			std::uint16_t names_section;
+		};
+
+		struct section_header
+		{
+			// offset in the section names
+			std::uint32_t name;
+			std::uint32_t type;
+			std::uint64_t flags;
+			std::uint64_t address;
+			std::uint64_t offset;
+			std::uint64_t size;
+			std::uint32_t link;
+			std::uint32_t info;
+			std::uint64_t alignment;
+			std::uint64_t entry_size;
+		};
+
+		struct symbol
+		{
+			// offset in the symbol names
+			std::uint32_t name;
+			std::uint8_t info;
+			std::uint8_t other;
+			std::uint16_t section;
+			// offset in its section
+			std::uint64_t value;
+			std::uint64_t size;
+		};
+
+		static_assert(std::is_trivially_copyable_v<file_header> && sizeof(file_header) == 64);
+		static_assert(std::is_trivially_copyable_v<section_header> && sizeof(section_header) == 64);
+		static_assert(std::is_trivially_copyable_v<symbol> && sizeof(symbol) == 24);
+
+		// The sections of an object written by write_elf_object, always all of them and in this order.
+		enum class section_index : std::uint16_t
+		{
+			null,
+			// mutable globals
+			data,
+			// immutable globals
+			rodata,
+			// mutable globals that are all zero
+			bss,
+			symtab,
+			strtab,
+			shstrtab,
+			// marks the object as not needing an executable stack
+			note_gnu_stack,
+		};
+
+		constexpr std::size_t section_count = static_cast<std::size_t>(section_index::note_gnu_stack) + 1;
+	}
+
+	// Writes the globals of `mod` into an ELF64 relocatable object (of the byte order and machine of the host), ready for the linker.
+	// Every global gets a global symbol named after its identifier (without the `@`), aligned to 8 bytes like the interpreter places them.
+	// Mutable globals go to .data and immutable ones to .rodata, except that mutable globals which are all zero go to .bss and cost
+	// nothing in the file however large they are.
+	// Immutable globals that share their data (see DataPool) are symbols at the same place, the data is written once.
+	// ELF cannot keep a repetition unexpanded in a loaded section, other repeated data is expanded chunk by chunk straight into the object.
+	// Functions are not written, they have no machine code.
+	[[nodiscard]] auto write_elf_object(const Module& mod) -> std::vector<std::byte>;
+}
@@ -1,8 +1,167 @@
 #pragma once
 
+#include <CMakeTemplateProject/backend.hpp>
+#include <CMakeTemplateProject/compiled_module.hpp>
+
+#include <cstddef>
+#include <filesystem>
+#include <limits>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string>
 #include <string_view>
+#include <vector>
+
+namespace concurrency
+{
+	class ThreadPool;
+}
 
 namespace frontend
 {
+	// keep every error of a file
+	constexpr std::size_t no_error_limit = std::numeric_limits<std::size_t>::max();
+
+	struct ParseResult
+	{
+		std::string filename;
+		// null if the file could not be read or parsed
+		std::unique_ptr<backend::Module> module;
+		// rendered diagnostics, empty if there are none
+		std::string diagnostics;
+		std::size_t error_count;
+
+		[[nodiscard]] auto succeeded() const noexcept -> bool { return module != nullptr && error_count == 0; }
+	};
+
+	// Parses one file on the calling thread, the diagnostics are collected instead of printed.
+	// Only the first `max_errors` errors are rendered, the others are still counted.
+	auto parse_file(std::string_view filename, std::size_t max_errors = no_error_limit) -> ParseResult;
+
+	// Same as above, on a source already in memory (copied), `filename` is only used by the diagnostics.
+	auto parse_source(std::string_view filename, std::u8string_view source, std::size_t max_errors = no_error_limit) -> ParseResult;
+
+	// Parses every file (each one with its own state) on the pool.
+	// The results are in the same order as `filenames`, whatever order the files finished in.
+	auto parse_files(std::span<const std::string> filenames, concurrency::ThreadPool& pool, std::size_t max_errors = no_error_limit) -> std::vector<ParseResult>;
+
+	// Same as above, on a pool sized to the core count.
+	auto parse_files(std::span<const std::string> filenames, std::size_t max_errors = no_error_limit) -> std::vector<ParseResult>;
+
+	// Parses one (big) file using the whole pool, the functions are parsed in parallel.
+	// The module is the same as the one of `parse_file`, but the diagnostics of the function bodies come after the other ones.
+	auto parse_file_parallel(std::string_view filename, concurrency::ThreadPool& pool, std::size_t max_errors = no_error_limit) -> ParseResult;
+
+	// Writes the diagnostics of every result to stderr, file by file (in order) so that they never interleave.
+	auto print_diagnostics(std::span<const ParseResult> results) -> void;
+
 	auto parse_file_and_print(std::string_view filename) -> void;
+
+	struct CachedParseResult
+	{
+		std::string filename;
+		// nullopt if the file could not be read or parsed
+		std::optional<backend::CompiledModule> module;
+		// rendered diagnostics, empty if there are none (always empty on a cache hit)
+		std::string diagnostics;
+		std::size_t error_count;
+		// the module was mapped from the cache, the source was not parsed
+		bool cache_hit;
+
+		[[nodiscard]] auto succeeded() const noexcept -> bool { return module.has_value() && error_count == 0; }
+	};
+
+	// Compiled modules keyed by a hash of their source, stored as `<directory>/<hash>.ctpm`.
+	// Only modules parsed without any error are stored.
+	class ModuleCache final
+	{
+	public:
+		explicit ModuleCache(std::filesystem::path directory);
+
+		// Maps the compiled module of `filename` if its source did not change, otherwise parses it and updates the cache.
+		auto parse_file(std::string_view filename) const -> CachedParseResult;
+
+	private:
+		std::filesystem::path directory_;
+	};
+
+	// Keeps the module and the outcome of every top-level declaration between calls.
+	// Each `global`/`function` declaration is hashed, and on the next call only the declarations whose text changed are parsed again,
+	// the others are copied from the previous module (their code renumbered), so the module is the same as the one of a full parse.
+	// An unchanged declaration that depends on a symbol which is gone or changed its signature is parsed again too, to report the error.
+	class IncrementalParser final
+	{
+	public:
+		struct statistics
+		{
+			std::size_t reused;
+			std::size_t parsed;
+			// the outline of the module could not be found (or the header changed), everything was parsed
+			bool full_parse;
+		};
+
+	private:
+		struct state_type;
+
+		std::unique_ptr<state_type> state_;
+
+	public:
+		explicit IncrementalParser(std::string filename, std::size_t max_errors = no_error_limit);
+
+		IncrementalParser(const IncrementalParser&) = delete;
+		IncrementalParser& operator=(const IncrementalParser&) = delete;
+		IncrementalParser(IncrementalParser&&) noexcept;
+		IncrementalParser& operator=(IncrementalParser&&) noexcept;
+		~IncrementalParser() noexcept;
+
+		// `source` is the whole (new) text of the module.
+		auto parse(std::u8string_view source) -> statistics;
+
+		// null if the last parse failed
+		[[nodiscard]] auto module() const noexcept -> const backend::Module*;
+
+		// diagnostics of the last parse only
+		[[nodiscard]] auto diagnostics() const noexcept -> std::string_view;
+
+		[[nodiscard]] auto error_count() const noexcept -> std::size_t;
+	};
+
+	// Parses the globals and the function headers of a module only, and remembers where the body of every function is.
+	// A body is parsed the first time it is asked for, so the symbols and signatures of a module cost about as much as the outline.
+	class LazyModule final
+	{
+		struct state_type;
+
+		std::unique_ptr<state_type> state_;
+
+		explicit LazyModule(std::unique_ptr<state_type> state) noexcept;
+
+	public:
+		[[nodiscard]] static auto open(std::string_view filename, std::size_t max_errors = no_error_limit) -> LazyModule;
+
+		LazyModule(const LazyModule&) = delete;
+		LazyModule& operator=(const LazyModule&) = delete;
+		LazyModule(LazyModule&&) noexcept;
+		LazyModule& operator=(LazyModule&&) noexcept;
+		~LazyModule() noexcept;
+
+		// Null if the file could not be read or parsed.
+		// The functions have no locals and blocks until their body is parsed.
+		[[nodiscard]] auto module() const noexcept -> const backend::Module*;
+
+		// Parses the body of every declaration of `function` not parsed yet.
+		// False if there is no such function or its body has errors, the module is not usable anymore after a body that could not be parsed at all.
+		auto parse_body(std::string_view function) -> bool;
+
+		// Parses every body not parsed yet.
+		auto parse_bodies() -> bool;
+
+		// Whether the bodies of `function` were parsed (also true for an unknown function).
+		[[nodiscard]] auto body_parsed(std::string_view function) const -> bool;
+
+		[[nodiscard]] auto diagnostics() const noexcept -> std::string_view;
+
+		[[nodiscard]] auto error_count() const noexcept -> std::size_t;
+	};
 }
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace hashing
+{
+	// A 64-bit hash of raw bytes that gives the same result across runs, builds and platforms (unlike std::hash),
+	// so it can be stored and compared later. It consumes 8 bytes per step.
+	// Not cryptographic.
+	[[nodiscard]] inline auto stable_hash(const void* data, const std::size_t size, const std::uint64_t seed = 0) noexcept -> std::uint64_t
+	{
+		constexpr std::uint64_t k1 = 0x87c3'7b91'1142'53d5ull;
+		constexpr std::uint64_t k2 = 0x4cf5'ad43'2745'937full;
+
+		const auto mix = [](std::uint64_t word) noexcept -> std::uint64_t
+		{
+			word *= k1;
+			word = std::rotl(word, 31);
+			word *= k2;
+			return word;
+		};
+
+		const auto* bytes = static_cast<const unsigned char*>(data);
+		auto h = seed ^ (size * k2);
+
+		std::size_t i = 0;
+		for (; i + 8 <= size; i += 8)
+		{
+			std::uint64_t word;
+			std::memcpy(&word, bytes + i, sizeof(word));
+			if constexpr (std::endian::native == std::endian::big) { word = std::byteswap(word); }
+
+			h ^= mix(word);
+			h = std::rotl(h, 27) * 5 + 0x52dc'e729;
+		}
+
+		if (i != size)
+		{
+			std::uint64_t tail = 0;
+			for (std::size_t j = 0; i + j < size; ++j) { tail |= static_cast<std::uint64_t>(bytes[i + j]) << (8 * j); }
+			h ^= mix(tail);
+		}
+
+		// finalizer of murmur3
+		h ^= h >> 33;
+		h *= 0xff51'afd7'ed55'8ccdull;
+		h ^= h >> 33;
+		h *= 0xc4ce'b9fe'1a85'ec53ull;
+		h ^= h >> 33;
+		return h;
+	}
+
+	[[nodiscard]] inline auto stable_hash(const std::string_view data, const std::uint64_t seed = 0) noexcept -> std::uint64_t { return stable_hash(data.data(), data.size(), seed); }
+}
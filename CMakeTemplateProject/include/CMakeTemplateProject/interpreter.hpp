@@ -0,0 +1,201 @@
+#pragma once
+
+#include <CMakeTemplateProject/backend.hpp>
+#include <CMakeTemplateProject/jit.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace execution
+{
+	using value_type = std::int64_t;
+
+	enum class trap_type : std::uint8_t
+	{
+		none,
+		// no function with that index/name
+		unknown_function,
+		// declared but never defined
+		undefined_function,
+		// the arguments (or the room for the results) do not match the signature of the function
+		signature_mismatch,
+		// a block popped more values than it was given
+		stack_underflow,
+		stack_overflow,
+		// a block did not leave as many values as its signature says
+		stack_mismatch,
+		call_depth_exceeded,
+		// $load/$store outside of the globals
+		out_of_bounds,
+		// $store into an immutable global
+		read_only,
+		division_by_zero,
+		// an operand out of range, the module was not built by the frontend
+		invalid_code,
+	};
+
+	[[nodiscard]] auto trap_message(trap_type trap) noexcept -> std::string_view;
+
+	struct limits_type
+	{
+		// values
+		std::size_t stack_size = 64 * 1024;
+		// values, the locals of every function being called
+		std::size_t locals_size = 64 * 1024;
+		// nested function and block calls
+		std::size_t call_depth = 16 * 1024;
+		// calls of a function before it is compiled to machine code (verified modules on x86-64 Linux only, see CTP_JIT), 0 never compiles
+		std::size_t jit_threshold = 1000;
+	};
+
+	// Runs the functions of a module in-process.
+	// The bytecode of every block is translated once into a stream of cells (direct threading: each operation is the address of its handler,
+	// followed by its operands already resolved into pointers), so running an instruction is one indirect jump and no decoding.
+	// Compilers without computed goto fall back to a switch over the same stream.
+	//
+	// Execution is tiered: once a function of a verified module has been called `jit_threshold` times, its blocks are compiled to x86-64
+	// machine code in executable pages and its later calls (from the interpreter, from other compiled functions or from `call`) run
+	// that code instead. Machine code and interpreted code call each other freely and trap the same way.
+	//
+	// The stack discipline is the one of the signatures: a block (or function) takes its `input` values from the top of the stack,
+	// may not pop below them, and must leave exactly `output` values when it ends.
+	//
+	// The globals are copied into memory of the interpreter (`$load`/`$store` work on their addresses), the module is not needed afterwards.
+	// An interpreter is not thread-safe, use one per thread.
+	class Interpreter final
+	{
+	public:
+		using size_type = std::size_t;
+
+	private:
+		struct function_info;
+
+		union cell
+		{
+			// threaded dispatch
+			const void* handler;
+			// switch dispatch
+			std::uintptr_t operation;
+
+			value_type immediate;
+			std::uint64_t index;
+			const cell* target;
+			function_info* function;
+		};
+
+		// base (the arguments, then the results), locals, self, depth => trap_type
+		using native_function = std::uint32_t (*)(value_type* base, value_type* locals, Interpreter* self, size_type depth);
+
+		struct function_info
+		{
+			backend::Function::signature sig;
+			backend::slot_type local_count;
+			// the entry block, null for a function without body
+			const cell* entry;
+			// one past the last cell of its last block
+			const cell* end;
+			// calls so far, until it is compiled
+			size_type calls;
+			// the compiled code, null while it is interpreted
+			native_function native;
+		};
+
+		// a function or block being run
+		struct control_record
+		{
+			const cell* return_to;
+			// the lowest value the caller may pop
+			value_type* caller_floor;
+			// where the top of the stack must be when the block ends
+			value_type* expected_top;
+			// the locals of the caller if this is a function call, null for a block of the same function
+			value_type* caller_locals;
+		};
+
+		limits_type limits_;
+
+		std::vector<function_info> functions_;
+		std::unordered_map<std::string, backend::index_type> function_names_;
+
+		// the first cell halts
+		std::vector<cell> code_;
+		// the operation of each cell of `code_` (0 for operands), only kept for code that may be compiled
+		std::vector<std::uint8_t> operations_;
+
+		// the mutable globals first, then the immutable ones, each one aligned to 8 bytes
+		std::vector<std::byte> memory_;
+		size_type mutable_size_;
+		// index => [offset, offset + size) in `memory_`
+		std::vector<std::pair<size_type, size_type>> globals_;
+
+		std::vector<value_type> stack_;
+		std::vector<value_type> locals_;
+		std::vector<control_record> control_;
+		// the first record a function called from machine code may use
+		control_record* control_top_;
+
+		std::vector<jit::ExecutableMemory> native_code_;
+
+		auto translate(const backend::Module& mod) -> void;
+
+		// the stack effects of every function were verified, the code runs without stack checks
+		bool verified_;
+
+		// where a call starts: its arguments, the first free local, the first free record and how many calls it may still nest
+		struct frame
+		{
+			value_type* base;
+			value_type* locals;
+			control_record* control;
+			size_type depth;
+		};
+
+		// `self == nullptr` only publishes the handlers of the threaded dispatch
+		template<bool Checked>
+		static auto execute(Interpreter* self, const function_info* function, frame at) -> trap_type;
+
+		// Calls a function of a verified module in its current tier, and compiles it once it is hot.
+		auto run(function_info& function, frame at) -> trap_type;
+		auto run_native(const function_info& function, frame at) -> trap_type;
+		// what the machine code calls for `call`
+		static auto native_call(Interpreter* self, function_info* callee, value_type* base, size_type depth, value_type* locals) -> std::uint32_t;
+		// false if the function cannot be compiled, it then stays interpreted
+		auto compile(function_info& function) -> bool;
+
+	public:
+		explicit Interpreter(const backend::Module& mod, limits_type limits = {});
+
+		// the cells point into each other, they stay valid when moved
+		Interpreter(const Interpreter&) = delete;
+		Interpreter& operator=(const Interpreter&) = delete;
+		Interpreter(Interpreter&&) noexcept = default;
+		Interpreter& operator=(Interpreter&&) noexcept = default;
+		~Interpreter() noexcept = default;
+
+		// the index of the function (backend::Function::index), nullopt if there is none
+		[[nodiscard]] auto find(std::string_view function) const -> std::optional<backend::index_type>;
+
+		// Calls `function` with `arguments` (exactly `sig.input` values, the last one on top) and writes its `sig.output` results into `results`.
+		// The results are unspecified if the call traps.
+		auto call(backend::index_type function, std::span<const value_type> arguments, std::span<value_type> results) -> trap_type;
+
+		auto call(std::string_view function, std::span<const value_type> arguments, std::span<value_type> results) -> trap_type;
+
+		// Whether every function honours its signature (see backend::verifier), checked once when the module is translated.
+		// The code of a verified module runs without the stack checks of each instruction, the traps about the stack
+		// (stack_underflow, stack_mismatch) only happen for a module that does not verify.
+		[[nodiscard]] auto verified() const noexcept -> bool { return verified_; }
+
+		// whether `function` runs as machine code
+		[[nodiscard]] auto compiled(backend::index_type function) const noexcept -> bool;
+
+		// the current content of a global
+		[[nodiscard]] auto global(backend::index_type index) const noexcept -> std::span<const std::byte>;
+	};
+}
@@ -0,0 +1,205 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+// machine code is only generated on x86-64 Linux, everywhere else every function stays interpreted
+#if defined(__x86_64__) && defined(__linux__) && !defined(CTP_DISABLE_JIT)
+	#define CTP_JIT 1
+#else
+	#define CTP_JIT 0
+#endif
+
+namespace execution::jit
+{
+	// Pages of machine code.
+	// The code is copied in while they are only writable, then they become only readable and executable (never both at once).
+	class ExecutableMemory final
+	{
+	public:
+		using size_type = std::size_t;
+
+	private:
+		void* data_;
+		size_type size_;
+
+		ExecutableMemory(void* data, const size_type size) noexcept
+			: data_{data},
+			size_{size} {}
+
+		auto unmap() noexcept -> void;
+
+	public:
+		ExecutableMemory() noexcept
+			: data_{nullptr},
+			size_{0} {}
+
+		// empty if the pages cannot be mapped (or on a platform without CTP_JIT)
+		[[nodiscard]] static auto make(std::span<const std::uint8_t> code) noexcept -> ExecutableMemory;
+
+		ExecutableMemory(const ExecutableMemory&) = delete;
+		ExecutableMemory& operator=(const ExecutableMemory&) = delete;
+
+		ExecutableMemory(ExecutableMemory&& other) noexcept
+			: data_{std::exchange(other.data_, nullptr)},
+			size_{std::exchange(other.size_, 0)} {}
+
+		ExecutableMemory& operator=(ExecutableMemory&& other) noexcept
+		{
+			if (this != &other)
+			{
+				unmap();
+				data_ = std::exchange(other.data_, nullptr);
+				size_ = std::exchange(other.size_, 0);
+			}
+			return *this;
+		}
+
+		~ExecutableMemory() noexcept { unmap(); }
+
+		[[nodiscard]] explicit operator bool() const noexcept { return data_ != nullptr; }
+
+		[[nodiscard]] auto data() const noexcept -> const void* { return data_; }
+
+		[[nodiscard]] auto size() const noexcept -> size_type { return size_; }
+	};
+
+	enum class reg : std::uint8_t
+	{
+		rax,
+		rcx,
+		rdx,
+		rbx,
+		rsp,
+		rbp,
+		rsi,
+		rdi,
+		r8,
+		r9,
+		r10,
+		r11,
+		r12,
+		r13,
+		r14,
+		r15,
+	};
+
+	// the condition codes, in encoding order
+	enum class condition : std::uint8_t
+	{
+		overflow,
+		no_overflow,
+		below,
+		above_equal,
+		equal,
+		not_equal,
+		below_equal,
+		above,
+		sign,
+		no_sign,
+		parity,
+		no_parity,
+		less,
+		greater_equal,
+		less_equal,
+		greater,
+	};
+
+	// The opcodes of the two-operand integer instructions whose source may be memory (`dst op= src`).
+	enum class arithmetic : std::uint8_t
+	{
+		add = 0x03,
+		bit_or = 0x0b,
+		bit_and = 0x23,
+		sub = 0x2b,
+		bit_xor = 0x33,
+		cmp = 0x3b,
+	};
+
+	// Encodes the few x86-64 instructions the compiler of the interpreter needs.
+	// Every operation is 64-bit unless its name says otherwise, every memory operand is [base + disp32].
+	// Jumps and calls go to labels, which are bound to the current position once it is known.
+	class Assembler final
+	{
+	public:
+		using label = std::size_t;
+
+	private:
+		std::vector<std::uint8_t> code_;
+		// label => offset, npos while unbound
+		std::vector<std::size_t> labels_;
+		// (offset of a rel32, label)
+		std::vector<std::pair<std::size_t, label>> fixups_;
+
+		auto byte(std::uint8_t value) -> void;
+		auto dword(std::uint32_t value) -> void;
+		auto qword(std::uint64_t value) -> void;
+		// REX prefix, omitted when it would be empty and `wide` is false
+		auto rex(bool wide, std::uint8_t reg_field, std::uint8_t index, std::uint8_t base) -> void;
+		// ModRM (+ SIB) + disp32 of [base + disp]
+		auto memory(std::uint8_t reg_field, reg base, std::int32_t disp) -> void;
+		// opcode with a register operand in the ModRM reg field (or an opcode extension) and a register r/m
+		auto register_form(bool wide, std::uint8_t opcode, std::uint8_t reg_field, reg rm) -> void;
+		auto memory_form(std::uint8_t opcode, std::uint8_t reg_field, reg base, std::int32_t disp) -> void;
+		auto rel32(label target) -> void;
+
+	public:
+		[[nodiscard]] auto new_label() -> label;
+		auto bind(label target) -> void;
+
+		// dst = src
+		auto mov(reg dst, reg src) -> void;
+		auto mov(reg dst, std::uint64_t immediate) -> void;
+		// dst = [base + disp]
+		auto load(reg dst, reg base, std::int32_t disp) -> void;
+		// [base + disp] = src
+		auto store(reg base, std::int32_t disp, reg src) -> void;
+		// dst = [base + index]
+		auto load_indexed(reg dst, reg base, reg index) -> void;
+		// [base + index] = src
+		auto store_indexed(reg base, reg index, reg src) -> void;
+		// dst = base + disp
+		auto lea(reg dst, reg base, std::int32_t disp) -> void;
+
+		// dst op= [base + disp]
+		auto compute(arithmetic op, reg dst, reg base, std::int32_t disp) -> void;
+		// dst op= src
+		auto compute(arithmetic op, reg dst, reg src) -> void;
+		// dst op= sign-extended immediate
+		auto compute(arithmetic op, reg dst, std::int8_t immediate) -> void;
+		// dst *= [base + disp]
+		auto imul(reg dst, reg base, std::int32_t disp) -> void;
+		auto test(reg lhs, reg rhs) -> void;
+		// the 32-bit registers, the upper halves are not looked at
+		auto test32(reg lhs, reg rhs) -> void;
+		auto neg(reg value) -> void;
+		auto inc(reg value) -> void;
+		auto dec(reg value) -> void;
+		// rdx:rax = sign-extended rax
+		auto cqo() -> void;
+		// rax = rdx:rax / divisor, rdx = rdx:rax % divisor
+		auto idiv(reg divisor) -> void;
+		// value <<= cl
+		auto shl_cl(reg value) -> void;
+		// value >>= cl, arithmetic
+		auto sar_cl(reg value) -> void;
+		// rax = flags satisfy `when` ? 1 : 0
+		auto set(condition when) -> void;
+		// the 32-bit register, zero-extended
+		auto mov32(reg dst, std::uint32_t immediate) -> void;
+
+		auto push(reg value) -> void;
+		auto pop(reg value) -> void;
+		auto call(label target) -> void;
+		auto call(reg target) -> void;
+		auto jmp(label target) -> void;
+		auto jump_if(condition when, label target) -> void;
+		auto ret() -> void;
+
+		// The code with every jump resolved, empty if a label that is jumped to was never bound.
+		[[nodiscard]] auto finish() -> std::vector<std::uint8_t>;
+	};
+}
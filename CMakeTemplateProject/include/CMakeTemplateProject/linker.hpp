@@ -0,0 +1,54 @@
+#pragma once
+
+#include <CMakeTemplateProject/backend.hpp>
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <span>
+#include <vector>
+
+namespace concurrency
+{
+	class ThreadPool;
+}
+
+namespace backend::linker
+{
+	enum class error_type : std::uint8_t
+	{
+		// a function declared with another signature than its first declaration (as in a single module)
+		conflicting_signature,
+		// a function with a body in more than one module, or a global in more than one module
+		duplicate_definition,
+	};
+
+	struct error
+	{
+		error_type type;
+		// of the module where the second declaration/definition is
+		std::size_t module;
+		symbol_name_type name;
+	};
+
+	struct result
+	{
+		std::unique_ptr<Module> module;
+		// in the order of the modules, then of the declarations in each module
+		std::vector<error> errors;
+		// the functions no module defines, still declared by the linked module
+		std::vector<symbol_name_type> unresolved;
+
+		[[nodiscard]] auto succeeded() const noexcept -> bool { return module != nullptr && errors.empty(); }
+	};
+
+	// Merges `modules` into one module named `name`, the declarations of a function (`function @f [1=>1];`) are resolved to its definition
+	// whichever module it is in.
+	// A symbol takes the place of its first declaration: the functions and globals of the first module come first, in their order,
+	// then the new ones of the second module and so on, the result does not depend on the number of threads.
+	// The symbols of every module are resolved in parallel through a shared symbol table, the code is relocated in parallel too.
+	[[nodiscard]] auto link(std::span<const Module* const> modules, symbol_name_type name, concurrency::ThreadPool& pool) -> result;
+
+	// Same as above, on a pool sized to the core count.
+	[[nodiscard]] auto link(std::span<const Module* const> modules, symbol_name_type name) -> result;
+}
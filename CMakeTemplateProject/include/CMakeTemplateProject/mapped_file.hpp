@@ -0,0 +1,60 @@
+#pragma once
+
+#include <cstddef>
+#include <utility>
+
+namespace io
+{
+	// A read-only, private memory mapping of a whole file.
+	// The content is read straight from the page cache, nothing is copied.
+	class MappedFile final
+	{
+	public:
+		using size_type = std::size_t;
+
+	private:
+		const char* data_;
+		size_type size_;
+		bool valid_;
+
+		auto unmap() noexcept -> void;
+
+	public:
+		MappedFile() noexcept
+			: data_{nullptr},
+			size_{0},
+			valid_{false} {}
+
+		// Maps `path`, check the result with `operator bool`.
+		// An empty file is a valid (empty) mapping.
+		explicit MappedFile(const char* path) noexcept;
+
+		MappedFile(const MappedFile&) = delete;
+		MappedFile& operator=(const MappedFile&) = delete;
+
+		MappedFile(MappedFile&& other) noexcept
+			: data_{std::exchange(other.data_, nullptr)},
+			size_{std::exchange(other.size_, 0)},
+			valid_{std::exchange(other.valid_, false)} {}
+
+		MappedFile& operator=(MappedFile&& other) noexcept
+		{
+			if (this != &other)
+			{
+				unmap();
+				data_ = std::exchange(other.data_, nullptr);
+				size_ = std::exchange(other.size_, 0);
+				valid_ = std::exchange(other.valid_, false);
+			}
+			return *this;
+		}
+
+		~MappedFile() noexcept { unmap(); }
+
+		[[nodiscard]] explicit operator bool() const noexcept { return valid_; }
+
+		[[nodiscard]] auto data() const noexcept -> const char* { return data_; }
+
+		[[nodiscard]] auto size() const noexcept -> size_type { return size_; }
+	};
+}
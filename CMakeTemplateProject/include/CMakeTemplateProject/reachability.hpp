@@ -0,0 +1,36 @@
+#pragma once
+
+#include <CMakeTemplateProject/backend.hpp>
+
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+namespace backend
+{
+	struct reachability_roots
+	{
+		// by name
+		std::vector<symbol_name_type> functions;
+		std::vector<symbol_name_type> globals;
+	};
+
+	struct stripped_module
+	{
+		std::unique_ptr<Module> module;
+
+		std::size_t removed_functions;
+		std::size_t removed_globals;
+		// the blocks of the removed functions, and the blocks of the kept ones that no instruction runs
+		std::size_t removed_blocks;
+
+		// the roots that are not in the module
+		std::vector<symbol_name_type> missing_roots;
+	};
+
+	// Dead symbol elimination: the functions and globals reachable from `roots` through `call` and `address`, and the blocks
+	// reachable from the entry of those functions, are copied into a new module, everything else is left behind.
+	// The indices and slots of the new module are dense again (in the same order), the code is rewritten to use them.
+	// Code that does not decode is copied as it is.
+	[[nodiscard]] auto eliminate_dead_symbols(const Module& mod, const reachability_roots& roots) -> stripped_module;
+}
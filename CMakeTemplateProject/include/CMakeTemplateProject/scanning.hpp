@@ -0,0 +1,127 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+namespace scanning
+{
+	// [a-zA-Z0-9_.]
+	[[nodiscard]] constexpr auto is_identifier_character(const char8_t c) noexcept -> bool
+	{
+		return (static_cast<unsigned char>((c | 0x20) - 'a') < 26) || (static_cast<unsigned char>(c - '0') < 10) || c == '_' || c == '.';
+	}
+
+	// ' ' '\t' '\n' '\v' '\f' '\r' (dsl::ascii::space)
+	[[nodiscard]] constexpr auto is_space(const char8_t c) noexcept -> bool { return c == ' ' || static_cast<unsigned char>(c - '\t') < 5; }
+
+	// Length of the run of identifier characters at `begin`, never reads at or past `end`.
+	// Whole vectors are checked at once, see scanning.cpp.
+	[[nodiscard]] auto identifier_length(const char8_t* begin, const char8_t* end) noexcept -> std::size_t;
+
+	// Length of the run of whitespace and `#` comments (each one up to and including its '\n') at `begin`.
+	// A comment without a '\n' is not part of it.
+	[[nodiscard]] auto whitespace_length(const char8_t* begin, const char8_t* end) noexcept -> std::size_t;
+
+	enum class keyword_type : std::uint8_t
+	{
+		// not a keyword
+		none,
+
+		module_,
+		global,
+		const_,
+		function,
+		local,
+		block,
+		dummy,
+
+		// instructions
+		push,
+		get,
+		set,
+		address,
+		call,
+		if_,
+		else_,
+		loop,
+	};
+
+	[[nodiscard]] constexpr auto keyword_spelling(const keyword_type keyword) noexcept -> std::u8string_view
+	{
+		switch (keyword)
+		{
+			case keyword_type::none: { return u8""; }
+			case keyword_type::module_: { return u8"module"; }
+			case keyword_type::global: { return u8"global"; }
+			case keyword_type::const_: { return u8"const"; }
+			case keyword_type::function: { return u8"function"; }
+			case keyword_type::local: { return u8"local"; }
+			case keyword_type::block: { return u8"block"; }
+			case keyword_type::dummy: { return u8"dummy"; }
+			case keyword_type::push: { return u8"push"; }
+			case keyword_type::get: { return u8"get"; }
+			case keyword_type::set: { return u8"set"; }
+			case keyword_type::address: { return u8"address"; }
+			case keyword_type::call: { return u8"call"; }
+			case keyword_type::if_: { return u8"if"; }
+			case keyword_type::else_: { return u8"else"; }
+			case keyword_type::loop: { return u8"loop"; }
+		}
+		return u8"";
+	}
+
+	// `identifier` is a whole identifier (as scanned by identifier_length), the length alone rules out most candidates.
+	[[nodiscard]] constexpr auto classify_keyword(const std::u8string_view identifier) noexcept -> keyword_type
+	{
+		const auto is = [identifier](const keyword_type keyword) noexcept { return identifier == keyword_spelling(keyword); };
+
+		switch (identifier.size())
+		{
+			case 2: { return is(keyword_type::if_) ? keyword_type::if_ : keyword_type::none; }
+			case 3:
+			{
+				switch (identifier.front())
+				{
+					case u8'g': { return is(keyword_type::get) ? keyword_type::get : keyword_type::none; }
+					case u8's': { return is(keyword_type::set) ? keyword_type::set : keyword_type::none; }
+					default: { return keyword_type::none; }
+				}
+			}
+			case 4:
+			{
+				switch (identifier.front())
+				{
+					case u8'p': { return is(keyword_type::push) ? keyword_type::push : keyword_type::none; }
+					case u8'c': { return is(keyword_type::call) ? keyword_type::call : keyword_type::none; }
+					case u8'e': { return is(keyword_type::else_) ? keyword_type::else_ : keyword_type::none; }
+					case u8'l': { return is(keyword_type::loop) ? keyword_type::loop : keyword_type::none; }
+					default: { return keyword_type::none; }
+				}
+			}
+			case 5:
+			{
+				switch (identifier.front())
+				{
+					case u8'c': { return is(keyword_type::const_) ? keyword_type::const_ : keyword_type::none; }
+					case u8'l': { return is(keyword_type::local) ? keyword_type::local : keyword_type::none; }
+					case u8'b': { return is(keyword_type::block) ? keyword_type::block : keyword_type::none; }
+					case u8'd': { return is(keyword_type::dummy) ? keyword_type::dummy : keyword_type::none; }
+					default: { return keyword_type::none; }
+				}
+			}
+			case 6:
+			{
+				switch (identifier.front())
+				{
+					case u8'm': { return is(keyword_type::module_) ? keyword_type::module_ : keyword_type::none; }
+					case u8'g': { return is(keyword_type::global) ? keyword_type::global : keyword_type::none; }
+					default: { return keyword_type::none; }
+				}
+			}
+			case 7: { return is(keyword_type::address) ? keyword_type::address : keyword_type::none; }
+			case 8: { return is(keyword_type::function) ? keyword_type::function : keyword_type::none; }
+			default: { return keyword_type::none; }
+		}
+	}
+}
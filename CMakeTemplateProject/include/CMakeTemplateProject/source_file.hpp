@@ -0,0 +1,39 @@
+#pragma once
+
+#include <CMakeTemplateProject/mapped_file.hpp>
+
+#include <lexy/encoding.hpp>
+#include <lexy/input/buffer.hpp>
+
+#include <cstddef>
+#include <optional>
+#include <variant>
+
+namespace io
+{
+	// The text of a source file: mapped if possible, read otherwise (pipes, special files...).
+	// A leading UTF-8 byte order mark is not part of the text, as with lexy::read_file.
+	class SourceFile final
+	{
+	public:
+		using char_type = char8_t;
+		using size_type = std::size_t;
+
+	private:
+		std::variant<MappedFile, lexy::buffer<lexy::utf8_encoding>> storage_;
+		// the byte order mark skipped at the beginning of a mapping
+		size_type skipped_;
+
+		SourceFile(std::variant<MappedFile, lexy::buffer<lexy::utf8_encoding>>&& storage, const size_type skipped) noexcept
+			: storage_{std::move(storage)},
+			skipped_{skipped} {}
+
+	public:
+		// nullopt if the file can be neither mapped nor read
+		[[nodiscard]] static auto open(const char* path) -> std::optional<SourceFile>;
+
+		[[nodiscard]] auto data() const noexcept -> const char_type*;
+
+		[[nodiscard]] auto size() const noexcept -> size_type;
+	};
+}
@@ -0,0 +1,194 @@
+#pragma once
+
+#include <CMakeTemplateProject/arena.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <optional>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+namespace symbols
+{
+	// index of an interned name, see SymbolInterner
+	using symbol_id = std::uint32_t;
+	constexpr symbol_id invalid_symbol = std::numeric_limits<symbol_id>::max();
+
+	// Keeps exactly one copy of every distinct name and hands out a dense id for it.
+	// The views returned by `name` stay valid as long as the interner lives.
+	class SymbolInterner final
+	{
+	public:
+		using size_type = std::size_t;
+
+	private:
+		memory::Arena storage_;
+
+		// id => name / hash
+		std::vector<std::string_view> names_;
+		std::vector<std::size_t> hashes_;
+
+		// open addressing (linear probing), power of two size, holds ids
+		std::vector<symbol_id> slots_;
+
+		[[nodiscard]] static auto hash(const std::string_view name) noexcept -> std::size_t { return std::hash<std::string_view>{}(name); }
+
+		[[nodiscard]] auto probe(const std::string_view name, const std::size_t h) const noexcept -> size_type
+		{
+			const auto mask = slots_.size() - 1;
+			for (auto index = h & mask;; index = (index + 1) & mask)
+			{
+				if (const auto id = slots_[index];
+					id == invalid_symbol || (hashes_[id] == h && names_[id] == name)) { return index; }
+			}
+		}
+
+		auto rehash(const size_type new_size) -> void
+		{
+			slots_.assign(new_size, invalid_symbol);
+
+			const auto mask = new_size - 1;
+			for (symbol_id id = 0; id < names_.size(); ++id)
+			{
+				auto index = hashes_[id] & mask;
+				while (slots_[index] != invalid_symbol) { index = (index + 1) & mask; }
+				slots_[index] = id;
+			}
+		}
+
+	public:
+		SymbolInterner()
+			: slots_(16, invalid_symbol) {}
+
+		[[nodiscard]] auto find(const std::string_view name) const noexcept -> symbol_id { return slots_[probe(name, hash(name))]; }
+
+		auto intern(const std::string_view name) -> symbol_id
+		{
+			const auto h = hash(name);
+			if (const auto id = slots_[probe(name, h)];
+				id != invalid_symbol) { return id; }
+
+			// keep the load factor below 1/2
+			if ((names_.size() + 1) * 2 > slots_.size()) { rehash(slots_.size() * 2); }
+
+			auto* data = static_cast<char*>(storage_.allocate(name.size(), alignof(char)));
+			std::ranges::copy(name, data);
+
+			const auto id = static_cast<symbol_id>(names_.size());
+			names_.emplace_back(data, name.size());
+			hashes_.push_back(h);
+			slots_[probe(name, h)] = id;
+			return id;
+		}
+
+		[[nodiscard]] auto name(const symbol_id id) const noexcept -> std::string_view { return names_[id]; }
+
+		[[nodiscard]] auto size() const noexcept -> size_type { return names_.size(); }
+	};
+
+	// Flat open addressing (linear probing) table keyed by interned symbol ids.
+	template<typename T>
+	class SymbolTable final
+	{
+	public:
+		using key_type = symbol_id;
+		using mapped_type = T;
+		using size_type = std::size_t;
+
+		using optional_mapped_type = std::optional<std::reference_wrapper<const mapped_type>>;
+
+	private:
+		struct slot
+		{
+			key_type key;
+			mapped_type value;
+		};
+
+		constexpr static unsigned initial_bits = 4;
+		constexpr static size_type initial_capacity = size_type{1} << initial_bits;
+
+		std::vector<slot> slots_;
+		size_type size_;
+		// log2(slots_.size())
+		unsigned bits_;
+
+		// fibonacci hashing, the ids are dense so the low bits alone would cluster
+		[[nodiscard]] auto index_of(const key_type key) const noexcept -> size_type { return static_cast<size_type>((static_cast<std::uint64_t>(key) * 0x9e37'79b9'7f4a'7c15ull) >> (64 - bits_)); }
+
+		[[nodiscard]] auto probe(const key_type key) const noexcept -> size_type
+		{
+			const auto mask = slots_.size() - 1;
+			auto index = index_of(key);
+			while (slots_[index].key != invalid_symbol && slots_[index].key != key) { index = (index + 1) & mask; }
+			return index;
+		}
+
+		auto grow() -> void
+		{
+			auto old = std::exchange(slots_, std::vector<slot>(slots_.size() * 2, slot{invalid_symbol, mapped_type{}}));
+			++bits_;
+
+			for (auto& s: old)
+			{
+				if (s.key != invalid_symbol) { slots_[probe(s.key)] = std::move(s); }
+			}
+		}
+
+		template<typename U>
+		auto emplace(const key_type key, U&& data) -> bool
+		{
+			if (const auto& s = slots_[probe(key)];
+				s.key == key) { return false; }
+
+			// keep the load factor below 3/4
+			if ((size_ + 1) * 4 > slots_.size() * 3) { grow(); }
+
+			slots_[probe(key)] = {key, std::forward<U>(data)};
+			++size_;
+			return true;
+		}
+
+	public:
+		SymbolTable()
+			: slots_(initial_capacity, slot{invalid_symbol, mapped_type{}}),
+			size_{0},
+			bits_{initial_bits} {}
+
+		[[nodiscard]] auto get(const key_type key) const -> optional_mapped_type
+		{
+			if (key == invalid_symbol) { return std::nullopt; }
+
+			if (const auto& s = slots_[probe(key)];
+				s.key == key) { return s.value; }
+			return std::nullopt;
+		}
+
+		auto set(const key_type key, mapped_type&& data) -> bool { return emplace(key, std::forward<decltype(data)>(data)); }
+
+		auto set(const key_type key, const mapped_type& data) -> bool { return emplace(key, data); }
+
+		// The tables of locals and blocks are cleared for every function, their capacity is kept for the next one,
+		// unless it is far above what is used (after a huge function, every later clear would walk all of it).
+		auto clear() -> void
+		{
+			if (size_ == 0) { return; }
+
+			if (slots_.size() > initial_capacity && size_ * 8 < slots_.size())
+			{
+				slots_ = std::vector<slot>(initial_capacity, slot{invalid_symbol, mapped_type{}});
+				bits_ = initial_bits;
+			}
+			else
+			{
+				for (auto& s: slots_) { s = slot{invalid_symbol, mapped_type{}}; }
+			}
+			size_ = 0;
+		}
+
+		[[nodiscard]] auto size() const noexcept -> size_type { return size_; }
+	};
+}
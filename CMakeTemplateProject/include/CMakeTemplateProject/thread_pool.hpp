@@ -0,0 +1,91 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace concurrency
+{
+	// A work-stealing thread pool.
+	// Every worker owns a queue, it takes its own tasks from the back and steals from the front of the others when it runs dry.
+	class ThreadPool final
+	{
+	public:
+		using size_type = std::size_t;
+		using task_type = std::function<void()>;
+
+	private:
+		struct worker_queue
+		{
+			std::mutex mutex;
+			std::deque<task_type> tasks;
+		};
+
+		std::vector<std::unique_ptr<worker_queue>> queues_;
+		std::vector<std::jthread> workers_;
+
+		// guards the sleeping workers/waiters
+		std::mutex sleep_mutex_;
+		std::condition_variable wake_worker_;
+		std::condition_variable wake_waiter_;
+		bool stopping_;
+
+		// number of tasks sitting in the queues (not yet picked up)
+		std::atomic<size_type> queued_;
+		// round-robin target of tasks submitted from outside the pool
+		std::atomic<size_type> next_queue_;
+
+		auto push(task_type&& task) -> void;
+
+		auto try_pop(size_type preferred_queue, task_type& task) -> bool;
+
+		auto work(size_type index) -> void;
+
+		// Runs queued tasks on the calling thread until `done` returns true.
+		auto help_until(const std::function<bool()>& done) -> void;
+
+	public:
+		explicit ThreadPool(size_type thread_count = std::thread::hardware_concurrency());
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+		ThreadPool(ThreadPool&&) = delete;
+		ThreadPool& operator=(ThreadPool&&) = delete;
+
+		// Finishes every queued task, then joins the workers.
+		~ThreadPool() noexcept;
+
+		[[nodiscard]] auto size() const noexcept -> size_type { return workers_.size(); }
+
+		// Calls `function(i)` for every i in [0, count) on the pool and returns once all calls are done.
+		// The calling thread takes part in the work, so it is fine to call this from inside a task.
+		// `function` must not throw.
+		template<typename Function>
+		auto parallel_for(const size_type count, Function&& function) -> void
+		{
+			if (count == 0) { return; }
+
+			std::atomic<size_type> remaining{count};
+			for (size_type i = 0; i < count; ++i)
+			{
+				push([&function, &remaining, this, i]
+				{
+					function(i);
+					if (remaining.fetch_sub(1, std::memory_order_acq_rel) == 1)
+					{
+						const std::lock_guard lock{sleep_mutex_};
+						wake_waiter_.notify_all();
+					}
+				});
+			}
+
+			help_until([&remaining] { return remaining.load(std::memory_order_acquire) == 0; });
+		}
+	};
+}
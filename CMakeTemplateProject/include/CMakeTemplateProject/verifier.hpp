@@ -0,0 +1,197 @@
+#pragma once
+
+#include <CMakeTemplateProject/backend.hpp>
+#include <CMakeTemplateProject/builtin.hpp>
+#include <CMakeTemplateProject/bytecode.hpp>
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <vector>
+
+namespace concurrency
+{
+	class ThreadPool;
+}
+
+namespace backend::verifier
+{
+	enum class error_type : std::uint8_t
+	{
+		// the code cannot be decoded
+		malformed_code,
+		// a local, global, function or block that does not exist
+		operand_out_of_range,
+		// an instruction pops more values than the block has
+		stack_underflow,
+		// the block does not end with as many values as its signature says
+		output_mismatch,
+		// `if` with a block that changes the height of the stack, or `if ... else` with blocks of different effects
+		unbalanced_branch,
+		// the body of `loop` must leave one value (the condition) more than it takes
+		unbalanced_loop,
+		// the first block is the entry of the function, it must have the same signature
+		entry_signature,
+	};
+
+	struct error
+	{
+		error_type type;
+		slot_type block;
+		// of the instruction in the code of the block, the size of the code for `output_mismatch`
+		std::size_t offset;
+	};
+
+	// Checks every block of `function` against its signature in one pass over its code: the blocks (and functions) an instruction runs
+	// are only looked at through their signatures, so each block is visited once.
+	// `callee(index)` is the signature of the function `index` (std::optional<Function::signature>), nullopt if there is none.
+	// `max_heights` (one per block, or empty) receives the most values each block has on the stack, its inputs included.
+	template<typename Callee>
+	[[nodiscard]] auto verify_function(const Function& function, const std::size_t global_count, Callee&& callee, const std::span<std::size_t> max_heights = {}) -> std::optional<error>
+	{
+		using bytecode::opcode;
+
+		if (!function.blocks.empty())
+		{
+			if (const auto& entry = function.blocks.front()->sig;
+				entry.input != function.sig.input || entry.output != function.sig.output) { return error{.type = error_type::entry_signature, .block = 0, .offset = 0}; }
+		}
+
+		for (std::size_t slot = 0; slot < function.blocks.size(); ++slot)
+		{
+			const auto& block = *function.blocks[slot];
+
+			std::size_t height = block.sig.input;
+			std::size_t max_height = height;
+			std::size_t offset = 0;
+			std::optional<error_type> failure{};
+
+			const auto apply = [&](const std::size_t pops, const std::size_t pushes) -> bool
+			{
+				if (height < pops)
+				{
+					failure = error_type::stack_underflow;
+					return false;
+				}
+
+				height = height - pops + pushes;
+				max_height = std::max(max_height, height);
+				return true;
+			};
+
+			const auto block_of = [&](const std::uint64_t operand) -> const Block* { return operand < function.blocks.size() ? function.blocks[operand] : nullptr; };
+
+			const auto decoded = bytecode::for_each_instruction(
+					block.code,
+					[&](const bytecode::instruction& instruction)
+					{
+						if (failure.has_value()) { return; }
+
+						const auto operand = instruction.operands[0];
+						switch (instruction.op)
+						{
+							case opcode::nop: { break; }
+							case opcode::push:
+							{
+								(void)apply(0, 1);
+								break;
+							}
+							case opcode::get:
+							case opcode::set:
+							{
+								if (operand >= function.locals.size()) { failure = error_type::operand_out_of_range; }
+								else if (instruction.op == opcode::get) { (void)apply(0, 1); }
+								else { (void)apply(1, 0); }
+								break;
+							}
+							case opcode::address:
+							{
+								if (operand >= global_count) { failure = error_type::operand_out_of_range; }
+								else { (void)apply(0, 1); }
+								break;
+							}
+							case opcode::call:
+							{
+								if (const std::optional<Function::signature> sig = callee(operand);
+									!sig.has_value()) { failure = error_type::operand_out_of_range; }
+								else { (void)apply(sig->input, sig->output); }
+								break;
+							}
+							case opcode::call_block:
+							{
+								if (const auto* target = block_of(operand);
+									target == nullptr) { failure = error_type::operand_out_of_range; }
+								else { (void)apply(target->sig.input, target->sig.output); }
+								break;
+							}
+							case opcode::if_:
+							{
+								if (const auto* then = block_of(operand);
+									then == nullptr) { failure = error_type::operand_out_of_range; }
+								// the block may not run
+								else if (then->sig.input != then->sig.output) { failure = error_type::unbalanced_branch; }
+								else { (void)(apply(1, 0) && apply(then->sig.input, then->sig.output)); }
+								break;
+							}
+							case opcode::if_else:
+							{
+								const auto* then = block_of(operand);
+								const auto* otherwise = block_of(instruction.operands[1]);
+								if (then == nullptr || otherwise == nullptr) { failure = error_type::operand_out_of_range; }
+								else if (then->sig.output + otherwise->sig.input != otherwise->sig.output + then->sig.input) { failure = error_type::unbalanced_branch; }
+								else
+								{
+									// the deeper input of both, the stack ends at the same height either way
+									const std::size_t input = std::max(then->sig.input, otherwise->sig.input);
+									(void)(apply(1, 0) && apply(input, input + then->sig.output - then->sig.input));
+								}
+								break;
+							}
+							case opcode::loop:
+							{
+								if (const auto* body = block_of(operand);
+									body == nullptr) { failure = error_type::operand_out_of_range; }
+								else if (body->sig.output != body->sig.input + 1) { failure = error_type::unbalanced_loop; }
+								// then the condition is popped
+								else { (void)(apply(body->sig.input, body->sig.output) && apply(1, 0)); }
+								break;
+							}
+							default:
+							{
+								const auto& sig = builtin::functions.entries()[static_cast<std::size_t>(instruction.op)].sig;
+								(void)apply(sig.input, sig.output);
+								break;
+							}
+						}
+
+						if (!failure.has_value()) { offset = instruction.next; }
+					});
+
+			if (!decoded && !failure.has_value()) { failure = error_type::malformed_code; }
+			if (!failure.has_value() && height != block.sig.output)
+			{
+				failure = error_type::output_mismatch;
+				offset = block.code.size();
+			}
+			if (failure.has_value()) { return error{.type = *failure, .block = static_cast<slot_type>(slot), .offset = offset}; }
+
+			if (!max_heights.empty()) { max_heights[slot] = max_height; }
+		}
+
+		return std::nullopt;
+	}
+
+	struct function_error
+	{
+		const Function* function;
+		error what;
+	};
+
+	// Verifies every function of `mod`, the errors are in function index order.
+	[[nodiscard]] auto verify_module(const Module& mod) -> std::vector<function_error>;
+
+	// Same as above, the functions are verified in parallel on the pool.
+	[[nodiscard]] auto verify_module(const Module& mod, concurrency::ThreadPool& pool) -> std::vector<function_error>;
+}
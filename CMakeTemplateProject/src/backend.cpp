@@ -0,0 +1,259 @@
+#include <CMakeTemplateProject/backend.hpp>
+#include <CMakeTemplateProject/hash.hpp>
+
+#include <algorithm>
+#include <limits>
+
+namespace
+{
+	// short patterns are expanded into a buffer of (at most) this size before being handed out
+	constexpr std::size_t chunk_size = 4096;
+
+	using size_type = backend::data_type::size_type;
+
+	// a * b, false if it does not fit
+	[[nodiscard]] constexpr auto multiply(const size_type a, const size_type b, size_type& result) noexcept -> bool
+	{
+		if (a != 0 && b > std::numeric_limits<size_type>::max() / a) { return false; }
+		result = a * b;
+		return true;
+	}
+}
+
+namespace backend
+{
+	data_type::data_type(std::string bytes)
+		: size_{0},
+		too_large_{false} { push_back({.bytes = std::move(bytes), .nested = nullptr, .count = 1}); }
+
+	auto data_type::shared(std::shared_ptr<const data_type> payload) -> data_type
+	{
+		data_type result{};
+		result.push_back({.bytes = {}, .nested = std::move(payload), .count = 1});
+		return result;
+	}
+
+	auto data_type::push_back(segment&& s) -> void
+	{
+		if (s.nested && s.nested->too_large_) { too_large_ = true; }
+		if (s.count == 0 || s.pattern_size() == 0) { return; }
+
+		if (size_type added = 0;
+			!multiply(s.pattern_size(), s.count, added) || added > std::numeric_limits<size_type>::max() - size_) { too_large_ = true; }
+		else { size_ += added; }
+
+		if (!segments_.empty())
+		{
+			// merge with the previous literal if possible
+			if (auto& last = segments_.back();
+				!last.nested && !s.nested)
+			{
+				// the counts cannot overflow unless the size did
+				if (last.bytes == s.bytes && !too_large_)
+				{
+					last.count += s.count;
+					return;
+				}
+				if (last.count == 1 && s.count == 1)
+				{
+					last.bytes += s.bytes;
+					return;
+				}
+			}
+		}
+
+		segments_.push_back(std::move(s));
+	}
+
+	auto data_type::repeat(data_type&& pattern, const size_type count) -> data_type
+	{
+		data_type result{};
+		result.too_large_ = pattern.too_large_;
+		if (count == 0 || pattern.empty()) { return result; }
+
+		if (pattern.segments_.size() == 1)
+		{
+			// [x * n] * count => x * (n * count)
+			auto s = std::move(pattern.segments_.front());
+			if (!multiply(s.count, count, s.count))
+			{
+				result.too_large_ = true;
+				return result;
+			}
+			result.push_back(std::move(s));
+			return result;
+		}
+
+		result.push_back({.bytes = {}, .nested = std::make_shared<const data_type>(std::move(pattern)), .count = count});
+		return result;
+	}
+
+	auto data_type::append(data_type&& other) -> void
+	{
+		const auto too_large = too_large_ || other.too_large_;
+		too_large_ = too_large;
+		if (other.empty()) { return; }
+		if (empty())
+		{
+			*this = std::move(other);
+			too_large_ = too_large;
+			return;
+		}
+
+		segments_.reserve(segments_.size() + other.segments_.size());
+		for (auto& s: other.segments_) { push_back(std::move(s)); }
+	}
+
+	auto data_type::for_each_chunk(const std::function<void(std::string_view)>& function) const -> void
+	{
+		for (const auto& s: segments_)
+		{
+			if (s.nested)
+			{
+				for (size_type i = 0; i < s.count; ++i) { s.nested->for_each_chunk(function); }
+				continue;
+			}
+
+			if (s.count == 1 || s.bytes.size() >= chunk_size)
+			{
+				for (size_type i = 0; i < s.count; ++i) { function(s.bytes); }
+				continue;
+			}
+
+			// repeat the pattern in a buffer first, then hand out the buffer
+			const auto per_chunk = std::min<size_type>(s.count, chunk_size / s.bytes.size());
+			std::string buffer{};
+			buffer.reserve(per_chunk * s.bytes.size());
+			for (size_type i = 0; i < per_chunk; ++i) { buffer += s.bytes; }
+
+			auto remaining = s.count;
+			for (; remaining >= per_chunk; remaining -= per_chunk) { function(buffer); }
+			if (remaining != 0) { function(std::string_view{buffer}.substr(0, remaining * s.bytes.size())); }
+		}
+	}
+
+	auto data_type::expand() const -> std::string
+	{
+		std::string result{};
+		result.reserve(size_);
+		for_each_chunk([&result](const std::string_view chunk) { result.append(chunk); });
+		return result;
+	}
+
+	auto data_type::all_zero() const noexcept -> bool
+	{
+		return std::ranges::all_of(
+				segments_,
+				[](const segment& s)
+				{
+					if (s.nested) { return s.nested->all_zero(); }
+					return std::ranges::all_of(s.bytes, [](const char c) { return c == '\0'; });
+				});
+	}
+
+	auto data_type::stored_size() const noexcept -> size_type
+	{
+		size_type result = 0;
+		for (const auto& s: segments_) { result += s.nested ? s.nested->stored_size() : s.bytes.size(); }
+		return result;
+	}
+
+	auto data_type::payload() const noexcept -> const data_type*
+	{
+		if (segments_.size() == 1 && segments_.front().nested && segments_.front().count == 1) { return segments_.front().nested.get(); }
+		return nullptr;
+	}
+
+	auto data_type::hash() const noexcept -> std::uint64_t
+	{
+		auto result = hashing::stable_hash(&size_, sizeof(size_));
+		for (const auto& s: segments_)
+		{
+			result = s.nested ? hashing::stable_hash(&result, sizeof(result), s.nested->hash()) : hashing::stable_hash(s.bytes, result);
+			result = hashing::stable_hash(&s.count, sizeof(s.count), result);
+		}
+		return result;
+	}
+
+	auto operator==(const data_type& lhs, const data_type& rhs) noexcept -> bool
+	{
+		if (&lhs == &rhs) { return true; }
+		if (lhs.size_ != rhs.size_ || lhs.segments_.size() != rhs.segments_.size()) { return false; }
+
+		return std::ranges::equal(
+				lhs.segments_,
+				rhs.segments_,
+				[](const data_type::segment& a, const data_type::segment& b)
+				{
+					if (a.count != b.count || static_cast<bool>(a.nested) != static_cast<bool>(b.nested)) { return false; }
+					return a.nested ? *a.nested == *b.nested : a.bytes == b.bytes;
+				});
+	}
+
+	std::atomic<bool> DataPool::share_across_modules_{false};
+
+	auto DataPool::intern(data_type&& data) -> std::shared_ptr<const data_type>
+	{
+		const auto hash = data.hash();
+		auto& [mutex, payloads, stats, sweep_at] = shards_[hash % shard_count];
+
+		std::scoped_lock lock{mutex};
+
+		const auto expired = [](const std::weak_ptr<const data_type>& candidate) { return candidate.expired(); };
+		if (payloads.size() >= sweep_at)
+		{
+			// amortized by the next sweep happening only once the live buckets doubled
+			for (auto it = payloads.begin(); it != payloads.end();)
+			{
+				std::erase_if(it->second, expired);
+				it = it->second.empty() ? payloads.erase(it) : std::next(it);
+			}
+			sweep_at = std::max(min_sweep, payloads.size() * 2);
+		}
+
+		auto& candidates = payloads[hash];
+		// the payloads released since are forgotten on the way
+		std::erase_if(candidates, expired);
+		for (const auto& candidate: candidates)
+		{
+			if (auto payload = candidate.lock();
+				payload != nullptr && *payload == data)
+			{
+				stats.reused += 1;
+				stats.bytes_saved += data.stored_size();
+				stats.expanded_bytes_saved += data.size();
+				return payload;
+			}
+		}
+
+		auto payload = std::make_shared<const data_type>(std::move(data));
+		candidates.emplace_back(payload);
+		stats.payloads += 1;
+		return payload;
+	}
+
+	auto DataPool::stats() const -> statistics
+	{
+		statistics result{};
+		for (auto& [mutex, payloads, stats, sweep_at]: shards_)
+		{
+			std::scoped_lock lock{mutex};
+			result.buckets += payloads.size();
+			result.payloads += stats.payloads;
+			result.reused += stats.reused;
+			result.bytes_saved += stats.bytes_saved;
+			result.expanded_bytes_saved += stats.expanded_bytes_saved;
+		}
+		return result;
+	}
+
+	auto DataPool::process() -> DataPool&
+	{
+		static DataPool pool{};
+		return pool;
+	}
+
+	auto DataPool::share_across_modules(const bool enable) noexcept -> void { share_across_modules_.store(enable, std::memory_order_relaxed); }
+
+	auto DataPool::sharing_across_modules() noexcept -> bool { return share_across_modules_.load(std::memory_order_relaxed); }
+}
@@ -0,0 +1,353 @@
+#include <CMakeTemplateProject/compiled_module.hpp>
+#include <CMakeTemplateProject/bytecode.hpp>
+
+#include <cstring>
+#include <limits>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <string>
+#include <system_error>
+#include <utility>
+
+namespace
+{
+	[[nodiscard]] constexpr auto align_up(const std::uint64_t offset, const std::uint64_t alignment) noexcept -> std::uint64_t { return (offset + alignment - 1) / alignment * alignment; }
+
+	template<typename T>
+	auto copy_section(std::vector<std::byte>& image, const std::uint64_t offset, const std::vector<T>& section) -> void
+	{
+		if (!section.empty()) { std::memcpy(image.data() + offset, section.data(), section.size() * sizeof(T)); }
+	}
+
+	// Stores the segments of `data` next to each other and returns [first, first + count).
+	// The segments of nested patterns are stored after them.
+	auto add_segments(
+			std::vector<backend::image::data_segment>& segments,
+			std::string& pool,
+			const backend::data_type& data
+			) -> std::pair<std::uint32_t, std::uint32_t>
+	{
+		const auto first = segments.size();
+		const auto count = data.segments().size();
+		segments.resize(first + count);
+
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			const auto& segment = data.segments()[i];
+			// `segments` may grow below, no references into it
+			backend::image::data_segment record{.bytes_offset = 0, .bytes_size = 0, .count = segment.count, .first_child = 0, .child_count = 0};
+
+			if (segment.nested)
+			{
+				const auto [first_child, child_count] = add_segments(segments, pool, *segment.nested);
+				record.first_child = first_child;
+				record.child_count = child_count;
+			}
+			else
+			{
+				record.bytes_offset = pool.size();
+				record.bytes_size = segment.bytes.size();
+				pool.append(segment.bytes);
+			}
+
+			segments[first + i] = record;
+		}
+
+		return {static_cast<std::uint32_t>(first), static_cast<std::uint32_t>(count)};
+	}
+}
+
+namespace backend
+{
+	auto serialize(const Module& mod, const std::uint64_t source_hash, const std::uint64_t source_size) -> std::vector<std::byte>
+	{
+		std::vector<image::function_record> functions{};
+		std::vector<image::global_record> globals{};
+		std::vector<image::data_segment> segments{};
+		std::vector<image::block_record> blocks{};
+		std::string strings{};
+		std::string data{};
+
+		const auto add_string = [&strings](const std::string_view string) -> image::string_ref
+		{
+			const image::string_ref ref{.offset = static_cast<std::uint32_t>(strings.size()), .size = static_cast<std::uint32_t>(string.size())};
+			strings.append(string);
+			return ref;
+		};
+
+		const auto module_name = add_string(mod.module_name);
+
+		functions.reserve(mod.functions().size());
+		blocks.reserve(mod.blocks().size());
+		mod.functions().for_each(
+				[&](const Function& function)
+				{
+					const auto index = static_cast<std::uint32_t>(functions.size());
+					functions.push_back({
+							.name = add_string(function.name),
+							.input = function.sig.input,
+							.output = function.sig.output,
+							.reserved = 0,
+							.first_block = static_cast<std::uint32_t>(blocks.size()),
+							.block_count = static_cast<std::uint32_t>(function.blocks.size()),
+							.local_count = static_cast<std::uint32_t>(function.locals.size())});
+
+					for (const auto* block: function.blocks)
+					{
+						blocks.push_back({.function = index, .input = block->sig.input, .output = block->sig.output, .reserved = 0, .code_offset = data.size(), .code_size = block->code.size()});
+						data.append(reinterpret_cast<const char*>(block->code.data()), block->code.size());
+					}
+				});
+
+		globals.reserve(mod.globals().size());
+		mod.globals().for_each(
+				[&](const Global& global)
+				{
+					// the segments of a shared payload rather than one segment around them
+					const auto* payload = global.data.payload();
+					const auto [first_segment, segment_count] = add_segments(segments, data, payload != nullptr ? *payload : global.data);
+					globals.push_back({
+							.name = add_string(global.name),
+							.kind = static_cast<std::uint32_t>(global.kind),
+							.first_segment = first_segment,
+							.segment_count = segment_count,
+							.data_size = global.data.size()});
+				});
+
+		image::header header{};
+		header.magic = image::magic;
+		header.version = image::version;
+		header.byte_order_mark = image::byte_order_mark;
+		header.source_hash = source_hash;
+		header.source_size = source_size;
+		header.module_name = module_name;
+		header.function_count = static_cast<std::uint32_t>(functions.size());
+		header.global_count = static_cast<std::uint32_t>(globals.size());
+		header.block_count = static_cast<std::uint32_t>(blocks.size());
+		header.segment_count = static_cast<std::uint32_t>(segments.size());
+
+		header.functions_offset = align_up(sizeof(image::header), 8);
+		header.globals_offset = align_up(header.functions_offset + functions.size() * sizeof(image::function_record), 8);
+		header.segments_offset = align_up(header.globals_offset + globals.size() * sizeof(image::global_record), 8);
+		header.blocks_offset = align_up(header.segments_offset + segments.size() * sizeof(image::data_segment), 8);
+		header.strings_offset = header.blocks_offset + blocks.size() * sizeof(image::block_record);
+		header.strings_size = strings.size();
+		header.data_offset = header.strings_offset + strings.size();
+		header.data_size = data.size();
+		header.image_size = header.data_offset + data.size();
+
+		std::vector<std::byte> result(header.image_size, std::byte{0});
+		std::memcpy(result.data(), &header, sizeof(header));
+		copy_section(result, header.functions_offset, functions);
+		copy_section(result, header.globals_offset, globals);
+		copy_section(result, header.segments_offset, segments);
+		copy_section(result, header.blocks_offset, blocks);
+		std::memcpy(result.data() + header.strings_offset, strings.data(), strings.size());
+		std::memcpy(result.data() + header.data_offset, data.data(), data.size());
+
+		return result;
+	}
+
+	auto CompiledModule::validate() const -> bool
+	{
+		if (bytes_.size() < sizeof(image::header)) { return false; }
+		// the records are read in place
+		if (reinterpret_cast<std::uintptr_t>(bytes_.data()) % alignof(image::header) != 0) { return false; }
+
+		const auto& h = header();
+		if (h.magic != image::magic || h.version != image::version || h.byte_order_mark != image::byte_order_mark) { return false; }
+		if (h.image_size != bytes_.size()) { return false; }
+
+		const auto fits = [size = bytes_.size()](const std::uint64_t offset, const std::uint64_t length) noexcept { return offset <= size && length <= size - offset; };
+		const auto aligned = [](const std::uint64_t offset) noexcept { return offset % 8 == 0; };
+
+		if (!aligned(h.functions_offset) || !fits(h.functions_offset, std::uint64_t{h.function_count} * sizeof(image::function_record))) { return false; }
+		if (!aligned(h.globals_offset) || !fits(h.globals_offset, std::uint64_t{h.global_count} * sizeof(image::global_record))) { return false; }
+		if (!aligned(h.segments_offset) || !fits(h.segments_offset, std::uint64_t{h.segment_count} * sizeof(image::data_segment))) { return false; }
+		if (!aligned(h.blocks_offset) || !fits(h.blocks_offset, std::uint64_t{h.block_count} * sizeof(image::block_record))) { return false; }
+		if (!fits(h.strings_offset, h.strings_size) || !fits(h.data_offset, h.data_size)) { return false; }
+
+		const auto valid_string = [&h](const image::string_ref ref) noexcept { return ref.offset <= h.strings_size && ref.size <= h.strings_size - ref.offset; };
+
+		if (!valid_string(h.module_name)) { return false; }
+		for (const auto& function: functions())
+		{
+			if (!valid_string(function.name)) { return false; }
+			if (function.first_block > h.block_count || function.block_count > h.block_count - function.first_block) { return false; }
+		}
+
+		// expanded size of every segment, children are stored after their parent so walk backwards
+		const auto all_segments = segments();
+		std::vector<std::uint64_t> segment_sizes(all_segments.size(), 0);
+		const auto multiply = [](const std::uint64_t a, const std::uint64_t b, std::uint64_t& result) noexcept
+		{
+			if (b != 0 && a > std::numeric_limits<std::uint64_t>::max() / b) { return false; }
+			result = a * b;
+			return true;
+		};
+		const auto sum = [&segment_sizes](const std::uint64_t first, const std::uint64_t count, std::uint64_t& result) noexcept
+		{
+			result = 0;
+			for (auto i = first; i < first + count; ++i)
+			{
+				if (segment_sizes[i] > std::numeric_limits<std::uint64_t>::max() - result) { return false; }
+				result += segment_sizes[i];
+			}
+			return true;
+		};
+
+		for (auto i = all_segments.size(); i != 0; --i)
+		{
+			const auto& segment = all_segments[i - 1];
+			std::uint64_t pattern_size = 0;
+			if (segment.child_count == 0)
+			{
+				if (segment.bytes_offset > h.data_size || segment.bytes_size > h.data_size - segment.bytes_offset) { return false; }
+				pattern_size = segment.bytes_size;
+			}
+			else
+			{
+				// forward only, which also rules out cycles
+				if (segment.bytes_size != 0 || segment.first_child < i || segment.first_child > h.segment_count || segment.child_count > h.segment_count - segment.first_child) { return false; }
+				if (!sum(segment.first_child, segment.child_count, pattern_size)) { return false; }
+			}
+			if (!multiply(pattern_size, segment.count, segment_sizes[i - 1])) { return false; }
+		}
+
+		for (const auto& global: globals())
+		{
+			if (!valid_string(global.name)) { return false; }
+			if (global.kind > static_cast<std::uint32_t>(Global::kind_type::immutable_data)) { return false; }
+			if (global.first_segment > h.segment_count || global.segment_count > h.segment_count - global.first_segment) { return false; }
+
+			std::uint64_t data_size = 0;
+			if (!sum(global.first_segment, global.segment_count, data_size) || data_size != global.data_size) { return false; }
+		}
+		const auto all_blocks = blocks();
+		for (std::size_t i = 0; i < all_blocks.size(); ++i)
+		{
+			const auto& block = all_blocks[i];
+			if (block.function >= h.function_count) { return false; }
+			if (block.code_offset > h.data_size || block.code_size > h.data_size - block.code_offset) { return false; }
+
+			// the executors trust the operands, which are checked against the function owning the block
+			const auto& function = functions()[block.function];
+			if (i < function.first_block || i - function.first_block >= function.block_count) { return false; }
+			const auto valid = [&](const bytecode::instruction& instruction) noexcept
+			{
+				switch (instruction.op)
+				{
+					case bytecode::opcode::get:
+					case bytecode::opcode::set: { return instruction.operands[0] < function.local_count; }
+					case bytecode::opcode::address: { return instruction.operands[0] < h.global_count; }
+					case bytecode::opcode::call: { return instruction.operands[0] < h.function_count; }
+					case bytecode::opcode::call_block:
+					case bytecode::opcode::if_:
+					case bytecode::opcode::loop: { return instruction.operands[0] < function.block_count; }
+					case bytecode::opcode::if_else: { return instruction.operands[0] < function.block_count && instruction.operands[1] < function.block_count; }
+					default: { return true; }
+				}
+			};
+
+			bool operands_valid = true;
+			if (!bytecode::for_each_instruction(code(block), [&](const bytecode::instruction& instruction) { operands_valid = operands_valid && valid(instruction); }) || !operands_valid) { return false; }
+		}
+
+		return true;
+	}
+
+	auto CompiledModule::open(const char* path) -> std::optional<CompiledModule>
+	{
+		io::MappedFile file{path};
+		if (!file) { return std::nullopt; }
+
+		CompiledModule result{};
+		result.bytes_ = {reinterpret_cast<const std::byte*>(file.data()), file.size()};
+		result.storage_ = std::move(file);
+
+		if (!result.validate()) { return std::nullopt; }
+		return result;
+	}
+
+	auto CompiledModule::from_bytes(std::vector<std::byte>&& bytes) -> std::optional<CompiledModule>
+	{
+		CompiledModule result{};
+		result.bytes_ = bytes;
+		result.storage_ = std::move(bytes);
+
+		if (!result.validate()) { return std::nullopt; }
+		return result;
+	}
+
+	auto CompiledModule::data(const std::span<const image::data_segment> segments) const -> data_type
+	{
+		data_type result{};
+		for (const auto& segment: segments)
+		{
+			if (segment.child_count == 0) { result.append(data_type::repeat(data_type{std::string{pattern(segment)}}, segment.count)); }
+			else { result.append(data_type::repeat(data(children_of(segment)), segment.count)); }
+		}
+		return result;
+	}
+
+	auto CompiledModule::data(const image::global_record& global) const -> data_type { return data(segments_of(global)); }
+
+	auto CompiledModule::expand(const image::global_record& global) const -> std::string { return data(global).expand(); }
+
+	auto CompiledModule::load() const -> std::unique_ptr<Module>
+	{
+		auto mod = std::make_unique<Module>(symbol_name_type{module_name()});
+		LocalBuilder builder{*mod};
+
+		for (const auto& function: functions())
+		{
+			auto* f = mod->register_function(string(function.name), {.input = function.input, .output = function.output});
+
+			builder.begin_function(*f);
+			for (std::uint32_t i = 0; i < function.local_count; ++i) { (void)builder.register_local({}); }
+			for (const auto& block: blocks_of(function))
+			{
+				const auto instructions = code(block);
+				builder.register_block({.input = block.input, .output = block.output})->code.assign(instructions.begin(), instructions.end());
+			}
+		}
+
+		for (const auto& global: globals())
+		{
+			if (static_cast<Global::kind_type>(global.kind) == Global::kind_type::mutable_data) { (void)mod->register_global_mutable_data(string(global.name), data(global)); }
+			else { (void)mod->register_global_immutable_data(string(global.name), data(global)); }
+		}
+
+		return mod;
+	}
+
+	auto write_compiled_module(const std::span<const std::byte> image, const char* path) -> bool
+	{
+		const std::filesystem::path target{path};
+		// unique per writer, several processes/threads may compile the same source at once
+		auto temporary = target;
+		temporary += ".tmp." + std::to_string(std::random_device{}());
+
+		const auto written = [&]
+		{
+			std::ofstream out{temporary, std::ios::binary | std::ios::trunc};
+			if (!out) { return false; }
+
+			out.write(reinterpret_cast<const char*>(image.data()), static_cast<std::streamsize>(image.size()));
+			// flushed here, so that a full disk is noticed
+			out.close();
+			return !out.fail();
+		}();
+
+		std::error_code error{};
+		if (written) { std::filesystem::rename(temporary, target, error); }
+		if (!written || error)
+		{
+			// whatever failed (even the open, the file may have been created), no temporary file is left behind
+			std::filesystem::remove(temporary, error);
+			return false;
+		}
+		return true;
+	}
+}
@@ -0,0 +1,213 @@
+#include <CMakeTemplateProject/elf_object.hpp>
+
+#include <algorithm>
+#include <bit>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+namespace
+{
+	using backend::elf::section_index;
+
+	[[nodiscard]] constexpr auto align_up(const std::uint64_t offset, const std::uint64_t alignment) noexcept -> std::uint64_t { return (offset + alignment - 1) / alignment * alignment; }
+
+	// globals are 8-byte aligned, as in the interpreter
+	constexpr std::uint64_t global_alignment = 8;
+
+	[[nodiscard]] constexpr auto index_of(const section_index section) noexcept -> std::uint16_t { return static_cast<std::uint16_t>(section); }
+
+	[[nodiscard]] auto section_of(const backend::Global& global) noexcept -> section_index
+	{
+		if (global.kind == backend::Global::kind_type::immutable_data) { return section_index::rodata; }
+		return global.data.all_zero() ? section_index::bss : section_index::data;
+	}
+
+	// a string table starts with an empty string
+	class StringTable
+	{
+	public:
+		StringTable()
+			: strings_(1, '\0') {}
+
+		auto add(const std::string_view string) -> std::uint32_t
+		{
+			const auto offset = static_cast<std::uint32_t>(strings_.size());
+			strings_.append(string);
+			strings_.push_back('\0');
+			return offset;
+		}
+
+		[[nodiscard]] auto bytes() const noexcept -> std::string_view { return strings_; }
+
+	private:
+		std::string strings_;
+	};
+}
+
+namespace backend
+{
+	auto write_elf_object(const Module& mod) -> std::vector<std::byte>
+	{
+		// index => offset in its section
+		std::vector<std::uint64_t> offsets(mod.globals().size(), 0);
+		// index => whether the data is written, the immutable globals sharing a payload (see DataPool) share their place too
+		std::vector<bool> owners(mod.globals().size(), true);
+		std::unordered_map<const data_type*, std::uint64_t> payload_offsets{};
+		// section index => size
+		std::array<std::uint64_t, elf::section_count> sizes{};
+
+		mod.globals().for_each(
+				[&](const Global& global)
+				{
+					const auto section = section_of(global);
+					if (const auto* payload = global.data.payload();
+						payload != nullptr && section == section_index::rodata)
+					{
+						if (const auto it = payload_offsets.find(payload);
+							it != payload_offsets.end())
+						{
+							offsets[global.index] = it->second;
+							owners[global.index] = false;
+							return;
+						}
+						payload_offsets.emplace(payload, sizes[index_of(section)]);
+					}
+
+					auto& size = sizes[index_of(section)];
+					offsets[global.index] = size;
+					size = align_up(size + global.data.size(), global_alignment);
+				});
+
+		// symbols, the local ones first
+		StringTable symbol_names{};
+		std::vector<elf::symbol> symbols{};
+		symbols.push_back({.name = 0, .info = 0, .other = 0, .section = 0, .value = 0, .size = 0});
+		symbols.push_back(
+				{
+						.name = symbol_names.add(mod.module_name),
+						.info = elf::symbol_info(elf::bind_local, elf::symbol_file),
+						.other = 0,
+						.section = elf::section_index_absolute,
+						.value = 0,
+						.size = 0
+				});
+		const auto first_global = static_cast<std::uint32_t>(symbols.size());
+		mod.globals().for_each(
+				[&](const Global& global)
+				{
+					symbols.push_back(
+							{
+									.name = symbol_names.add(global.name),
+									.info = elf::symbol_info(elf::bind_global, elf::symbol_object),
+									.other = 0,
+									.section = index_of(section_of(global)),
+									.value = offsets[global.index],
+									.size = global.data.size()
+							});
+				});
+
+		StringTable section_names{};
+		std::array<elf::section_header, elf::section_count> sections{};
+		const auto describe = [&](const section_index index, const std::string_view name, const std::uint32_t type, const std::uint64_t flags, const std::uint64_t alignment)
+		{
+			sections[index_of(index)] = {
+					.name = section_names.add(name),
+					.type = type,
+					.flags = flags,
+					.address = 0,
+					.offset = 0,
+					.size = sizes[index_of(index)],
+					.link = 0,
+					.info = 0,
+					.alignment = alignment,
+					.entry_size = 0
+			};
+		};
+
+		sizes[index_of(section_index::symtab)] = symbols.size() * sizeof(elf::symbol);
+		sizes[index_of(section_index::strtab)] = symbol_names.bytes().size();
+
+		describe(section_index::data, ".data", elf::section_progbits, elf::flag_alloc | elf::flag_write, global_alignment);
+		describe(section_index::rodata, ".rodata", elf::section_progbits, elf::flag_alloc, global_alignment);
+		describe(section_index::bss, ".bss", elf::section_nobits, elf::flag_alloc | elf::flag_write, global_alignment);
+		describe(section_index::symtab, ".symtab", elf::section_symtab, 0, alignof(elf::symbol));
+		describe(section_index::strtab, ".strtab", elf::section_strtab, 0, 1);
+		describe(section_index::note_gnu_stack, ".note.GNU-stack", elf::section_progbits, 0, 1);
+		describe(section_index::shstrtab, ".shstrtab", elf::section_strtab, 0, 1);
+		// its own name is in it
+		sections[index_of(section_index::shstrtab)].size = section_names.bytes().size();
+
+		auto& symtab = sections[index_of(section_index::symtab)];
+		symtab.link = index_of(section_index::strtab);
+		symtab.info = first_global;
+		symtab.entry_size = sizeof(elf::symbol);
+
+		// file header | the content of the sections in order | section headers
+		std::uint64_t file_size = sizeof(elf::file_header);
+		for (auto& section: sections)
+		{
+			if (section.type == elf::section_null) { continue; }
+
+			file_size = align_up(file_size, section.alignment);
+			section.offset = file_size;
+			if (section.type != elf::section_nobits) { file_size += section.size; }
+		}
+		file_size = align_up(file_size, alignof(elf::section_header));
+		const auto section_headers_offset = file_size;
+		file_size += sizeof(sections);
+
+		std::vector<std::byte> object(file_size, std::byte{0});
+		const auto write = [&object](const std::uint64_t offset, const void* data, const std::size_t size)
+		{
+			if (size != 0) { std::memcpy(object.data() + offset, data, size); }
+		};
+
+		elf::file_header header{
+				.ident = {},
+				.type = elf::type_relocatable,
+				.machine = elf::native_machine,
+				.version = elf::current_version,
+				.entry = 0,
+				.program_headers_offset = 0,
+				.section_headers_offset = section_headers_offset,
+				.flags = 0,
+				.header_size = sizeof(elf::file_header),
+				.program_header_size = 0,
+				.program_header_count = 0,
+				.section_header_size = sizeof(elf::section_header),
+				.section_header_count = static_cast<std::uint16_t>(elf::section_count),
+				.names_section = index_of(section_index::shstrtab)
+		};
+		std::ranges::copy(elf::magic, header.ident.begin());
+		header.ident[elf::ident_class] = elf::class_64;
+		// everything is written in native byte order
+		header.ident[elf::ident_data] = std::endian::native == std::endian::little ? elf::data_little_endian : elf::data_big_endian;
+		header.ident[elf::ident_version] = elf::current_version;
+		write(0, &header, sizeof(header));
+
+		// the data is expanded straight into its place, the padding between globals stays zero
+		mod.globals().for_each(
+				[&](const Global& global)
+				{
+					const auto section = section_of(global);
+					if (section == section_index::bss || !owners[global.index]) { return; }
+
+					auto offset = sections[index_of(section)].offset + offsets[global.index];
+					global.data.for_each_chunk(
+							[&](const std::string_view chunk)
+							{
+								write(offset, chunk.data(), chunk.size());
+								offset += chunk.size();
+							});
+				});
+
+		write(symtab.offset, symbols.data(), symbols.size() * sizeof(elf::symbol));
+		write(sections[index_of(section_index::strtab)].offset, symbol_names.bytes().data(), symbol_names.bytes().size());
+		write(sections[index_of(section_index::shstrtab)].offset, section_names.bytes().data(), section_names.bytes().size());
+		write(section_headers_offset, sections.data(), sizeof(sections));
+
+		return object;
+	}
+}
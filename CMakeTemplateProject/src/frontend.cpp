@@ -1,143 +1,145 @@
 #include <CMakeTemplateProject/frontend.hpp>
+#include <CMakeTemplateProject/arena.hpp>
+#include <CMakeTemplateProject/backend.hpp>
+#include <CMakeTemplateProject/builtin.hpp>
+#include <CMakeTemplateProject/bytecode.hpp>
+#include <CMakeTemplateProject/thread_pool.hpp>
+#include <CMakeTemplateProject/source_file.hpp>
+#include <CMakeTemplateProject/compiled_module.hpp>
+#include <CMakeTemplateProject/hash.hpp>
+#include <CMakeTemplateProject/scanning.hpp>
+#include <CMakeTemplateProject/symbol_table.hpp>
+#include <CMakeTemplateProject/verifier.hpp>
 
 #include <lexy/dsl.hpp>
 #include <lexy/action/parse.hpp>
-#include <lexy/input/file.hpp>
 #include <lexy/input/string_input.hpp>
+#include <lexy/input/lexeme_input.hpp>
 #include <lexy_ext/report_error.hpp>
 #include <lexy/callback.hpp>
 
-#include <map>
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <concepts>
+#include <cstring>
+#include <limits>
 #include <string>
 #include <string_view>
+#include <system_error>
 #include <optional>
 #include <cstdio>
+#include <filesystem>
+#include <functional>
+#include <iterator>
 #include <memory>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <variant>
+#include <vector>
 
 namespace
 {
-	using symbol_name_type = std::string;
-	using symbol_name_view_type = std::string_view;
+	using symbol_name_type = backend::symbol_name_type;
+	using symbol_name_view_type = backend::symbol_name_view_type;
+
+	using symbols::symbol_id;
+	using symbols::invalid_symbol;
+	using symbols::SymbolInterner;
+	using symbols::SymbolTable;
 
-	template<typename T>
-	class SymbolTable final
+	// The beginning of every line of a buffer, so that a position can be turned into a line with a binary search
+	// instead of counting newlines from the beginning of the file.
+	class LineIndex final
 	{
 	public:
-		using key_type = symbol_name_type;
-		using mapped_type = T;
+		using size_type = std::size_t;
 
-		using key_view_type = symbol_name_view_type;
-		using optional_mapped_type = std::optional<std::reference_wrapper<const mapped_type>>;
+		struct line
+		{
+			const char8_t* begin;
+			// 1-based
+			unsigned number;
+		};
 
 	private:
-		std::map<key_type, mapped_type, std::less<>> table_;
+		std::vector<const char8_t*> line_begins_;
 
 	public:
-		[[nodiscard]] auto get(const key_view_type name) const -> optional_mapped_type
-		{
-			if (auto it = table_.find(name);
-				it != table_.end()) { return it->second; }
-			return std::nullopt;
-		}
+		LineIndex() noexcept = default;
 
-		auto set(const key_view_type name, mapped_type&& data) -> bool
+		// One pass over the buffer, lines end with '\n' (which also covers "\r\n").
+		LineIndex(const char8_t* begin, const char8_t* end)
 		{
-			auto [it, inserted] = table_.emplace(name, std::forward<decltype(data)>(data));
-			return inserted;
+			line_begins_.push_back(begin);
+			for (auto* p = begin; p != end;)
+			{
+				const auto* newline = static_cast<const char8_t*>(std::memchr(p, '\n', static_cast<size_type>(end - p)));
+				if (newline == nullptr) { break; }
+
+				p = newline + 1;
+				line_begins_.push_back(p);
+			}
 		}
 
-		auto set(const key_view_type name, const mapped_type& data) -> bool
+		[[nodiscard]] auto empty() const noexcept -> bool { return line_begins_.empty(); }
+
+		[[nodiscard]] auto size() const noexcept -> size_type { return line_begins_.size(); }
+
+		// the line containing `position` (a newline belongs to the line it ends)
+		[[nodiscard]] auto line_of(const char8_t* position) const noexcept -> line
 		{
-			auto [it, inserted] = table_.emplace(name, data);
-			return inserted;
+			// the first line beginning after `position`, never the first one
+			const auto next = std::ranges::upper_bound(line_begins_, position);
+			return {.begin = *std::prev(next), .number = static_cast<unsigned>(next - line_begins_.begin())};
 		}
-
-		auto clear() -> void { table_.clear(); }
 	};
 }
 
-namespace backend
+namespace
 {
-	class BuiltinFunction { };
-
-	class BuiltinType { };
-
-	class Global { };
-
-	class Local { };
-
-	// function body
-	class Block { };
-
-	class Function
+	// `Input` whose reader knows where the input ends, lexy readers do not expose it.
+	// The identifier and whitespace tokens need it to read whole vectors, and jump over what they scanned at once.
+	template<typename Input>
+	class bounded_input final : public Input
 	{
 	public:
-		struct signature
+		class reader_type : public lexy::input_reader<Input>
 		{
-			using size_type = std::uint8_t;
+			const char8_t* end_;
 
-			size_type input;
-			size_type output;
-		};
+		public:
+			reader_type(const lexy::input_reader<Input>& reader, const char8_t* end) noexcept
+				: lexy::input_reader<Input>{reader},
+				end_{end} {}
 
-		signature sig;
-	};
+			[[nodiscard]] auto end() const noexcept -> const char8_t* { return end_; }
 
-	using data_type = symbol_name_type;
+			// `length` characters ahead, in one step
+			auto skip(const std::size_t length) noexcept -> void { this->reset({this->position() + length}); }
+		};
+
+	private:
+		const char8_t* end_;
 
-	class LocalBuilder
-	{
 	public:
-		auto register_local(const symbol_name_type& identifier) -> Local*
-		{
-			// todo
-			(void)identifier;
-			return new Local{};
-		}
+		// [begin, end) of the buffer of `input`, which is also what a lexy::lexeme_input takes
+		template<typename... Args>
+		explicit bounded_input(const char8_t* end, Args&&... args) noexcept
+			: Input{std::forward<Args>(args)...},
+			end_{end} {}
 
-		auto register_block(const Function::signature signature) -> Block*
-		{
-			// todo
-			(void)signature;
-			return new Block{};
-		}
+		[[nodiscard]] auto reader() const& noexcept -> reader_type { return {Input::reader(), end_}; }
 	};
 
-	class Module
+	template<typename Reader>
+	concept bounded_reader = requires(Reader& reader, const std::size_t length)
 	{
-	public:
-		symbol_name_type module_name;
-
-		explicit Module(symbol_name_type&& module_name)
-			: module_name{std::move(module_name)} {}
-
-		auto register_function(const symbol_name_type& identifier, const Function::signature sig) -> Function*
-		{
-			// todo
-			(void)identifier;
-			return new Function{sig};
-		}
-
-		auto register_global_mutable_data(const symbol_name_type& identifier, data_type&& data) -> Global*
-		{
-			// todo
-			(void)identifier;
-			(void)data;
-			return new Global{};
-		}
-
-		auto register_global_immutable_data(const symbol_name_type& identifier, data_type&& data) -> Global*
-		{
-			// todo
-			(void)identifier;
-			(void)data;
-			return new Global{};
-		}
+		{ reader.end() } -> std::same_as<const char8_t*>;
+		reader.skip(length);
 	};
-}
 
-namespace
-{
 	class ParseState
 	{
 	public:
@@ -152,121 +154,293 @@ namespace
 					lexy::values);
 		}
 
-		using context_type = lexy::buffer<lexy::utf8_encoding>;
+		// a view, the bytes are owned by `storage`
+		using context_type = lexy::string_input<lexy::utf8_encoding>;
+		// either mapped (zero-copy), read into memory (when the file cannot be mapped) or borrowed from another state
+		using storage_type = std::variant<io::SourceFile, lexy::buffer<lexy::utf8_encoding>, context_type>;
+
+		using diagnostic_output_type = std::back_insert_iterator<std::string>;
 
 		std::string filename;
+		storage_type storage;
 		context_type buffer;
-		lexy::input_location_anchor<context_type> buffer_anchor;
+		// built on the first diagnostic, most files never need it
+		LineIndex line_index;
+
+		// Semantic errors are only recorded while parsing (what and where), and rendered once at the end.
+		struct pending_diagnostic
+		{
+			enum class kind_type : std::uint8_t
+			{
+				invalid_identifier,
+				conflicting_signature,
+				duplicate_declaration,
+				// see backend::data_type::too_large
+				data_too_large,
+				// see backend::verifier::error_type
+				invalid_code,
+				stack_underflow,
+				output_mismatch,
+				unbalanced_branch,
+				unbalanced_loop,
+			};
+
+			kind_type kind;
+			const char8_t* position;
+			symbol_id symbol;
+			// a string literal
+			const char* category;
+		};
+
+		// rendered diagnostics of this file, written out by the caller in one go
+		std::string diagnostics;
+		std::size_t error_count;
 
-		SymbolTable<const backend::BuiltinFunction*> builtin_functions;
-		SymbolTable<const backend::BuiltinType*> builtin_types;
+		std::vector<pending_diagnostic> pending_diagnostics;
+		// errors recorded since the last render, some may have been dropped
+		std::size_t recorded_error_count;
+		// at most that many errors are kept (and rendered) per parse, every one of them is counted though
+		std::size_t max_errors;
 
-		backend::Module* mod;
+		// all symbol tables below are keyed by ids from here
+		SymbolInterner symbols;
+		symbol_id block_entry_symbol;
+
+		std::unique_ptr<backend::Module> mod;
 		std::unique_ptr<backend::LocalBuilder> local_builder;
 
 		SymbolTable<backend::Global*> globals;
-		SymbolTable<backend::Local*> locals;
+		// slots in the current function
+		SymbolTable<backend::slot_type> locals;
 		SymbolTable<backend::Function*> functions;
-		SymbolTable<backend::Block*> blocks;
+		SymbolTable<backend::slot_type> blocks;
+
+		// the state that declared the globals and functions, if this one only parses function bodies (see parse_buffer_parallel)
+		const ParseState* parent;
 
 		backend::Function* current_function;
+		// the instructions are appended to it
+		backend::Block* current_block;
+
+		// blocks of the current function used before their declaration
+		struct undeclared_block
+		{
+			symbol_id symbol;
+			const char8_t* position;
+		};
+
+		std::vector<undeclared_block> undeclared_blocks;
+
+		// where the current function and its blocks are declared, the stack errors of a block are reported there
+		struct block_site
+		{
+			const char8_t* position;
+			symbol_id symbol;
+			// a string literal
+			const char* category;
+		};
+
+		const char8_t* function_position;
+		// slot => declaration
+		std::vector<block_site> block_sites;
+		// index => function, of every function called by the current one
+		std::unordered_map<backend::index_type, const backend::Function*> callees;
+		// see error_mark, when the current function began
+		std::pair<std::size_t, std::size_t> function_error_mark;
+		// a second body of a function is parsed into it (so that its own errors are still found), then dropped
+		std::optional<backend::Function> duplicate_body;
+
+		[[nodiscard]] static auto view_of(const storage_type& storage) noexcept -> context_type
+		{
+			return std::visit(
+					[]<typename Storage>(const Storage& s) -> context_type
+					{
+						if constexpr (std::is_same_v<Storage, context_type>) { return s; }
+						else { return {s.data(), s.size()}; }
+					},
+					storage);
+		}
 
-		ParseState(std::string&& filename, context_type&& buffer)
+		ParseState(std::string&& filename, storage_type&& storage, const std::size_t max_errors = frontend::no_error_limit)
 			: filename{std::move(filename)},
-			buffer{std::move(buffer)},
-			buffer_anchor{this->buffer},
+			storage{std::move(storage)},
+			buffer{view_of(this->storage)},
+			error_count{0},
+			recorded_error_count{0},
+			max_errors{max_errors},
+			block_entry_symbol{symbols.intern("@block_entry@")},
 			mod{nullptr},
-			// todo: local_builder
-			local_builder{std::make_unique<backend::LocalBuilder>()} { }
+			// created together with the module
+			local_builder{nullptr},
+			parent{nullptr},
+			current_function{nullptr},
+			current_block{nullptr},
+			function_position{nullptr},
+			function_error_mark{0, 0} { }
+
+		auto create_module(symbol_name_type&& module_name) -> void
+		{
+			mod = std::make_unique<backend::Module>(std::move(module_name));
+			local_builder = std::make_unique<backend::LocalBuilder>(*mod);
+		}
 
-		auto report_invalid_identifier(const char8_t* position, const symbol_name_type& identifier, const char* category) const -> void
+		// the following locals, blocks and instructions belong to `function` (declared at `position`)
+		auto begin_function(backend::Function& function, const char8_t* position) -> void
 		{
-			const auto location = lexy::get_input_location(buffer, position, buffer_anchor);
+			current_function = &function;
+			current_block = nullptr;
+			local_builder->begin_function(function);
+
+			locals.clear();
+			blocks.clear();
+			undeclared_blocks.clear();
+
+			function_position = position;
+			block_sites.clear();
+			callees.clear();
+			function_error_mark = error_mark();
+		}
 
-			const auto out = lexy::cfile_output_iterator{stderr};
-			const lexy_ext::diagnostic_writer<context_type> writer{buffer, {.flags = lexy::visualize_fancy}};
+		[[nodiscard]] auto input() const noexcept -> bounded_input<context_type> { return bounded_input<context_type>{buffer.data() + buffer.size(), buffer}; }
 
-			(void)writer.write_message(out,
-										lexy_ext::diagnostic_kind::error,
-										[&](lexy::cfile_output_iterator, lexy::visualization_options)
-										{
-											(void)std::fprintf(stderr, "unknown %s name '%s'", category, identifier.c_str());
-											return out;
-										});
-
-			if (!filename.empty()) { (void)writer.write_path(out, filename.c_str()); }
-
-			(void)writer.write_empty_annotation(out);
-			(void)writer.write_annotation(
-					out,
-					lexy_ext::annotation_kind::primary,
-					location,
-					identifier.size(),
-					[&](lexy::cfile_output_iterator, lexy::visualization_options)
-					{
-						(void)std::fprintf(stderr, "used here");
-						return out;
-					});
+		// [begin, end) of the buffer, its positions (and so the diagnostics) stay relative to the whole buffer
+		[[nodiscard]] auto input(const char8_t* begin, const char8_t* end) const noexcept -> bounded_input<lexy::lexeme_input<context_type>>
+		{
+			return bounded_input<lexy::lexeme_input<context_type>>{end, buffer, begin, end};
 		}
 
-		auto report_conflicting_signature(const char8_t* position, const symbol_name_type& identifier, const char* category) const -> void
+		// changes whenever an error is found, the syntax errors are rendered by lexy right away
+		[[nodiscard]] auto error_mark() const noexcept -> std::pair<std::size_t, std::size_t> { return {error_count, diagnostics.size()}; }
+
+		auto set_block_site(const backend::slot_type slot, const block_site site) -> void
 		{
-			const auto location = lexy::get_input_location(buffer, position, buffer_anchor);
+			if (slot >= block_sites.size()) { block_sites.resize(slot + 1, {.position = nullptr, .symbol = invalid_symbol, .category = nullptr}); }
+			block_sites[slot] = site;
+		}
 
-			const auto out = lexy::cfile_output_iterator{stderr};
-			const lexy_ext::diagnostic_writer<context_type> writer{buffer, {.flags = lexy::visualize_fancy}};
+		// the globals are declared by the parent, if any
+		[[nodiscard]] auto global_count() const noexcept -> std::size_t { return parent != nullptr ? parent->global_count() : mod->globals().size(); }
 
-			(void)writer.write_message(out,
-										lexy_ext::diagnostic_kind::error,
-										[&](lexy::cfile_output_iterator, lexy::visualization_options)
-										{
-											(void)std::fprintf(stderr, "conflicting signature in %s declaration named '%s'", category, identifier.c_str());
-											return out;
-										});
-
-			if (!filename.empty()) { (void)writer.write_path(out, filename.c_str()); }
-
-			(void)writer.write_empty_annotation(out);
-			(void)writer.write_annotation(
-					out,
-					lexy_ext::annotation_kind::primary,
-					location,
-					identifier.size(),
-					[&](lexy::cfile_output_iterator, lexy::visualization_options)
-					{
-						(void)std::fprintf(stderr, "second declaration here");
-						return out;
-					});
+		[[nodiscard]] auto find_global(const symbol_name_view_type symbol) const -> backend::Global*
+		{
+			if (const auto result = globals.get(symbols.find(symbol));
+				result.has_value()) { return result->get(); }
+			return parent != nullptr ? parent->find_global(symbol) : nullptr;
 		}
 
-		auto report_duplicate_declaration(const char8_t* position, const symbol_name_type& identifier, const char* category) const -> void
+		[[nodiscard]] auto find_function(const symbol_name_view_type symbol) const -> backend::Function*
+		{
+			if (const auto result = functions.get(symbols.find(symbol));
+				result.has_value()) { return result->get(); }
+			return parent != nullptr ? parent->find_function(symbol) : nullptr;
+		}
+
+		template<typename... Operands>
+		auto emit(const backend::bytecode::opcode op, const Operands... operands) -> void { backend::bytecode::emit(current_block->code, op, static_cast<std::uint64_t>(operands)...); }
+
+		// The module and the symbol tables are kept, only the text changes.
+		auto replace_source(storage_type&& new_storage) -> void
+		{
+			storage = std::move(new_storage);
+			buffer = view_of(storage);
+			line_index = {};
+		}
+
+		auto record(const pending_diagnostic::kind_type kind, const char8_t* position, const symbol_name_view_type identifier, const char* category) -> void
+		{
+			++error_count;
+			++recorded_error_count;
+			if (pending_diagnostics.size() < max_errors) { pending_diagnostics.push_back({.kind = kind, .position = position, .symbol = symbols.intern(identifier), .category = category}); }
+		}
+
+		// lexy would count the lines from the beginning of the buffer for every diagnostic
+		[[nodiscard]] auto location_of(const char8_t* position) -> lexy::input_location<context_type>
+		{
+			if (line_index.empty()) { line_index = LineIndex{buffer.data(), buffer.data() + buffer.size()}; }
+
+			const auto line = line_index.line_of(position);
+			const lexy::input_location_anchor<context_type> anchor{context_type{line.begin, buffer.data() + buffer.size()}.reader().current(), line.number};
+			return lexy::get_input_location(buffer, position, anchor);
+		}
+
+		auto report_invalid_identifier(const char8_t* position, const symbol_name_view_type identifier, const char* category) -> void { record(pending_diagnostic::kind_type::invalid_identifier, position, identifier, category); }
+
+		auto report_conflicting_signature(const char8_t* position, const symbol_name_view_type identifier, const char* category) -> void { record(pending_diagnostic::kind_type::conflicting_signature, position, identifier, category); }
+
+		auto report_data_too_large(const char8_t* position, const symbol_name_view_type identifier, const char* category) -> void { record(pending_diagnostic::kind_type::data_too_large, position, identifier, category); }
+
+		auto report_duplicate_declaration(const char8_t* position, const symbol_name_view_type identifier, const char* category) -> void { record(pending_diagnostic::kind_type::duplicate_declaration, position, identifier, category); }
+
+		auto report_stack_error(const char8_t* position, const symbol_name_view_type identifier, const char* category, const backend::verifier::error_type error) -> void
 		{
-			const auto location = lexy::get_input_location(buffer, position, buffer_anchor);
+			using enum backend::verifier::error_type;
+			switch (error)
+			{
+				case malformed_code:
+				case operand_out_of_range: { return record(pending_diagnostic::kind_type::invalid_code, position, identifier, category); }
+				case stack_underflow: { return record(pending_diagnostic::kind_type::stack_underflow, position, identifier, category); }
+				case output_mismatch: { return record(pending_diagnostic::kind_type::output_mismatch, position, identifier, category); }
+				case unbalanced_branch: { return record(pending_diagnostic::kind_type::unbalanced_branch, position, identifier, category); }
+				case unbalanced_loop: { return record(pending_diagnostic::kind_type::unbalanced_loop, position, identifier, category); }
+				case entry_signature: { return record(pending_diagnostic::kind_type::conflicting_signature, position, identifier, category); }
+			}
+		}
 
-			const auto out = lexy::cfile_output_iterator{stderr};
+		// Renders the recorded diagnostics (in the order they were found) into `diagnostics`.
+		// Must be called while the source they point into is still alive.
+		auto render_diagnostics() -> void
+		{
+			const auto out = std::back_inserter(diagnostics);
 			const lexy_ext::diagnostic_writer<context_type> writer{buffer, {.flags = lexy::visualize_fancy}};
 
-			(void)writer.write_message(out,
-										lexy_ext::diagnostic_kind::error,
-										[&](lexy::cfile_output_iterator, lexy::visualization_options)
-										{
-											(void)std::fprintf(stderr, "duplicate %s declaration named '%s'", category, identifier.c_str());
-											return out;
-										});
-
-			if (!filename.empty()) { (void)writer.write_path(out, filename.c_str()); }
-
-			(void)writer.write_empty_annotation(out);
-			(void)writer.write_annotation(
-					out,
-					lexy_ext::annotation_kind::primary,
-					location,
-					identifier.size(),
-					[&](lexy::cfile_output_iterator, lexy::visualization_options)
-					{
-						(void)std::fprintf(stderr, "second declaration here");
-						return out;
-					});
+			for (const auto& pending: pending_diagnostics)
+			{
+				const auto identifier = symbols.name(pending.symbol);
+
+				(void)writer.write_message(out,
+											lexy_ext::diagnostic_kind::error,
+											[&](diagnostic_output_type o, lexy::visualization_options)
+											{
+												switch (pending.kind)
+												{
+													case pending_diagnostic::kind_type::invalid_identifier: { return fmt::format_to(o, "unknown {} name '{}'", pending.category, identifier); }
+													case pending_diagnostic::kind_type::conflicting_signature: { return fmt::format_to(o, "conflicting signature in {} declaration named '{}'", pending.category, identifier); }
+													case pending_diagnostic::kind_type::duplicate_declaration: { return fmt::format_to(o, "duplicate {} declaration named '{}'", pending.category, identifier); }
+													case pending_diagnostic::kind_type::data_too_large: { return fmt::format_to(o, "data too large in {} declaration named '{}'", pending.category, identifier); }
+													case pending_diagnostic::kind_type::invalid_code: { return fmt::format_to(o, "invalid code in {} declaration named '{}'", pending.category, identifier); }
+													case pending_diagnostic::kind_type::stack_underflow: { return fmt::format_to(o, "stack underflow in {} declaration named '{}'", pending.category, identifier); }
+													case pending_diagnostic::kind_type::output_mismatch: { return fmt::format_to(o, "wrong number of results in {} declaration named '{}'", pending.category, identifier); }
+													case pending_diagnostic::kind_type::unbalanced_branch: { return fmt::format_to(o, "unbalanced branches in {} declaration named '{}'", pending.category, identifier); }
+													case pending_diagnostic::kind_type::unbalanced_loop: { return fmt::format_to(o, "loop body without exactly one condition in {} declaration named '{}'", pending.category, identifier); }
+												}
+												return o;
+											});
+
+				if (!filename.empty()) { (void)writer.write_path(out, filename.c_str()); }
+
+				(void)writer.write_empty_annotation(out);
+				(void)writer.write_annotation(
+						out,
+						lexy_ext::annotation_kind::primary,
+						location_of(pending.position),
+						identifier.size(),
+						[&](diagnostic_output_type o, lexy::visualization_options)
+						{
+							switch (pending.kind)
+							{
+								case pending_diagnostic::kind_type::invalid_identifier: { return fmt::format_to(o, "used here"); }
+								case pending_diagnostic::kind_type::conflicting_signature:
+								case pending_diagnostic::kind_type::duplicate_declaration: { return fmt::format_to(o, "second declaration here"); }
+								default: { return fmt::format_to(o, "declared here"); }
+							}
+						});
+			}
+
+			if (const auto dropped = recorded_error_count - pending_diagnostics.size();
+				dropped != 0) { (void)fmt::format_to(out, "note: {} more error(s) not shown\n", dropped); }
+
+			pending_diagnostics.clear();
+			recorded_error_count = 0;
 		}
 	};
 }
@@ -275,15 +449,191 @@ namespace grammar
 {
 	namespace dsl = lexy::dsl;
 
+	// Length of the unquoted identifier (alpha/underscore/period, then alpha/digit/underscore/period) at `reader`, 0 if there is none.
+	template<typename Reader>
+	[[nodiscard]] auto scan_identifier(const Reader& reader) noexcept -> std::size_t
+	{
+		if constexpr (bounded_reader<Reader>)
+		{
+			const auto* begin = reader.position();
+			if (begin == reader.end() || (*begin >= u8'0' && *begin <= u8'9')) { return 0; }
+			return scanning::identifier_length(begin, reader.end());
+		}
+
+		// a reader lexy made up (e.g. for a sub-input), one character at a time
+		auto r = reader;
+		if (const auto c = static_cast<char8_t>(r.peek());
+			c >= u8'0' && c <= u8'9') { return 0; }
+
+		std::size_t length = 0;
+		for (; scanning::is_identifier_character(static_cast<char8_t>(r.peek())); r.bump()) { ++length; }
+		return length;
+	}
+
+	// Moves `reader` over `length` characters it was scanned for.
+	template<typename Reader>
+	auto advance(Reader& reader, const std::size_t length) noexcept -> void
+	{
+		if constexpr (bounded_reader<Reader>) { reader.skip(length); }
+		else
+		{
+			for (std::size_t i = 0; i < length; ++i) { reader.bump(); }
+		}
+	}
+
+	// identifier::unquoted, the characters are checked a vector at a time (see scanning::identifier_length)
+	struct unquoted_identifier_token : lexyd::token_base<unquoted_identifier_token>
+	{
+		template<typename Reader>
+		struct tp
+		{
+			typename Reader::marker end;
+
+			constexpr explicit tp(const Reader& reader)
+				: end{reader.current()} {}
+
+			auto try_parse(Reader reader) -> bool
+			{
+				const auto length = scan_identifier(reader);
+				if (length == 0) { return false; }
+
+				advance(reader, length);
+				end = reader.current();
+				return true;
+			}
+
+			template<typename Context>
+			auto report_error(Context& context, const Reader& reader) -> void
+			{
+				const lexy::error<Reader, lexy::expected_char_class> error{reader.position(), "identifier"};
+				context.on(lexy::parse_events::error{}, error);
+			}
+		};
+	};
+
+	// An unquoted identifier which is exactly `Keyword`, scanned like any other identifier and then classified.
+	template<scanning::keyword_type Keyword>
+	struct keyword_token : lexyd::token_base<keyword_token<Keyword>>
+	{
+		template<typename Reader>
+		struct tp
+		{
+			typename Reader::marker end;
+
+			constexpr explicit tp(const Reader& reader)
+				: end{reader.current()} {}
+
+			auto try_parse(Reader reader) -> bool
+			{
+				const auto length = scan_identifier(reader);
+
+				if constexpr (std::is_same_v<decltype(reader.position()), const char8_t*>)
+				{
+					if (scanning::classify_keyword({reader.position(), length}) != Keyword) { return false; }
+					advance(reader, length);
+				}
+				else
+				{
+					constexpr auto spelling = scanning::keyword_spelling(Keyword);
+					if (length != spelling.size()) { return false; }
+					for (const auto c: spelling)
+					{
+						if (static_cast<char8_t>(reader.peek()) != c) { return false; }
+						reader.bump();
+					}
+				}
+
+				end = reader.current();
+				return true;
+			}
+
+			template<typename Context>
+			auto report_error(Context& context, const Reader& reader) -> void
+			{
+				constexpr auto spelling = scanning::keyword_spelling(Keyword);
+				const lexy::error<Reader, lexy::expected_literal> error{reader.position(), spelling.data(), 0, spelling.size()};
+				context.on(lexy::parse_events::error{}, error);
+			}
+		};
+	};
+
+	template<scanning::keyword_type Keyword>
+	constexpr auto keyword = keyword_token<Keyword>{};
+
+	// Whitespace and complete `#` comments, a vector at a time (see scanning::whitespace_length).
+	struct whitespace_token : lexyd::token_base<whitespace_token>
+	{
+		template<typename Reader>
+		struct tp
+		{
+			typename Reader::marker end;
+
+			constexpr explicit tp(const Reader& reader)
+				: end{reader.current()} {}
+
+			auto try_parse(Reader reader) -> bool
+			{
+				std::size_t length = 0;
+				if constexpr (bounded_reader<Reader>) { length = scanning::whitespace_length(reader.position(), reader.end()); }
+				else
+				{
+					// a reader lexy made up (e.g. for a sub-input), spaces only, one at a time
+					for (auto r = reader; scanning::is_space(static_cast<char8_t>(r.peek())); r.bump()) { ++length; }
+				}
+				if (length == 0) { return false; }
+
+				advance(reader, length);
+				end = reader.current();
+				return true;
+			}
+
+			template<typename Context>
+			auto report_error(Context& context, const Reader& reader) -> void
+			{
+				const lexy::error<Reader, lexy::expected_char_class> error{reader.position(), "ASCII.space"};
+				context.on(lexy::parse_events::error{}, error);
+			}
+		};
+	};
+
+	// Names have no escape sequences, so even a quoted one is a single piece of the buffer and is handed out as a view into it.
+	// It is only copied when the module stores it.
+	struct as_name_view_type
+	{
+		using return_type = symbol_name_view_type;
+
+		struct sink_callback
+		{
+			using return_type = symbol_name_view_type;
+
+			const char8_t* begin = nullptr;
+			const char8_t* end = nullptr;
+
+			template<typename Reader>
+			auto operator()(const lexy::lexeme<Reader>& lexeme) noexcept -> void
+			{
+				if (begin == nullptr) { begin = lexeme.data(); }
+				end = lexeme.data() + lexeme.size();
+			}
+
+			[[nodiscard]] auto finish() && noexcept -> return_type { return {reinterpret_cast<const char*>(begin), static_cast<std::size_t>(end - begin)}; }
+		};
+
+		[[nodiscard]] auto sink() const noexcept -> sink_callback { return {}; }
+
+		// unquoted
+		template<typename Reader>
+		[[nodiscard]] auto operator()(const lexy::lexeme<Reader>& lexeme) const noexcept -> return_type { return {reinterpret_cast<const char*>(lexeme.data()), lexeme.size()}; }
+
+		// quoted, already finished by the sink
+		[[nodiscard]] auto operator()(const return_type name) const noexcept -> return_type { return name; }
+	};
+
+	constexpr as_name_view_type as_name_view{};
+
 	struct identifier
 	{
-		constexpr static auto unquoted =
-				dsl::identifier(
-						// begin with alpha/underscore/period
-						dsl::ascii::alpha_underscore / dsl::period,
-						// continue with alpha/digit/underscore/period
-						dsl::ascii::alpha_digit_underscore / dsl::period
-						);
+		constexpr static auto unquoted = dsl::capture(unquoted_identifier_token{});
 
 		constexpr static auto rule = []
 		{
@@ -296,19 +646,16 @@ namespace grammar
 			return unquoted | quoted;
 		}();
 
-		constexpr static auto value = lexy::as_string<symbol_name_type>;
+		constexpr static auto value = as_name_view;
 	};
 
-	// it shall be unquoted
-	#define BACKEND_KEYWORD(key) LEXY_KEYWORD(key, identifier::unquoted)
-
 	// special identifier
 	// $variable
 	struct builtin_identifier
 	{
 		constexpr static auto rule = dsl::dollar_sign >> dsl::p<identifier>;
 
-		constexpr static auto value = lexy::forward<symbol_name_type>;
+		constexpr static auto value = lexy::forward<symbol_name_view_type>;
 	};
 
 	// special identifier
@@ -317,7 +664,7 @@ namespace grammar
 	{
 		constexpr static auto rule = dsl::at_sign >> dsl::p<identifier>;
 
-		constexpr static auto value = lexy::forward<symbol_name_type>;
+		constexpr static auto value = lexy::forward<symbol_name_view_type>;
 	};
 
 	// special identifier
@@ -326,7 +673,7 @@ namespace grammar
 	{
 		constexpr static auto rule = dsl::percent_sign >> dsl::p<identifier>;
 
-		constexpr static auto value = lexy::forward<symbol_name_type>;
+		constexpr static auto value = lexy::forward<symbol_name_view_type>;
 	};
 
 	struct builtin_function_reference
@@ -334,12 +681,17 @@ namespace grammar
 		constexpr static auto rule = dsl::position(dsl::p<builtin_identifier>);
 
 		constexpr static auto value = ParseState::callback<backend::BuiltinFunction>(
-				[](const ParseState& state, const char8_t* position, const symbol_name_type& symbol) -> backend::BuiltinFunction
+				[](ParseState& state, const char8_t* position, const symbol_name_view_type symbol) -> backend::BuiltinFunction
 				{
-					const auto result = state.builtin_functions.get(symbol);
+					const auto* result = backend::builtin::functions.find(symbol);
 
-					if (!result.has_value()) { state.report_invalid_identifier(position, symbol, "builtin function"); }
-					return **result;
+					if (result == nullptr)
+					{
+						// keep going to report the other errors too, the parse fails anyway
+						state.report_invalid_identifier(position, symbol, "builtin function");
+						return backend::BuiltinFunction{};
+					}
+					return *result;
 				});
 	};
 
@@ -348,12 +700,16 @@ namespace grammar
 		constexpr static auto rule = dsl::position(dsl::p<builtin_identifier>);
 
 		constexpr static auto value = ParseState::callback<backend::BuiltinType>(
-				[](const ParseState& state, const char8_t* position, const symbol_name_type& symbol) -> backend::BuiltinType
+				[](ParseState& state, const char8_t* position, const symbol_name_view_type symbol) -> backend::BuiltinType
 				{
-					const auto result = state.builtin_types.get(symbol);
+					const auto* result = backend::builtin::types.find(symbol);
 
-					if (!result.has_value()) { state.report_invalid_identifier(position, symbol, "builtin type"); }
-					return **result;
+					if (result == nullptr)
+					{
+						state.report_invalid_identifier(position, symbol, "builtin type");
+						return backend::BuiltinType{};
+					}
+					return *result;
 				});
 	};
 
@@ -362,12 +718,12 @@ namespace grammar
 		constexpr static auto rule = dsl::position(dsl::p<global_identifier>);
 
 		constexpr static auto value = ParseState::callback<backend::Global*>(
-				[](const ParseState& state, const char8_t* position, const symbol_name_type& symbol) -> backend::Global*
+				[](ParseState& state, const char8_t* position, const symbol_name_view_type symbol) -> backend::Global*
 				{
-					const auto result = state.globals.get(symbol);
+					auto* result = state.find_global(symbol);
 
-					if (!result.has_value()) { state.report_invalid_identifier(position, symbol, "global"); }
-					return *result;
+					if (result == nullptr) { state.report_invalid_identifier(position, symbol, "global"); }
+					return result;
 				});
 	};
 
@@ -375,12 +731,16 @@ namespace grammar
 	{
 		constexpr static auto rule = dsl::position(dsl::p<local_identifier>);
 
-		constexpr static auto value = ParseState::callback<backend::Local*>(
-				[](const ParseState& state, const char8_t* position, const symbol_name_type& symbol) -> backend::Local*
+		constexpr static auto value = ParseState::callback<backend::slot_type>(
+				[](ParseState& state, const char8_t* position, const symbol_name_view_type symbol) -> backend::slot_type
 				{
-					const auto result = state.locals.get(symbol);
+					const auto result = state.locals.get(state.symbols.find(symbol));
 
-					if (!result.has_value()) { state.report_invalid_identifier(position, symbol, "local"); }
+					if (!result.has_value())
+					{
+						state.report_invalid_identifier(position, symbol, "local");
+						return backend::invalid_slot;
+					}
 					return *result;
 				});
 	};
@@ -407,35 +767,61 @@ namespace grammar
 		constexpr static auto rule =
 				dsl::position +
 				dsl::p<global_identifier> +
-				// todo: dsl::if_(dsl::p<function_signature>);
-				dsl::p<function_signature>;
+				dsl::if_(dsl::p<function_signature>);
 
 		constexpr static auto value = ParseState::callback<backend::Function*>(
 				// without signature
-				[](const ParseState& state, const char8_t* position, const symbol_name_type& symbol) -> backend::Function*
+				[](ParseState& state, const char8_t* position, const symbol_name_view_type symbol) -> backend::Function*
 				{
-					const auto result = state.functions.get(symbol);
+					auto* result = state.find_function(symbol);
 
-					if (!result.has_value()) { state.report_invalid_identifier(position, symbol, "function"); }
-					return *result;
+					if (result == nullptr) { state.report_invalid_identifier(position, symbol, "function"); }
+					return result;
 				},
-				// with signature
-				[](ParseState& state, const char8_t* position, const symbol_name_type& symbol, const backend::Function::signature& signature) -> backend::Function*
+				// with signature, declares the function if needed
+				[](ParseState& state, const char8_t* position, const symbol_name_view_type symbol, const backend::Function::signature& signature) -> backend::Function*
 				{
-					if (const auto result = state.functions.get(symbol);
-						result.has_value())
+					if (auto* result = state.find_function(symbol);
+						result != nullptr)
 					{
-						if (const auto [i, o] = result->get()->sig;
+						if (const auto [i, o] = result->sig;
 							i != signature.input || o != signature.output) { state.report_conflicting_signature(position, symbol, "function"); }
-						return *result;
+						return result;
 					}
 
 					auto* result = state.mod->register_function(symbol, signature);
-					state.functions.set(symbol, result);
+					state.functions.set(state.symbols.intern(symbol), result);
 					return result;
 				});
 	};
 
+	// %name of a block of the current function, it may be used before it is declared
+	struct block_reference
+	{
+		constexpr static auto rule = dsl::position(dsl::p<local_identifier>);
+
+		constexpr static auto value = ParseState::callback<backend::slot_type>(
+				[](ParseState& state, const char8_t* position, const symbol_name_view_type symbol) -> backend::slot_type
+				{
+					if (const auto result = state.blocks.get(state.symbols.find(symbol));
+						result.has_value()) { return *result; }
+
+					// the signature is filled in by the declaration, see block_declaration::header
+					const auto id = state.symbols.intern(symbol);
+					const auto* block = state.local_builder->register_block({.input = 0, .output = 0});
+					state.blocks.set(id, block->slot);
+					state.undeclared_blocks.push_back({.symbol = id, .position = position});
+					return block->slot;
+				});
+	};
+
+	struct integer_literal
+	{
+		constexpr static auto rule = dsl::sign + dsl::integer<std::int64_t>;
+
+		constexpr static auto value = lexy::as_integer<std::int64_t>;
+	};
+
 	struct data_expression
 	{
 		struct byte
@@ -443,14 +829,16 @@ namespace grammar
 			constexpr static auto rule = dsl::integer<std::uint8_t>(dsl::digits<dsl::hex>);
 
 			constexpr static auto value = lexy::callback<backend::data_type>(
-					[](const std::uint8_t d) { return backend::data_type{1, static_cast<backend::data_type::value_type>(d)}; });
+					[](const std::uint8_t d) { return backend::data_type{std::string(1, static_cast<char>(d))}; });
 		};
 
 		struct string
 		{
 			constexpr static auto rule = dsl::quoted(dsl::ascii::print);
 
-			constexpr static auto value = lexy::as_string<backend::data_type>;
+			constexpr static auto value =
+					lexy::as_string<std::string> >>
+					lexy::callback<backend::data_type>([](std::string&& s) { return backend::data_type{std::move(s)}; });
 		};
 
 		struct repetition
@@ -459,12 +847,7 @@ namespace grammar
 					dsl::square_bracketed(dsl::recurse<data_expression>) >> dsl::lit_c<'*'> + dsl::integer<backend::data_type::size_type>;
 
 			constexpr static auto value = lexy::callback<backend::data_type>(
-					[](const backend::data_type& data, const backend::data_type::size_type times)
-					{
-						backend::data_type result{};
-						for (backend::data_type::size_type i = 0; i < times; ++i) { result += data; }
-						return data;
-					});
+					[](backend::data_type&& data, const backend::data_type::size_type times) { return backend::data_type::repeat(std::move(data), times); });
 		};
 
 		constexpr static auto rule = dsl::list(dsl::p<byte> | dsl::p<string> | dsl::p<repetition>, dsl::sep(dsl::comma));
@@ -479,14 +862,20 @@ namespace grammar
 			constexpr static auto rule = []
 			{
 				constexpr auto declaration = dsl::p<global_identifier> + dsl::equal_sign + dsl::p<data_expression>;
-				return BACKEND_KEYWORD("const") >> dsl::position + declaration;
+				return keyword<scanning::keyword_type::const_> >> dsl::position + declaration;
 			}();
 
 			constexpr static auto value = ParseState::callback<void>(
-					[](ParseState& state, const char8_t* position, const symbol_name_type& symbol, backend::data_type&& data) -> void
+					[](ParseState& state, const char8_t* position, const symbol_name_view_type symbol, backend::data_type&& data) -> void
 					{
+						// still declared (empty) so that its uses do not report unknown names
+						if (data.too_large())
+						{
+							state.report_data_too_large(position, symbol, "global");
+							data = {};
+						}
 						if (auto* result = state.mod->register_global_mutable_data(symbol, std::forward<decltype(data)>(data));
-							!state.globals.set(symbol, result)) { state.report_duplicate_declaration(position, symbol, "global"); }
+							!state.globals.set(state.symbols.intern(symbol), result)) { state.report_duplicate_declaration(position, symbol, "global"); }
 					});
 		};
 
@@ -499,15 +888,21 @@ namespace grammar
 			}();
 
 			static constexpr auto value = ParseState::callback<void>(
-					[](ParseState& state, const char8_t* position, const symbol_name_type& symbol, backend::data_type&& data) -> void
+					[](ParseState& state, const char8_t* position, const symbol_name_view_type symbol, backend::data_type&& data) -> void
 					{
+						// still declared (empty) so that its uses do not report unknown names
+						if (data.too_large())
+						{
+							state.report_data_too_large(position, symbol, "global");
+							data = {};
+						}
 						if (auto* result = state.mod->register_global_immutable_data(symbol, std::forward<decltype(data)>(data));
-							!state.globals.set(symbol, result)) { state.report_duplicate_declaration(position, symbol, "global"); }
+							!state.globals.set(state.symbols.intern(symbol), result)) { state.report_duplicate_declaration(position, symbol, "global"); }
 					});
 		};
 
 		constexpr static auto rule =
-				BACKEND_KEYWORD("global") >>
+				keyword<scanning::keyword_type::global> >>
 				(dsl::p<mutable_global> | dsl::p<immutable_global>) +
 				// semicolon required ?
 				dsl::semicolon;
@@ -518,119 +913,294 @@ namespace grammar
 	struct local_declaration
 	{
 		constexpr static auto rule =
-				BACKEND_KEYWORD("local") >>
+				keyword<scanning::keyword_type::local> >>
 				dsl::position +
 				dsl::p<local_identifier> +
 				// semicolon required ?
 				dsl::semicolon;
 
 		constexpr static auto value = ParseState::callback<void>(
-				[](ParseState& state, const char8_t* position, const symbol_name_type& symbol) -> void
+				[](ParseState& state, const char8_t* position, const symbol_name_view_type symbol) -> void
 				{
 					if (auto* result = state.local_builder->register_local(symbol);
-						!state.locals.set(symbol, result)) { state.report_duplicate_declaration(position, symbol, "local"); }
+						!state.locals.set(state.symbols.intern(symbol), result->slot)) { state.report_duplicate_declaration(position, symbol, "local"); }
 				});
 	};
 
-	// todo
+	// Every instruction is encoded into the current block as soon as it is parsed, see bytecode.hpp.
+	// An operand that cannot be resolved is reported and its instruction dropped, the module is not usable anyway.
 	struct instruction
 	{
+		using opcode = backend::bytecode::opcode;
+
 		struct dummy
 		{
-			constexpr static auto rule = BACKEND_KEYWORD("dummy");
+			constexpr static auto rule = keyword<scanning::keyword_type::dummy>;
 
 			constexpr static auto value = ParseState::callback<void>(
-					[](const ParseState& state) { (void)state; }
+					[](ParseState& state) { state.emit(opcode::nop); }
 					);
 		};
 
-		constexpr static auto rule = dsl::p<dummy>;
+		// $add
+		struct builtin
+		{
+			constexpr static auto rule = dsl::peek(dsl::dollar_sign) >> dsl::p<builtin_function_reference>;
 
-		constexpr static auto value = lexy::forward<void>;
-	};
+			constexpr static auto value = ParseState::callback<void>(
+					[](ParseState& state, const backend::BuiltinFunction& function) { state.emit(backend::bytecode::builtin_opcode(function.id)); }
+					);
+		};
 
-	struct block_declaration
-	{
-		struct header
+		// push -42
+		struct push
 		{
-			constexpr static auto rule =
-					BACKEND_KEYWORD("block") +
-					dsl::p<local_identifier> +
-					dsl::p<function_signature>;
+			constexpr static auto rule = keyword<scanning::keyword_type::push> >> dsl::p<integer_literal>;
 
 			constexpr static auto value = ParseState::callback<void>(
-					[](ParseState& state, const symbol_name_type& symbol, const backend::Function::signature& signature) -> void
-					{
-						backend::Block* this_block;
-						if (const auto result = state.blocks.get(symbol);
-							result.has_value()) { this_block = result->get(); }
-						else
-						{
-							this_block = state.local_builder->register_block(signature);
-							if (!state.blocks.set(symbol, this_block))
-							{
-								// impossible ?
-							}
-						}
+					[](ParseState& state, const std::int64_t immediate) { backend::bytecode::emit_push(state.current_block->code, immediate); }
+					);
+		};
 
-						// build block here
-						(void)this_block;
-					});
+		// get %local
+		struct get
+		{
+			constexpr static auto rule = keyword<scanning::keyword_type::get> >> dsl::p<local_reference>;
+
+			constexpr static auto value = ParseState::callback<void>(
+					[](ParseState& state, const backend::slot_type local) { if (local != backend::invalid_slot) { state.emit(opcode::get, local); } }
+					);
 		};
 
-		constexpr static auto rule = dsl::p<header> + dsl::curly_bracketed.list(dsl::p<instruction>);
+		// set %local
+		struct set
+		{
+			constexpr static auto rule = keyword<scanning::keyword_type::set> >> dsl::p<local_reference>;
 
-		constexpr static auto value = lexy::forward<void>;
-	};
+			constexpr static auto value = ParseState::callback<void>(
+					[](ParseState& state, const backend::slot_type local) { if (local != backend::invalid_slot) { state.emit(opcode::set, local); } }
+					);
+		};
 
-	struct function_declaration
-	{
-		struct header
+		// address @global
+		struct address
 		{
-			constexpr static auto rule = dsl::position + dsl::p<global_identifier> + dsl::p<function_signature>;
+			constexpr static auto rule = keyword<scanning::keyword_type::address> >> dsl::p<global_reference>;
 
 			constexpr static auto value = ParseState::callback<void>(
-					[](ParseState& state, const char8_t* position, const symbol_name_type& symbol, const backend::Function::signature& signature) -> void
-					{
-						if (const auto result = state.functions.get(symbol);
-							result.has_value())
-						{
-							if (const auto [i, o] = result->get()->sig;
+					[](ParseState& state, const backend::Global* global) { if (global != nullptr) { state.emit(opcode::address, global->index); } }
+					);
+		};
+
+		// call @function [in=>out] / call %block
+		struct call
+		{
+			constexpr static auto rule =
+					keyword<scanning::keyword_type::call> >>
+					(dsl::peek(dsl::at_sign) >> dsl::p<function_reference> | dsl::else_ >> dsl::p<block_reference>);
+
+			constexpr static auto value = ParseState::callback<void>(
+					[](ParseState& state, const backend::Function* function)
+					{
+						if (function == nullptr) { return; }
+
+						state.emit(opcode::call, function->index);
+						state.callees.emplace(function->index, function);
+					},
+					[](ParseState& state, const backend::slot_type block) { state.emit(opcode::call_block, block); }
+					);
+		};
+
+		// if %then / if %then else %else
+		struct if_
+		{
+			constexpr static auto rule =
+					keyword<scanning::keyword_type::if_> >>
+					dsl::p<block_reference> +
+					dsl::opt(keyword<scanning::keyword_type::else_> >> dsl::p<block_reference>);
+
+			constexpr static auto value = ParseState::callback<void>(
+					[](ParseState& state, const backend::slot_type then, lexy::nullopt) { state.emit(opcode::if_, then); },
+					[](ParseState& state, const backend::slot_type then, const backend::slot_type otherwise) { state.emit(opcode::if_else, then, otherwise); }
+					);
+		};
+
+		// loop %body
+		struct loop
+		{
+			constexpr static auto rule = keyword<scanning::keyword_type::loop> >> dsl::p<block_reference>;
+
+			constexpr static auto value = ParseState::callback<void>(
+					[](ParseState& state, const backend::slot_type body) { state.emit(opcode::loop, body); }
+					);
+		};
+
+		constexpr static auto rule =
+				dsl::p<dummy> |
+				dsl::p<builtin> |
+				dsl::p<push> |
+				dsl::p<get> |
+				dsl::p<set> |
+				dsl::p<address> |
+				dsl::p<call> |
+				dsl::p<if_> |
+				dsl::p<loop>;
+
+		constexpr static auto value = lexy::forward<void>;
+	};
+
+	struct block_declaration
+	{
+		struct header
+		{
+			constexpr static auto rule =
+					keyword<scanning::keyword_type::block> +
+					dsl::position +
+					dsl::p<local_identifier> +
+					dsl::p<function_signature>;
+
+			constexpr static auto value = ParseState::callback<void>(
+					[](ParseState& state, const char8_t* position, const symbol_name_view_type symbol, const backend::Function::signature& signature) -> void
+					{
+						const auto id = state.symbols.intern(symbol);
+						if (const auto result = state.blocks.get(id);
+							!result.has_value())
+						{
+							state.current_block = state.local_builder->register_block(signature);
+							state.blocks.set(id, state.current_block->slot);
+							state.set_block_site(state.current_block->slot, {.position = position, .symbol = id, .category = "block"});
+							return;
+						}
+						else if (const auto it = std::ranges::find(state.undeclared_blocks, id, &ParseState::undeclared_block::symbol);
+							it != state.undeclared_blocks.end())
+						{
+							// used before, declared now
+							state.current_block = state.current_function->blocks[result->get()];
+							state.current_block->sig = signature;
+							state.undeclared_blocks.erase(it);
+							state.set_block_site(state.current_block->slot, {.position = position, .symbol = id, .category = "block"});
+							return;
+						}
+
+						state.report_duplicate_declaration(position, symbol, "block");
+						// keep the instructions apart from the first declaration
+						state.current_block = state.local_builder->register_block(signature);
+					});
+		};
+
+		constexpr static auto rule = dsl::p<header> + dsl::curly_bracketed.list(dsl::p<instruction>);
+
+		constexpr static auto value = lexy::forward<void>;
+	};
+
+	struct function_declaration
+	{
+		struct header
+		{
+			constexpr static auto rule = dsl::position + dsl::p<global_identifier> + dsl::p<function_signature>;
+
+			constexpr static auto value = ParseState::callback<void>(
+					[](ParseState& state, const char8_t* position, const symbol_name_view_type symbol, const backend::Function::signature& signature) -> void
+					{
+						if (const auto result = state.functions.get(state.symbols.find(symbol));
+							result.has_value())
+						{
+							if (const auto [i, o] = result->get()->sig;
 								i != signature.input || o != signature.output) { state.report_conflicting_signature(position, symbol, "function"); }
-							state.current_function = result->get();
+							state.begin_function(*result->get(), position);
 						}
 						else
 						{
 							auto* new_result = state.mod->register_function(symbol, signature);
-							if (!state.functions.set(symbol, new_result))
+							if (!state.functions.set(state.symbols.intern(symbol), new_result))
 							{
 								// impossible ?
 							}
-							state.current_function = new_result;
+							state.begin_function(*new_result, position);
 						}
+					});
+		};
+
+		// The header of a function parsed apart from the others (see parse_file_parallel), always a new function.
+		// The declaration was already checked against the others by `header`.
+		struct detached_header
+		{
+			constexpr static auto rule = dsl::position + dsl::p<global_identifier> + dsl::p<function_signature>;
 
-						// clear blocks && locals
-						state.locals.clear();
-						state.blocks.clear();
+			constexpr static auto value = ParseState::callback<void>(
+					[](ParseState& state, const char8_t* position, const symbol_name_view_type symbol, const backend::Function::signature& signature) -> void { state.begin_function(*state.mod->register_function(symbol, signature), position); });
+		};
+
+		// The header of a function declared earlier by `header` (see LazyModule), its body is parsed now.
+		struct attached_header
+		{
+			constexpr static auto rule = dsl::position + dsl::p<global_identifier> + dsl::p<function_signature>;
+
+			constexpr static auto value = ParseState::callback<void>(
+					[](ParseState& state, const char8_t* position, const symbol_name_view_type symbol, const backend::Function::signature& signature) -> void
+					{
+						if (const auto result = state.functions.get(state.symbols.find(symbol));
+							result.has_value()) { state.begin_function(*result->get(), position); }
+						else
+						{
+							auto* function = state.mod->register_function(symbol, signature);
+							state.functions.set(state.symbols.intern(symbol), function);
+							state.begin_function(*function, position);
+						}
 					});
 		};
 
 		struct body
 		{
+			// A function has a single body, the first one is kept as it is and a second one is reported (see duplicate_body).
+			static auto begin_body(ParseState& state) -> void
+			{
+				const auto& function = *state.current_function;
+				if (function.blocks.empty() && function.locals.empty()) { return; }
+
+				state.report_duplicate_declaration(state.function_position, function.name, "function");
+				state.begin_function(state.duplicate_body.emplace(function.sig, function.name, function.index), state.function_position);
+			}
+
 			static auto create_block_entry(ParseState& state) -> void
 			{
-				auto* block = state.local_builder->register_block(state.current_function->sig);
+				state.current_block = state.local_builder->register_block(state.current_function->sig);
+				state.blocks.set(state.block_entry_symbol, state.current_block->slot);
+				state.set_block_site(state.current_block->slot, {.position = state.function_position, .symbol = state.symbols.intern(state.current_function->name), .category = "function"});
+			}
+
+			// every block used by the instructions must be declared by now
+			static auto check_blocks(ParseState& state) -> void
+			{
+				for (const auto& [symbol, position]: state.undeclared_blocks) { state.report_invalid_identifier(position, state.symbols.name(symbol), "block"); }
+				state.undeclared_blocks.clear();
+			}
+
+			// Every block must honour its signature, see backend::verifier.
+			// A body with other errors is not checked, its code is incomplete and would only be reported again.
+			static auto verify_blocks(ParseState& state) -> void
+			{
+				if (state.error_mark() != state.function_error_mark) { return; }
 
-				// build block here
-				(void)block;
+				const auto callee = [&state](const std::uint64_t index) -> std::optional<backend::Function::signature>
+				{
+					if (const auto it = state.callees.find(static_cast<backend::index_type>(index));
+						it != state.callees.end()) { return it->second->sig; }
+					return std::nullopt;
+				};
 
-				state.blocks.set("@block_entry@", block);
+				if (const auto error = backend::verifier::verify_function(*state.current_function, state.global_count(), callee);
+					error.has_value())
+				{
+					const auto& site = state.block_sites[error->block];
+					state.report_stack_error(site.position, state.symbols.name(site.symbol), site.category, error->type);
+				}
 			}
 
 			constexpr static auto rule = []
 			{
 				constexpr auto block_list =
-						dsl::peek(BACKEND_KEYWORD("block")) >>
+						dsl::peek(keyword<scanning::keyword_type::block>) >>
 						dsl::curly_bracketed.as_terminator().list(dsl::p<block_declaration>);
 
 				constexpr auto instruction_list =
@@ -641,8 +1211,11 @@ namespace grammar
 						dsl::if_(dsl::list(dsl::p<local_declaration>));
 
 				return dsl::curly_bracketed.open() >>
+						dsl::effect<begin_body> +
 						locals +
-						(block_list | dsl::else_ >> instruction_list);
+						(block_list | dsl::else_ >> instruction_list) +
+						dsl::effect<check_blocks> +
+						dsl::effect<verify_blocks>;
 			}();
 
 			constexpr static auto value =
@@ -656,7 +1229,7 @@ namespace grammar
 		};
 
 		constexpr static auto rule =
-				BACKEND_KEYWORD("function") >>
+				keyword<scanning::keyword_type::function> >>
 				dsl::p<header> +
 				(dsl::semicolon | dsl::p<body>);
 
@@ -666,24 +1239,24 @@ namespace grammar
 	struct module_declaration
 	{
 		constexpr static auto whitespace =
-				// space
-				dsl::ascii::space |
-				// comment
+				// space and comments
+				whitespace_token{} |
+				// a comment at the end of the input (without a newline), reported as before
 				dsl::hash_sign >> dsl::until(dsl::newline);
 
 		struct header
 		{
 			constexpr static auto rule =
-					BACKEND_KEYWORD("module") +
+					keyword<scanning::keyword_type::module_> +
 					dsl::p<global_identifier> +
 					// semicolon required ?
 					dsl::semicolon;
 
 			constexpr static auto value = ParseState::callback<void>(
-					[](ParseState& state, symbol_name_type&& symbol) -> void
+					[](ParseState& state, const symbol_name_view_type symbol) -> void
 					{
 						// create a module
-						state.mod = new backend::Module{std::forward<decltype(symbol)>(symbol)};
+						state.create_module(symbol_name_type{symbol});
 					});
 		};
 
@@ -693,36 +1266,1002 @@ namespace grammar
 
 		constexpr static auto value = lexy::forward<void>;
 	};
+
+	// A single top-level declaration cut out of a module, see IncrementalParser.
+	struct declaration_fragment
+	{
+		constexpr static auto whitespace = module_declaration::whitespace;
+
+		constexpr static auto rule = (dsl::p<global_declaration> | dsl::p<function_declaration>) + dsl::eof;
+
+		constexpr static auto value = lexy::forward<void>;
+	};
+
+	// The header of a function declaration cut out of a module, the rest is left to function_body_fragment.
+	struct function_header_fragment
+	{
+		constexpr static auto whitespace = module_declaration::whitespace;
+
+		constexpr static auto rule = keyword<scanning::keyword_type::function> >> dsl::p<function_declaration::header> + dsl::any;
+
+		constexpr static auto value = lexy::forward<void>;
+	};
+
+	// A whole function declaration cut out of a module, the function itself was declared by function_header_fragment.
+	struct function_body_fragment_of_declared
+	{
+		constexpr static auto whitespace = module_declaration::whitespace;
+
+		constexpr static auto rule =
+				keyword<scanning::keyword_type::function> >>
+				dsl::p<function_declaration::attached_header> +
+				(dsl::semicolon | dsl::p<function_declaration::body>) +
+				dsl::eof;
+
+		constexpr static auto value = lexy::forward<void>;
+	};
+
+	// A whole function declaration cut out of a module, parsed into a state of its own.
+	struct function_body_fragment
+	{
+		constexpr static auto whitespace = module_declaration::whitespace;
+
+		constexpr static auto rule =
+				keyword<scanning::keyword_type::function> >>
+				dsl::p<function_declaration::detached_header> +
+				(dsl::semicolon | dsl::p<function_declaration::body>) +
+				dsl::eof;
+
+		constexpr static auto value = lexy::forward<void>;
+	};
+}
+
+namespace
+{
+	// The top-level structure of a module, found without parsing it.
+	struct ModuleOutline
+	{
+		struct declaration
+		{
+			enum class kind_type
+			{
+				global,
+				function,
+			};
+
+			kind_type kind;
+			// [begin, end) covers the keyword up to the closing `;` or `}`
+			const char8_t* begin;
+			const char8_t* end;
+			symbol_name_view_type name;
+		};
+
+		symbol_name_view_type module_name;
+		// [begin, end) of `module @name;`
+		const char8_t* header_begin;
+		const char8_t* header_end;
+
+		std::vector<declaration> declarations;
+	};
+
+	// Splits a module into its top-level declarations with a brace-matching scan (quotes and comments are skipped).
+	// It only checks the shape, anything unexpected makes it give up so that the real grammar can report the error.
+	class OutlineScanner final
+	{
+	public:
+		using char_type = char8_t;
+
+	private:
+		const char_type* current_;
+		const char_type* end_;
+
+		[[nodiscard]] constexpr static auto is_space(const char_type c) noexcept -> bool { return c == u8' ' || c == u8'\t' || c == u8'\n' || c == u8'\r' || c == u8'\f' || c == u8'\v'; }
+
+		[[nodiscard]] constexpr static auto is_identifier(const char_type c) noexcept -> bool
+		{
+			return (c >= u8'a' && c <= u8'z') || (c >= u8'A' && c <= u8'Z') || (c >= u8'0' && c <= u8'9') || c == u8'_' || c == u8'.';
+		}
+
+		[[nodiscard]] static auto view(const char_type* begin, const char_type* end) noexcept -> symbol_name_view_type { return {reinterpret_cast<const char*>(begin), static_cast<std::size_t>(end - begin)}; }
+
+		auto skip_comment() noexcept -> void
+		{
+			while (current_ != end_ && *current_ != u8'\n') { ++current_; }
+		}
+
+		auto skip_trivia() noexcept -> void
+		{
+			while (current_ != end_)
+			{
+				if (is_space(*current_)) { ++current_; }
+				else if (*current_ == u8'#') { skip_comment(); }
+				else { break; }
+			}
+		}
+
+		// returns false if the quote is not closed
+		auto skip_quoted(const char_type quote) noexcept -> bool
+		{
+			// opening quote
+			++current_;
+			while (current_ != end_ && *current_ != quote) { ++current_; }
+			if (current_ == end_) { return false; }
+			// closing quote
+			++current_;
+			return true;
+		}
+
+		auto scan_word() noexcept -> symbol_name_view_type
+		{
+			const auto* begin = current_;
+			while (current_ != end_ && is_identifier(*current_)) { ++current_; }
+			return view(begin, current_);
+		}
+
+		// @name or @'name'
+		auto scan_global_name() noexcept -> std::optional<symbol_name_view_type>
+		{
+			if (current_ == end_ || *current_ != u8'@') { return std::nullopt; }
+			++current_;
+
+			if (current_ != end_ && *current_ == u8'\'')
+			{
+				const auto* begin = current_ + 1;
+				if (!skip_quoted(u8'\'')) { return std::nullopt; }
+				return view(begin, current_ - 1);
+			}
+
+			if (auto name = scan_word();
+				!name.empty()) { return name; }
+			return std::nullopt;
+		}
+
+		// up to (and including) the `;` at the top level, or the `}` that closes the first `{`
+		auto skip_declaration() noexcept -> bool
+		{
+			std::size_t depth = 0;
+			while (current_ != end_)
+			{
+				switch (*current_)
+				{
+					case u8'"':
+					case u8'\'':
+					{
+						if (!skip_quoted(*current_)) { return false; }
+						break;
+					}
+					case u8'#':
+					{
+						skip_comment();
+						break;
+					}
+					case u8'{':
+					{
+						++depth;
+						++current_;
+						break;
+					}
+					case u8'}':
+					{
+						if (depth == 0) { return false; }
+						++current_;
+						if (--depth == 0) { return true; }
+						break;
+					}
+					case u8';':
+					{
+						++current_;
+						if (depth == 0) { return true; }
+						break;
+					}
+					default:
+					{
+						++current_;
+						break;
+					}
+				}
+			}
+			return false;
+		}
+
+	public:
+		OutlineScanner(const char_type* begin, const char_type* end) noexcept
+			: current_{begin},
+			end_{end} {}
+
+		[[nodiscard]] auto scan() -> std::optional<ModuleOutline>
+		{
+			ModuleOutline outline{};
+
+			skip_trivia();
+			outline.header_begin = current_;
+			if (scan_word() != "module") { return std::nullopt; }
+			skip_trivia();
+			if (const auto name = scan_global_name();
+				name.has_value()) { outline.module_name = *name; }
+			else { return std::nullopt; }
+			skip_trivia();
+			if (current_ == end_ || *current_ != u8';') { return std::nullopt; }
+			outline.header_end = ++current_;
+
+			while (true)
+			{
+				skip_trivia();
+				if (current_ == end_) { return outline; }
+
+				const auto* begin = current_;
+				const auto keyword = scan_word();
+
+				ModuleOutline::declaration::kind_type kind;
+				if (keyword == "global") { kind = ModuleOutline::declaration::kind_type::global; }
+				else if (keyword == "function") { kind = ModuleOutline::declaration::kind_type::function; }
+				else { return std::nullopt; }
+
+				skip_trivia();
+				if (kind == ModuleOutline::declaration::kind_type::global)
+				{
+					// global const @name
+					const auto* checkpoint = current_;
+					if (scan_word() == "const") { skip_trivia(); }
+					else { current_ = checkpoint; }
+				}
+
+				const auto name = scan_global_name();
+				if (!name.has_value() || !skip_declaration()) { return std::nullopt; }
+
+				outline.declarations.push_back({.kind = kind, .begin = begin, .end = current_, .name = *name});
+			}
+		}
+	};
+
+	// see io::SourceFile
+	auto open_source(const char* filename) -> std::optional<ParseState::storage_type>
+	{
+		if (auto file = io::SourceFile::open(filename);
+			file) { return ParseState::storage_type{*std::move(file)}; }
+
+		return std::nullopt;
+	}
+
+	auto parse_buffer(std::string&& filename, ParseState::storage_type&& storage, const std::size_t max_errors = frontend::no_error_limit) -> frontend::ParseResult
+	{
+		ParseState state{std::move(filename), std::move(storage), max_errors};
+		auto result = lexy::parse<grammar::module_declaration>(
+				state.input(),
+				state,
+				lexy_ext::report_error.opts({.flags = lexy::visualize_fancy}).path(state.filename.c_str()).to(std::back_inserter(state.diagnostics)));
+		state.render_diagnostics();
+
+		if (!result.has_value())
+		{
+			// the local builder refers to the module, destroy it first
+			state.local_builder.reset();
+			// destroy the module (and every object it owns)
+			state.mod.reset();
+		}
+
+		return {
+				.filename = std::move(state.filename),
+				.module = std::move(state.mod),
+				.diagnostics = std::move(state.diagnostics),
+				.error_count = state.error_count + result.error_count()};
+	}
+
+	// Parses one declaration of the outline of `state.buffer`, false if it could not be parsed at all.
+	template<typename Production>
+	auto parse_fragment(ParseState& state, const ModuleOutline::declaration& declaration) -> bool
+	{
+		// positions (and so the diagnostics) stay relative to the whole module
+		const auto input = state.input(declaration.begin, declaration.end);
+
+		const auto result = lexy::parse<Production>(
+				input,
+				state,
+				lexy_ext::report_error.opts({.flags = lexy::visualize_fancy}).path(state.filename.c_str()).to(std::back_inserter(state.diagnostics)));
+		state.error_count += result.error_count();
+		return result.has_value();
+	}
+
+	// below that many functions a module is parsed on the calling thread only
+	constexpr std::size_t parallel_function_threshold = 64;
+
+	// Globals and function headers are parsed in order on the calling thread (they declare the symbols),
+	// then the functions are parsed again in chunks on the pool, each chunk into a module of its own,
+	// and their locals and blocks are finally moved over to the real functions, in source order.
+	// The chunks resolve globals and functions through the state of the calling thread (read-only by then),
+	// so the instructions already refer to the indices of the real module.
+	auto parse_buffer_parallel(
+			std::string&& filename,
+			ParseState::storage_type&& storage,
+			concurrency::ThreadPool& pool,
+			const std::size_t max_errors
+			) -> frontend::ParseResult
+	{
+		// the outline points into the storage, which keeps its address when moved into the state
+		const auto view = ParseState::view_of(storage);
+		const auto outline = OutlineScanner{view.data(), view.data() + view.size()}.scan();
+
+		std::vector<const ModuleOutline::declaration*> functions{};
+		if (outline.has_value())
+		{
+			for (const auto& declaration: outline->declarations)
+			{
+				if (declaration.kind == ModuleOutline::declaration::kind_type::function) { functions.push_back(&declaration); }
+			}
+		}
+		// let the grammar find (and report) a broken outline
+		if (functions.size() < parallel_function_threshold) { return parse_buffer(std::move(filename), std::move(storage), max_errors); }
+
+		ParseState state{std::move(filename), std::move(storage), max_errors};
+		state.create_module(symbol_name_type{outline->module_name});
+
+		// a declaration which cannot be parsed at all invalidates the module, like it does for parse_buffer
+		bool failed = false;
+
+		// declarations
+		for (const auto& declaration: outline->declarations)
+		{
+			const auto parsed =
+					declaration.kind == ModuleOutline::declaration::kind_type::global
+						? parse_fragment<grammar::declaration_fragment>(state, declaration)
+						: parse_fragment<grammar::function_header_fragment>(state, declaration);
+			failed = failed || !parsed;
+		}
+
+		// The chunks cannot see each other, a function with two bodies is left to the serial grammar, which reports it.
+		{
+			SymbolTable<bool> bodies{};
+			for (const auto* declaration: functions)
+			{
+				if (*(declaration->end - 1) == u8'}' && !bodies.set(state.symbols.intern(declaration->name), true))
+				{
+					return parse_buffer(std::move(state.filename), ParseState::storage_type{std::move(state.storage)}, max_errors);
+				}
+			}
+		}
+
+		// bodies
+		struct chunk_type
+		{
+			std::size_t begin;
+			std::size_t end;
+			std::unique_ptr<ParseState> state;
+			bool failed;
+		};
+
+		const auto chunk_count = std::min(functions.size(), pool.size() * 4);
+		std::vector<chunk_type> chunks(chunk_count);
+		for (std::size_t i = 0; i < chunk_count; ++i)
+		{
+			chunks[i].begin = functions.size() * i / chunk_count;
+			chunks[i].end = functions.size() * (i + 1) / chunk_count;
+		}
+
+		pool.parallel_for(
+				chunk_count,
+				[&](const std::size_t index)
+				{
+					auto& chunk = chunks[index];
+					chunk.state = std::make_unique<ParseState>(std::string{state.filename}, ParseState::storage_type{state.buffer}, max_errors);
+					chunk.failed = false;
+
+					auto& s = *chunk.state;
+					s.create_module(symbol_name_type{outline->module_name});
+					s.parent = &state;
+
+					for (auto i = chunk.begin; i != chunk.end; ++i) { chunk.failed = !parse_fragment<grammar::function_body_fragment>(s, *functions[i]) || chunk.failed; }
+
+					s.render_diagnostics();
+				});
+
+		// A call with a signature declared a function no header knows about, it only exists in the module of its chunk.
+		// Rare enough to simply parse the whole module again.
+		if (std::ranges::any_of(chunks, [](const chunk_type& chunk) { return chunk.state->mod->functions().size() != chunk.end - chunk.begin; }))
+		{
+			chunks.clear();
+			return parse_buffer(std::move(state.filename), ParseState::storage_type{std::move(state.storage)}, max_errors);
+		}
+
+		// merge, in source order
+		state.render_diagnostics();
+		for (auto& chunk: chunks)
+		{
+			auto& s = *chunk.state;
+			state.diagnostics += s.diagnostics;
+			state.error_count += s.error_count;
+			failed = failed || chunk.failed;
+			if (failed) { continue; }
+
+			s.mod->functions().for_each(
+					[&](const backend::Function& detached)
+					{
+						// declared by its header above
+						const auto function = state.functions.get(state.symbols.find(detached.name));
+						if (!function.has_value()) { return; }
+
+						state.local_builder->begin_function(*function->get());
+						// the slots come out the same, they are given in declaration order
+						for (const auto* local: detached.locals) { (void)state.local_builder->register_local(local->name); }
+						for (auto* block: detached.blocks) { state.local_builder->register_block(block->sig)->code = std::move(block->code); }
+					});
+		}
+
+		if (failed)
+		{
+			state.local_builder.reset();
+			state.mod.reset();
+		}
+
+		return {
+				.filename = std::move(state.filename),
+				.module = std::move(state.mod),
+				.diagnostics = std::move(state.diagnostics),
+				.error_count = state.error_count};
+	}
 }
 
 namespace frontend
 {
+	auto parse_file(const std::string_view filename, const std::size_t max_errors) -> ParseResult
+	{
+		std::string name{filename};
+		auto source = open_source(name.c_str());
+
+		if (!source) { return {.filename = std::move(name), .module = nullptr, .diagnostics = fmt::format("error: cannot read file '{}'\n", filename), .error_count = 1}; }
+
+		return parse_buffer(std::move(name), *std::move(source), max_errors);
+	}
+
+	auto parse_source(const std::string_view filename, const std::u8string_view source, const std::size_t max_errors) -> ParseResult
+	{
+		return parse_buffer(std::string{filename}, lexy::buffer<lexy::utf8_encoding>{source.data(), source.size()}, max_errors);
+	}
+
+	auto parse_file_parallel(const std::string_view filename, concurrency::ThreadPool& pool, const std::size_t max_errors) -> ParseResult
+	{
+		std::string name{filename};
+		auto source = open_source(name.c_str());
+
+		if (!source) { return {.filename = std::move(name), .module = nullptr, .diagnostics = fmt::format("error: cannot read file '{}'\n", filename), .error_count = 1}; }
+
+		return parse_buffer_parallel(std::move(name), *std::move(source), pool, max_errors);
+	}
+
+	auto parse_files(const std::span<const std::string> filenames, concurrency::ThreadPool& pool, const std::size_t max_errors) -> std::vector<ParseResult>
+	{
+		std::vector<ParseResult> results(filenames.size());
+
+		// every task writes its own slot only
+		pool.parallel_for(
+				filenames.size(),
+				[&](const std::size_t index) { results[index] = parse_file(filenames[index], max_errors); });
+
+		return results;
+	}
+
+	auto parse_files(const std::span<const std::string> filenames, const std::size_t max_errors) -> std::vector<ParseResult>
+	{
+		concurrency::ThreadPool pool{};
+		return parse_files(filenames, pool, max_errors);
+	}
+
+	auto print_diagnostics(const std::span<const ParseResult> results) -> void
+	{
+		for (const auto& result: results)
+		{
+			if (!result.diagnostics.empty()) { (void)std::fwrite(result.diagnostics.data(), 1, result.diagnostics.size(), stderr); }
+		}
+	}
+
 	auto parse_file_and_print(const std::string_view filename) -> void
 	{
-		auto file = lexy::read_file<lexy::utf8_encoding>(filename.data());
+		std::string name{filename};
+		auto source = open_source(name.c_str());
 
-		if (!file)
+		if (!source)
 		{
 			// todo
 			throw std::exception{"Cannot read file!"};
 		}
 
-		ParseState state{std::string{filename}, std::move(file).buffer()};
-		auto result = lexy::parse<grammar::module_declaration>(state.buffer, state, lexy_ext::report_error.opts({.flags = lexy::visualize_fancy}).path(state.filename.c_str()));
+		const auto result = parse_buffer(std::move(name), *std::move(source));
+		print_diagnostics({&result, 1});
 
-		if (!result.has_value())
+		// use result?
+
+		// return module?
+	}
+
+	ModuleCache::ModuleCache(std::filesystem::path directory)
+		: directory_{std::move(directory)} {}
+
+	auto ModuleCache::parse_file(const std::string_view filename) const -> CachedParseResult
+	{
+		std::string name{filename};
+		auto source = open_source(name.c_str());
+
+		if (!source) { return {.filename = std::move(name), .module = std::nullopt, .diagnostics = fmt::format("error: cannot read file '{}'\n", filename), .error_count = 1, .cache_hit = false}; }
+
+		const auto text = ParseState::view_of(*source);
+		const auto source_hash = hashing::stable_hash(text.data(), text.size());
+		const std::uint64_t source_size = text.size();
+		const auto path = (directory_ / fmt::format("{:016x}.ctpm", source_hash)).string();
+
+		// the name already contains the hash, the size guards against collisions
+		if (auto cached = backend::CompiledModule::open(path.c_str());
+			cached.has_value() && cached->source_hash() == source_hash && cached->source_size() == source_size)
+		{
+			return {.filename = std::move(name), .module = std::move(cached), .diagnostics = {}, .error_count = 0, .cache_hit = true};
+		}
+
+		auto result = parse_buffer(std::move(name), *std::move(source));
+		if (!result.succeeded()) { return {.filename = std::move(result.filename), .module = std::nullopt, .diagnostics = std::move(result.diagnostics), .error_count = result.error_count, .cache_hit = false}; }
+
+		auto image = backend::serialize(*result.module, source_hash, source_size);
+
+		// best effort, a read-only cache only costs the next run a parse
+		std::error_code error{};
+		std::filesystem::create_directories(directory_, error);
+		(void)backend::write_compiled_module(image, path.c_str());
+
+		return {.filename = std::move(result.filename), .module = backend::CompiledModule::from_bytes(std::move(image)), .diagnostics = std::move(result.diagnostics), .error_count = 0, .cache_hit = false};
+	}
+
+	struct IncrementalParser::state_type
+	{
+		using kind_type = ModuleOutline::declaration::kind_type;
+
+		struct cached_declaration
 		{
-			if (state.mod)
+			std::size_t hash;
+			// [offset, offset + length) of the source it was cached from, compared to the new text before it is reused
+			std::size_t offset;
+			std::size_t length;
+			kind_type kind;
+			symbol_id symbol;
+			// a function declaration with a body (not only `function @f [1=>1];`)
+			bool body;
+			// only declarations parsed without any error are reused
+			bool valid;
+		};
+
+		// the module of the previous parse, the unchanged declarations are copied from it
+		struct previous_type
+		{
+			// the text the declarations were cached from
+			ParseState::storage_type storage;
+			std::u8string_view source;
+
+			std::unique_ptr<backend::Module> mod;
+			SymbolTable<backend::Function*> functions;
+			SymbolTable<backend::Global*> globals;
+			// index => object
+			std::vector<const backend::Function*> function_at;
+			std::vector<const backend::Global*> global_at;
+		};
+
+		std::string filename;
+		std::size_t max_errors;
+		std::unique_ptr<ParseState> state;
+
+		// text of `module @name;`, empty if nothing can be reused
+		std::u8string header;
+		std::vector<cached_declaration> declarations;
+
+		// Copies an unchanged declaration from the previous module, as parsing it again would declare it.
+		// The operands of its code refer to the previous indices, they are looked up again by name.
+		// False (and nothing is copied) if it depends on a symbol that is not declared the same way (yet), its text is parsed again then
+		// so that the errors are reported.
+		auto copy(const cached_declaration& cached, const previous_type& previous) -> bool
+		{
+			auto& s = *state;
+
+			if (cached.kind == kind_type::global)
 			{
-				// destroy the module
-				delete state.mod;
-				state.mod = nullptr;
+				const auto global = previous.globals.get(cached.symbol);
+				if (!global.has_value() || s.globals.get(cached.symbol).has_value()) { return false; }
+
+				const auto& data = global->get()->data;
+				backend::Global* result;
+				if (global->get()->kind == backend::Global::kind_type::mutable_data) { result = s.mod->register_global_mutable_data(global->get()->name, backend::data_type{data}); }
+				else
+				{
+					// interned again as the payload itself, not as a data around it
+					const auto* payload = data.payload();
+					result = s.mod->register_global_immutable_data(global->get()->name, backend::data_type{payload != nullptr ? *payload : data});
+				}
+				s.globals.set(cached.symbol, result);
+				return true;
 			}
+
+			const auto previous_function = previous.functions.get(cached.symbol);
+			if (!previous_function.has_value()) { return false; }
+			const auto& function = *previous_function->get();
+
+			const auto existing = s.functions.get(cached.symbol);
+			auto* target = existing.has_value() ? existing->get() : nullptr;
+			if (target != nullptr && (target->sig.input != function.sig.input || target->sig.output != function.sig.output)) { return false; }
+
+			if (cached.body)
+			{
+				// a second body, let the parse report it
+				if (target != nullptr && (!target->blocks.empty() || !target->locals.empty())) { return false; }
+
+				// registered below if needed, nothing else is registered in between
+				const auto self_index = target != nullptr ? target->index : static_cast<backend::index_type>(s.mod->functions().size());
+
+				std::vector<backend::bytecode::code_type> codes(function.blocks.size());
+				for (std::size_t slot = 0; slot < function.blocks.size(); ++slot)
+				{
+					bool resolved = true;
+					const auto decoded = backend::bytecode::rewrite_operands(
+							function.blocks[slot]->code,
+							codes[slot],
+							[&](const backend::bytecode::opcode op, std::size_t, const std::uint64_t operand) -> std::uint64_t
+							{
+								if (op == backend::bytecode::opcode::call)
+								{
+									const auto* callee = operand < previous.function_at.size() ? previous.function_at[operand] : nullptr;
+									if (callee == &function) { return self_index; }
+
+									const auto now = callee != nullptr ? s.functions.get(s.symbols.find(callee->name)) : std::nullopt;
+									if (!now.has_value() || now->get()->sig.input != callee->sig.input || now->get()->sig.output != callee->sig.output)
+									{
+										resolved = false;
+										return operand;
+									}
+									return now->get()->index;
+								}
+								if (op == backend::bytecode::opcode::address)
+								{
+									const auto* global = operand < previous.global_at.size() ? previous.global_at[operand] : nullptr;
+									const auto now = global != nullptr ? s.globals.get(s.symbols.find(global->name)) : std::nullopt;
+									if (!now.has_value())
+									{
+										resolved = false;
+										return operand;
+									}
+									return now->get()->index;
+								}
+								return operand;
+							});
+					if (!decoded || !resolved) { return false; }
+				}
+
+				if (target == nullptr)
+				{
+					target = s.mod->register_function(function.name, function.sig);
+					s.functions.set(cached.symbol, target);
+				}
+
+				s.local_builder->begin_function(*target);
+				for (const auto* local: function.locals) { (void)s.local_builder->register_local(local->name); }
+				for (std::size_t slot = 0; slot < function.blocks.size(); ++slot) { s.local_builder->register_block(function.blocks[slot]->sig)->code = std::move(codes[slot]); }
+				return true;
+			}
+
+			if (target == nullptr) { s.functions.set(cached.symbol, s.mod->register_function(function.name, function.sig)); }
+			return true;
 		}
+	};
 
-		// use result?
+	IncrementalParser::IncrementalParser(std::string filename, const std::size_t max_errors)
+		: state_{std::make_unique<state_type>()}
+	{
+		state_->filename = std::move(filename);
+		state_->max_errors = max_errors;
+	}
 
-		// return module?
-		delete state.mod;
+	IncrementalParser::IncrementalParser(IncrementalParser&&) noexcept = default;
+	IncrementalParser& IncrementalParser::operator=(IncrementalParser&&) noexcept = default;
+	IncrementalParser::~IncrementalParser() noexcept = default;
+
+	auto IncrementalParser::parse(const std::u8string_view source) -> statistics
+	{
+		auto& self = *state_;
+		const auto error_callback = [&self]
+		{
+			return lexy_ext::report_error.opts({.flags = lexy::visualize_fancy}).path(self.filename.c_str()).to(std::back_inserter(self.state->diagnostics));
+		};
+
+		ParseState::storage_type storage{lexy::buffer<lexy::utf8_encoding>{source.data(), source.size()}};
+		// the outline points into the storage, which keeps its address when moved into the state
+		const auto view = ParseState::view_of(storage);
+		const auto outline = OutlineScanner{view.data(), view.data() + view.size()}.scan();
+
+		if (!outline.has_value())
+		{
+			// let the grammar find (and report) the error, nothing can be cached
+			self.header.clear();
+			self.declarations.clear();
+			self.state = std::make_unique<ParseState>(std::string{self.filename}, std::move(storage), self.max_errors);
+
+			auto& state = *self.state;
+			auto result = lexy::parse<grammar::module_declaration>(state.input(), state, error_callback());
+			state.error_count += result.error_count();
+			state.render_diagnostics();
+
+			if (!result.has_value())
+			{
+				state.local_builder.reset();
+				state.mod.reset();
+			}
+
+			return {.reused = 0, .parsed = 0, .full_parse = true};
+		}
+
+		const std::u8string_view header{outline->header_begin, outline->header_end};
+		const auto full_parse = self.state == nullptr || self.state->mod == nullptr || self.header != header;
+
+		// The module is built again from scratch (the pools of a module cannot drop anything), in source order,
+		// so that it is the same as the one of a full parse: no stale declaration is left and the indices follow the new source.
+		state_type::previous_type previous{};
+		if (full_parse)
+		{
+			self.header = header;
+			self.declarations.clear();
+			self.state = std::make_unique<ParseState>(std::string{self.filename}, std::move(storage), self.max_errors);
+		}
+		else
+		{
+			previous.storage = std::move(self.state->storage);
+			const auto previous_view = ParseState::view_of(previous.storage);
+			previous.source = {previous_view.data(), previous_view.size()};
+			self.state->replace_source(std::move(storage));
+			self.state->diagnostics.clear();
+			self.state->error_count = 0;
+
+			// the local builder refers to the previous module, it is replaced by create_module below
+			previous.mod = std::move(self.state->mod);
+			previous.functions = std::exchange(self.state->functions, {});
+			previous.globals = std::exchange(self.state->globals, {});
+
+			previous.function_at.resize(previous.mod->functions().size());
+			previous.mod->functions().for_each([&previous](const backend::Function& function) { previous.function_at[function.index] = &function; });
+			previous.global_at.resize(previous.mod->globals().size());
+			previous.mod->globals().for_each([&previous](const backend::Global& global) { previous.global_at[global.index] = &global; });
+		}
+
+		auto& state = *self.state;
+		state.create_module(symbol_name_type{outline->module_name});
+
+		// hash => previous declarations
+		std::unordered_multimap<std::size_t, std::size_t> candidates{};
+		for (std::size_t i = 0; i < self.declarations.size(); ++i)
+		{
+			if (self.declarations[i].valid) { candidates.emplace(self.declarations[i].hash, i); }
+		}
+
+		std::vector<bool> taken(self.declarations.size(), false);
+		std::vector<state_type::cached_declaration> next{};
+		next.reserve(outline->declarations.size());
+		std::size_t reused = 0;
+
+		// in source order, each declaration is either copied or parsed again
+		for (const auto& declaration: outline->declarations)
+		{
+			const std::u8string_view text{declaration.begin, declaration.end};
+			const auto hash = std::hash<std::u8string_view>{}(text);
+			const auto offset = static_cast<std::size_t>(declaration.begin - state.buffer.data());
+
+			auto [it, end] = candidates.equal_range(hash);
+			for (; it != end; ++it)
+			{
+				// the hash only narrows the search, a declaration is reused when its text is the same
+				if (const auto& cached = self.declarations[it->second];
+					!taken[it->second] && cached.kind == declaration.kind && cached.length == text.size() && previous.source.substr(cached.offset, cached.length) == text) { break; }
+			}
+
+			if (it != end && self.copy(self.declarations[it->second], previous))
+			{
+				taken[it->second] = true;
+				next.push_back(self.declarations[it->second]);
+				next.back().offset = offset;
+				++reused;
+				continue;
+			}
+
+			const auto errors_before = state.error_count;
+			// positions (and so the diagnostics) stay relative to the whole module
+			const auto input = state.input(declaration.begin, declaration.end);
+			auto result = lexy::parse<grammar::declaration_fragment>(input, state, error_callback());
+			state.error_count += result.error_count();
+
+			next.push_back(
+					{
+							.hash = hash,
+							.offset = offset,
+							.length = text.size(),
+							.kind = declaration.kind,
+							.symbol = state.symbols.intern(declaration.name),
+							.body = declaration.kind == ModuleOutline::declaration::kind_type::function && text.ends_with(u8'}'),
+							.valid = result.is_success() && state.error_count == errors_before
+					});
+		}
+
+		state.render_diagnostics();
+
+		self.declarations = std::move(next);
+		return {.reused = reused, .parsed = self.declarations.size() - reused, .full_parse = full_parse};
 	}
+
+	auto IncrementalParser::module() const noexcept -> const backend::Module*
+	{
+		return state_->state ? state_->state->mod.get() : nullptr;
+	}
+
+	auto IncrementalParser::diagnostics() const noexcept -> std::string_view
+	{
+		return state_->state ? std::string_view{state_->state->diagnostics} : std::string_view{};
+	}
+
+	auto IncrementalParser::error_count() const noexcept -> std::size_t
+	{
+		return state_->state ? state_->state->error_count : 0;
+	}
+}
+
+namespace frontend
+{
+	struct LazyModule::state_type
+	{
+		struct pending_body
+		{
+			const ModuleOutline::declaration* declaration;
+			bool parsed;
+		};
+
+		std::unique_ptr<ParseState> state;
+		// points into the storage of the state
+		std::optional<ModuleOutline> outline;
+
+		// every function declaration, in source order
+		std::vector<pending_body> bodies;
+		// function name => index into `bodies`
+		std::unordered_multimap<symbol_name_view_type, std::size_t> bodies_of;
+
+		[[nodiscard]] auto failed() const noexcept -> bool { return state == nullptr || state->mod == nullptr; }
+
+		auto parse(pending_body& body) -> bool
+		{
+			auto& s = *state;
+			const auto errors_before = s.error_count;
+
+			body.parsed = true;
+			const auto parsed = parse_fragment<grammar::function_body_fragment_of_declared>(s, *body.declaration);
+			s.render_diagnostics();
+
+			if (!parsed)
+			{
+				s.local_builder.reset();
+				s.mod.reset();
+			}
+			return parsed && s.error_count == errors_before;
+		}
+	};
+
+	LazyModule::LazyModule(std::unique_ptr<state_type> state) noexcept
+		: state_{std::move(state)} {}
+
+	LazyModule::LazyModule(LazyModule&&) noexcept = default;
+	LazyModule& LazyModule::operator=(LazyModule&&) noexcept = default;
+	LazyModule::~LazyModule() noexcept = default;
+
+	auto LazyModule::open(const std::string_view filename, const std::size_t max_errors) -> LazyModule
+	{
+		auto self = std::make_unique<state_type>();
+
+		std::string name{filename};
+		auto source = open_source(name.c_str());
+
+		if (!source)
+		{
+			self->state = std::make_unique<ParseState>(std::move(name), ParseState::storage_type{ParseState::context_type{}}, max_errors);
+			self->state->diagnostics = fmt::format("error: cannot read file '{}'\n", filename);
+			self->state->error_count = 1;
+			return LazyModule{std::move(self)};
+		}
+
+		// the outline points into the storage, which keeps its address when moved into the state
+		const auto view = ParseState::view_of(*source);
+		self->outline = OutlineScanner{view.data(), view.data() + view.size()}.scan();
+		self->state = std::make_unique<ParseState>(std::move(name), *std::move(source), max_errors);
+		auto& state = *self->state;
+
+		if (!self->outline.has_value())
+		{
+			// let the grammar find (and report) the error, everything is parsed at once
+			const auto result = lexy::parse<grammar::module_declaration>(
+					state.input(),
+					state,
+					lexy_ext::report_error.opts({.flags = lexy::visualize_fancy}).path(state.filename.c_str()).to(std::back_inserter(state.diagnostics)));
+			state.error_count += result.error_count();
+			state.render_diagnostics();
+
+			if (!result.has_value())
+			{
+				state.local_builder.reset();
+				state.mod.reset();
+			}
+			return LazyModule{std::move(self)};
+		}
+
+		state.create_module(symbol_name_type{self->outline->module_name});
+
+		bool failed = false;
+		for (const auto& declaration: self->outline->declarations)
+		{
+			if (declaration.kind == ModuleOutline::declaration::kind_type::global)
+			{
+				failed = !parse_fragment<grammar::declaration_fragment>(state, declaration) || failed;
+				continue;
+			}
+
+			failed = !parse_fragment<grammar::function_header_fragment>(state, declaration) || failed;
+			self->bodies_of.emplace(declaration.name, self->bodies.size());
+			self->bodies.push_back({.declaration = &declaration, .parsed = false});
+		}
+		state.render_diagnostics();
+
+		if (failed)
+		{
+			state.local_builder.reset();
+			state.mod.reset();
+		}
+		return LazyModule{std::move(self)};
+	}
+
+	auto LazyModule::module() const noexcept -> const backend::Module*
+	{
+		return state_->failed() ? nullptr : state_->state->mod.get();
+	}
+
+	auto LazyModule::parse_body(const std::string_view function) -> bool
+	{
+		auto& self = *state_;
+		if (self.failed()) { return false; }
+		// without an outline everything was parsed by `open`
+		if (!self.outline.has_value()) { return self.state->functions.get(self.state->symbols.find(function)).has_value(); }
+
+		auto [it, end] = self.bodies_of.equal_range(function);
+		if (it == end) { return false; }
+
+		// in source order, like a full parse
+		std::vector<std::size_t> indices{};
+		for (; it != end; ++it) { indices.push_back(it->second); }
+		std::ranges::sort(indices);
+
+		bool succeeded = true;
+		for (const auto index: indices)
+		{
+			if (auto& body = self.bodies[index];
+				!body.parsed) { succeeded = self.parse(body) && succeeded; }
+			if (self.failed()) { return false; }
+		}
+		return succeeded;
+	}
+
+	auto LazyModule::parse_bodies() -> bool
+	{
+		auto& self = *state_;
+		if (self.failed()) { return false; }
+
+		bool succeeded = true;
+		for (auto& body: self.bodies)
+		{
+			if (!body.parsed) { succeeded = self.parse(body) && succeeded; }
+			if (self.failed()) { return false; }
+		}
+		return succeeded;
+	}
+
+	auto LazyModule::body_parsed(const std::string_view function) const -> bool
+	{
+		auto [it, end] = state_->bodies_of.equal_range(function);
+		return std::all_of(it, end, [this](const auto& entry) { return state_->bodies[entry.second].parsed; });
+	}
+
+	auto LazyModule::diagnostics() const noexcept -> std::string_view { return state_->state->diagnostics; }
+
+	auto LazyModule::error_count() const noexcept -> std::size_t { return state_->state->error_count; }
 }
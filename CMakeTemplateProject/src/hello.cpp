@@ -1,8 +1,8 @@
 #include <CMakeTemplateProject/hello.hpp>
+#include <CMakeTemplateProject/source_file.hpp>
 
 #include <lexy/dsl.hpp>
 #include <lexy/action/parse.hpp> // lexy::parse
-#include <lexy/input/file.hpp>   // lexy::read_file
 #include <lexy/input/string_input.hpp>
 #include <lexy_ext/report_error.hpp> // lexy_ext::report_error
 #include <lexy/callback.hpp>     // value callbacks
@@ -387,11 +387,8 @@ namespace lexy_test
 {
 	auto parse_file_and_print(const std::string_view filename) -> void
 	{
-		// constexpr auto is_little = std::endian::native == std::endian::little;
-
-		const auto file = lexy::read_file<
-			lexy::utf8_encoding//, is_little ? lexy::encoding_endianness::little : lexy::encoding_endianness::big
-		>(filename.data());
+		// parse straight from the page cache when the file can be mapped
+		const auto file = io::SourceFile::open(std::string{filename}.c_str());
 
 		if (!file)
 		{
@@ -399,7 +396,8 @@ namespace lexy_test
 			throw std::exception{"Cannot read file!"};
 		}
 
-		auto production = lexy::parse<grammar::function_arguments>(file.buffer(), lexy_ext::report_error);
+		const auto input = lexy::string_input<lexy::utf8_encoding>(file->data(), file->size());
+		auto production = lexy::parse<grammar::function_arguments>(input, lexy_ext::report_error);
 		if (!production.has_value())
 		{
 			// todo
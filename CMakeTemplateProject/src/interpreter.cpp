@@ -0,0 +1,1169 @@
+#include <CMakeTemplateProject/interpreter.hpp>
+#include <CMakeTemplateProject/bytecode.hpp>
+#include <CMakeTemplateProject/macro.hpp>
+#include <CMakeTemplateProject/verifier.hpp>
+
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
+#include <unordered_map>
+#include <utility>
+
+// labels as values
+#if (defined(__GNUC__) || defined(__clang__)) && !defined(CMakeTemplateProject_COMPILER_MSVC) && !defined(_MSC_VER)
+	#define CTP_THREADED_DISPATCH 1
+#else
+	#define CTP_THREADED_DISPATCH 0
+#endif
+
+namespace
+{
+	using opcode = backend::bytecode::opcode;
+
+	// The opcodes of the bytecode (with the same values), then the operations that only exist in the translated code.
+	enum class operation : std::uintptr_t
+	{
+		add,
+		sub,
+		mul,
+		div,
+		rem,
+		bit_and,
+		bit_or,
+		bit_xor,
+		shl,
+		shr,
+		eq,
+		ne,
+		lt,
+		le,
+		load,
+		store,
+		dup,
+		drop,
+		swap,
+		nop,
+		push,
+		get,
+		set,
+		address,
+		call,
+		call_block,
+		if_,
+		if_else,
+		loop,
+
+		// follows `loop`, pops the condition and runs the loop again if it is not zero
+		loop_test,
+		// <input> <output> <max height>, the first cell of every block
+		enter,
+		// the last cell of every block
+		leave,
+		// the first cell of the code, where the outermost call returns to
+		halt,
+		// an instruction with an operand out of range
+		invalid,
+	};
+
+	constexpr std::size_t operation_count = static_cast<std::size_t>(operation::invalid) + 1;
+
+	static_assert(static_cast<std::size_t>(operation::loop) + 1 == backend::bytecode::opcode_count);
+
+	[[nodiscard]] constexpr auto operation_of(const opcode op) noexcept -> operation { return static_cast<operation>(op); }
+
+	#if CTP_THREADED_DISPATCH
+	// [checked], published by the first Interpreter::execute of each mode
+	const void* const* threaded_handlers[2]{nullptr, nullptr};
+	#endif
+
+	[[nodiscard]] constexpr auto align_up(const std::size_t offset, const std::size_t alignment) noexcept -> std::size_t { return (offset + alignment - 1) / alignment * alignment; }
+
+	// the arithmetic wraps around
+	[[nodiscard]] constexpr auto wrap(const std::uint64_t value) noexcept -> execution::value_type { return static_cast<execution::value_type>(value); }
+
+	[[nodiscard]] constexpr auto bits(const execution::value_type value) noexcept -> std::uint64_t { return static_cast<std::uint64_t>(value); }
+
+	// values are moved in and out of the globals 8 bytes at a time
+	constexpr std::size_t value_size = sizeof(execution::value_type);
+
+	// the cells following the one of the operation
+	[[nodiscard]] constexpr auto operand_count(const operation op) noexcept -> std::size_t
+	{
+		switch (op)
+		{
+			case operation::push:
+			case operation::get:
+			case operation::set:
+			case operation::address:
+			case operation::call:
+			case operation::call_block:
+			case operation::if_:
+			case operation::loop:
+			case operation::loop_test: { return 1; }
+			case operation::if_else: { return 2; }
+			case operation::enter: { return 3; }
+			default: { return 0; }
+		}
+	}
+}
+
+namespace execution
+{
+	auto trap_message(const trap_type trap) noexcept -> std::string_view
+	{
+		switch (trap)
+		{
+			case trap_type::none: { return "no trap"; }
+			case trap_type::unknown_function: { return "unknown function"; }
+			case trap_type::undefined_function: { return "call to a function without body"; }
+			case trap_type::signature_mismatch: { return "arguments or results do not match the signature"; }
+			case trap_type::stack_underflow: { return "stack underflow"; }
+			case trap_type::stack_overflow: { return "stack overflow"; }
+			case trap_type::stack_mismatch: { return "block left a wrong number of values"; }
+			case trap_type::call_depth_exceeded: { return "call depth exceeded"; }
+			case trap_type::out_of_bounds: { return "memory access out of bounds"; }
+			case trap_type::read_only: { return "store into an immutable global"; }
+			case trap_type::division_by_zero: { return "division by zero"; }
+			case trap_type::invalid_code: { return "invalid code"; }
+		}
+		return "unknown trap";
+	}
+
+	Interpreter::Interpreter(const backend::Module& mod, const limits_type limits)
+		: limits_{limits},
+		mutable_size_{0},
+		stack_(limits.stack_size),
+		locals_(limits.locals_size),
+		// the outermost call needs a record
+		control_(std::max<size_type>(limits.call_depth, 1)),
+		control_top_{nullptr},
+		verified_{false}
+	{
+		[[maybe_unused]] static const auto published = (execute<true>(nullptr, nullptr, {}), execute<false>(nullptr, nullptr, {}), true);
+
+		translate(mod);
+	}
+
+	auto Interpreter::translate(const backend::Module& mod) -> void
+	{
+		// globals
+		globals_.resize(mod.globals().size());
+		size_type memory_size = 0;
+		const auto place = [&](const backend::Global::kind_type kind)
+		{
+			mod.globals().for_each(
+					[&](const backend::Global& global)
+					{
+						if (global.kind != kind) { return; }
+
+						const auto size = static_cast<size_type>(global.data.size());
+						globals_[global.index] = {memory_size, size};
+						memory_size = align_up(memory_size + size, value_size);
+					});
+		};
+		place(backend::Global::kind_type::mutable_data);
+		mutable_size_ = memory_size;
+		place(backend::Global::kind_type::immutable_data);
+
+		memory_.resize(memory_size);
+		mod.globals().for_each(
+				[&](const backend::Global& global)
+				{
+					auto offset = globals_[global.index].first;
+					global.data.for_each_chunk(
+							[&](const std::string_view chunk)
+							{
+								std::memcpy(memory_.data() + offset, chunk.data(), chunk.size());
+								offset += chunk.size();
+							});
+				});
+
+		// functions, `functions_` does not grow anymore so the cells may point into it
+		functions_.resize(mod.functions().size());
+		mod.functions().for_each(
+				[&](const backend::Function& function)
+				{
+					functions_[function.index] = {.sig = function.sig, .local_count = static_cast<backend::slot_type>(function.locals.size()), .entry = nullptr, .end = nullptr, .calls = 0, .native = nullptr};
+					function_names_.emplace(function.name, function.index);
+				});
+
+		// The stack effect of every block is checked once here, the code of a module that verifies runs without the checks.
+		// index => slot => most values on the stack, see backend::verifier::verify_function
+		std::vector<std::vector<size_type>> max_heights(functions_.size());
+		verified_ = true;
+		mod.functions().for_each(
+				[&](const backend::Function& function)
+				{
+					const auto callee = [this](const std::uint64_t index) -> std::optional<backend::Function::signature>
+					{
+						if (index >= functions_.size()) { return std::nullopt; }
+						return functions_[index].sig;
+					};
+
+					auto& heights = max_heights[function.index];
+					heights.resize(function.blocks.size(), 0);
+					if (backend::verifier::verify_function(function, globals_.size(), callee, heights).has_value()) { verified_ = false; }
+				});
+
+		// only the code that may be compiled needs its operations
+		const auto compilable = CTP_JIT && verified_ && limits_.jit_threshold != 0;
+		const auto emit = [this, compilable](const operation op)
+		{
+			if (compilable)
+			{
+				operations_.resize(code_.size(), 0);
+				operations_.push_back(static_cast<std::uint8_t>(op));
+			}
+
+			#if CTP_THREADED_DISPATCH
+			code_.push_back({.handler = threaded_handlers[verified_ ? 0 : 1][static_cast<std::size_t>(op)]});
+			#else
+			code_.push_back({.operation = static_cast<std::uintptr_t>(op)});
+			#endif
+		};
+
+		// the cells pointing to other cells are patched once `code_` does not grow anymore
+		struct fixup
+		{
+			size_type cell;
+			size_type target;
+		};
+
+		std::vector<fixup> fixups{};
+		struct function_cells
+		{
+			backend::index_type function;
+			// the first cell of its entry block
+			size_type entry;
+			size_type end;
+		};
+
+		std::vector<function_cells> entries{};
+
+		emit(operation::halt);
+
+		mod.functions().for_each(
+				[&](const backend::Function& function)
+				{
+					if (function.blocks.empty()) { return; }
+
+					// block slot => first cell
+					std::vector<size_type> block_begins(function.blocks.size(), 0);
+					// (cell, block slot)
+					std::vector<std::pair<size_type, size_type>> block_references{};
+
+					const auto emit_block_reference = [&](const std::uint64_t slot)
+					{
+						block_references.emplace_back(code_.size(), static_cast<size_type>(slot));
+						code_.push_back({.index = 0});
+					};
+
+					for (size_type slot = 0; slot < function.blocks.size(); ++slot)
+					{
+						const auto& block = *function.blocks[slot];
+						block_begins[slot] = code_.size();
+
+						emit(operation::enter);
+						code_.push_back({.index = block.sig.input});
+						code_.push_back({.index = block.sig.output});
+						code_.push_back({.index = verified_ ? max_heights[function.index][slot] : 0});
+
+						const auto decoded = backend::bytecode::for_each_instruction(
+								block.code,
+								[&](const backend::bytecode::instruction& instruction)
+								{
+									const auto operand = instruction.operands[0];
+									switch (instruction.op)
+									{
+										case opcode::nop:
+										{
+											// costs nothing
+											break;
+										}
+										case opcode::push:
+										{
+											emit(operation::push);
+											code_.push_back({.immediate = instruction.immediate()});
+											break;
+										}
+										case opcode::get:
+										case opcode::set:
+										{
+											if (operand >= function.locals.size()) { emit(operation::invalid); }
+											else
+											{
+												emit(operation_of(instruction.op));
+												code_.push_back({.index = operand});
+											}
+											break;
+										}
+										case opcode::address:
+										{
+											if (operand >= globals_.size()) { emit(operation::invalid); }
+											else
+											{
+												// `memory_` does not grow anymore, the address is final
+												emit(operation::address);
+												code_.push_back({.immediate = static_cast<value_type>(reinterpret_cast<std::uintptr_t>(memory_.data() + globals_[operand].first))});
+											}
+											break;
+										}
+										case opcode::call:
+										{
+											if (operand >= functions_.size()) { emit(operation::invalid); }
+											else
+											{
+												emit(operation::call);
+												code_.push_back({.function = &functions_[operand]});
+											}
+											break;
+										}
+										case opcode::call_block:
+										case opcode::if_:
+										{
+											if (operand >= function.blocks.size()) { emit(operation::invalid); }
+											else
+											{
+												emit(operation_of(instruction.op));
+												emit_block_reference(operand);
+											}
+											break;
+										}
+										case opcode::if_else:
+										{
+											if (operand >= function.blocks.size() || instruction.operands[1] >= function.blocks.size()) { emit(operation::invalid); }
+											else
+											{
+												emit(operation::if_else);
+												emit_block_reference(operand);
+												emit_block_reference(instruction.operands[1]);
+											}
+											break;
+										}
+										case opcode::loop:
+										{
+											if (operand >= function.blocks.size()) { emit(operation::invalid); }
+											else
+											{
+												const auto loop = code_.size();
+												emit(operation::loop);
+												emit_block_reference(operand);
+												emit(operation::loop_test);
+												fixups.push_back({.cell = code_.size(), .target = loop});
+												code_.push_back({.index = 0});
+											}
+											break;
+										}
+										default:
+										{
+											// builtin
+											emit(operation_of(instruction.op));
+											break;
+										}
+									}
+								});
+						if (!decoded) { emit(operation::invalid); }
+
+						emit(operation::leave);
+					}
+
+					for (const auto& [cell, slot]: block_references) { fixups.push_back({.cell = cell, .target = block_begins[slot]}); }
+					entries.push_back({.function = function.index, .entry = block_begins.front(), .end = code_.size()});
+				});
+
+		if (compilable) { operations_.resize(code_.size(), 0); }
+
+		for (const auto& [cell, target]: fixups) { code_[cell].target = code_.data() + target; }
+		for (const auto& [function, entry, end]: entries)
+		{
+			functions_[function].entry = code_.data() + entry;
+			functions_[function].end = code_.data() + end;
+		}
+	}
+
+	template<bool Checked>
+	auto Interpreter::execute(Interpreter* self, const function_info* function, const frame at) -> trap_type
+	{
+		#if CTP_THREADED_DISPATCH
+		static const void* const handlers[operation_count]{
+				&&op_add,
+				&&op_sub,
+				&&op_mul,
+				&&op_div,
+				&&op_rem,
+				&&op_bit_and,
+				&&op_bit_or,
+				&&op_bit_xor,
+				&&op_shl,
+				&&op_shr,
+				&&op_eq,
+				&&op_ne,
+				&&op_lt,
+				&&op_le,
+				&&op_load,
+				&&op_store,
+				&&op_dup,
+				&&op_drop,
+				&&op_swap,
+				&&op_nop,
+				&&op_push,
+				&&op_get,
+				&&op_set,
+				&&op_address,
+				&&op_call,
+				&&op_call_block,
+				&&op_if_,
+				&&op_if_else,
+				&&op_loop,
+				&&op_loop_test,
+				&&op_enter,
+				&&op_leave,
+				&&op_halt,
+				&&op_invalid,
+		};
+
+		if (self == nullptr)
+		{
+			threaded_handlers[Checked ? 1 : 0] = handlers;
+			return trap_type::none;
+		}
+
+		#define CTP_OPERATION(name) op_##name:
+		#define CTP_NEXT() goto *(ip++)->handler
+		#else
+		if (self == nullptr) { return trap_type::none; }
+
+		#define CTP_OPERATION(name) case operation::name:
+		#define CTP_NEXT() continue
+		#endif
+
+		#define CTP_TRAP(what) \
+			do \
+			{ \
+				trap = (what); \
+				goto finish; \
+			} while (false)
+		// the current block may pop `n` values, always true for verified code
+		#define CTP_NEED(n) \
+			if constexpr (Checked) { if (static_cast<size_type>(sp - floor) < (n)) { CTP_TRAP(trap_type::stack_underflow); } }
+		// `n` values may be pushed, verified code checks the room of the whole block once when it is entered
+		#define CTP_ROOM(n) \
+			if constexpr (Checked) { if (static_cast<size_type>(stack_end - sp) < (n)) { CTP_TRAP(trap_type::stack_overflow); } }
+		#define CTP_PUSH_CONTROL(return_cell, saved_locals) \
+			do \
+			{ \
+				if (control == control_end) { CTP_TRAP(trap_type::call_depth_exceeded); } \
+				*control++ = {.return_to = (return_cell), .caller_floor = floor, .expected_top = nullptr, .caller_locals = (saved_locals)}; \
+			} while (false)
+		#define CTP_BINARY(name, expression) \
+			CTP_OPERATION(name) \
+			{ \
+				CTP_NEED(2); \
+				const auto a = sp[-2]; \
+				const auto b = sp[-1]; \
+				sp[-2] = (expression); \
+				--sp; \
+				CTP_NEXT(); \
+			}
+
+		auto* const stack_end = self->stack_.data() + self->stack_.size();
+		auto* const locals_end = self->locals_.data() + self->locals_.size();
+		auto* const control_end = at.control + at.depth;
+		auto* const memory = self->memory_.data();
+		const auto readable = self->memory_.size();
+		const auto writable = self->mutable_size_;
+		const auto memory_base = reinterpret_cast<std::uintptr_t>(memory);
+
+		// the arguments are already on the stack
+		value_type* sp = at.base + function->sig.input;
+		value_type* floor = at.base;
+		value_type* locals = at.locals;
+		value_type* locals_top = locals;
+		// one past the innermost record
+		control_record* control = at.control;
+		const cell* ip = nullptr;
+		auto trap = trap_type::none;
+
+		// as if called by the first cell
+		if (static_cast<size_type>(locals_end - locals_top) < function->local_count) { CTP_TRAP(trap_type::stack_overflow); }
+		CTP_PUSH_CONTROL(self->code_.data(), locals);
+		std::fill_n(locals, function->local_count, 0);
+		locals_top = locals + function->local_count;
+		ip = function->entry;
+
+		#if CTP_THREADED_DISPATCH
+		CTP_NEXT();
+		#else
+		for (;;)
+		{
+			switch (static_cast<operation>((ip++)->operation))
+			{
+		#endif
+				CTP_BINARY(add, wrap(bits(a) + bits(b)))
+				CTP_BINARY(sub, wrap(bits(a) - bits(b)))
+				CTP_BINARY(mul, wrap(bits(a) * bits(b)))
+				CTP_OPERATION(div)
+				{
+					CTP_NEED(2);
+					const auto a = sp[-2];
+					const auto b = sp[-1];
+					if (b == 0) { CTP_TRAP(trap_type::division_by_zero); }
+					// min / -1 wraps around
+					sp[-2] = b == -1 ? wrap(0 - bits(a)) : a / b;
+					--sp;
+					CTP_NEXT();
+				}
+				CTP_OPERATION(rem)
+				{
+					CTP_NEED(2);
+					const auto a = sp[-2];
+					const auto b = sp[-1];
+					if (b == 0) { CTP_TRAP(trap_type::division_by_zero); }
+					sp[-2] = b == -1 ? 0 : a % b;
+					--sp;
+					CTP_NEXT();
+				}
+				CTP_BINARY(bit_and, a & b)
+				CTP_BINARY(bit_or, a | b)
+				CTP_BINARY(bit_xor, a ^ b)
+				CTP_BINARY(shl, wrap(bits(a) << (b & 63)))
+				CTP_BINARY(shr, a >> (b & 63))
+				CTP_BINARY(eq, a == b ? 1 : 0)
+				CTP_BINARY(ne, a != b ? 1 : 0)
+				CTP_BINARY(lt, a < b ? 1 : 0)
+				CTP_BINARY(le, a <= b ? 1 : 0)
+				CTP_OPERATION(load)
+				{
+					CTP_NEED(1);
+					// an address below the memory wraps around too
+					const auto offset = bits(sp[-1]) - memory_base;
+					if (readable < value_size || offset > readable - value_size) { CTP_TRAP(trap_type::out_of_bounds); }
+					std::memcpy(&sp[-1], memory + offset, value_size);
+					CTP_NEXT();
+				}
+				CTP_OPERATION(store)
+				{
+					CTP_NEED(2);
+					const auto offset = bits(sp[-2]) - memory_base;
+					if (readable < value_size || offset > readable - value_size) { CTP_TRAP(trap_type::out_of_bounds); }
+					if (offset + value_size > writable) { CTP_TRAP(trap_type::read_only); }
+					std::memcpy(memory + offset, &sp[-1], value_size);
+					sp -= 2;
+					CTP_NEXT();
+				}
+				CTP_OPERATION(dup)
+				{
+					CTP_NEED(1);
+					CTP_ROOM(1);
+					*sp = sp[-1];
+					++sp;
+					CTP_NEXT();
+				}
+				CTP_OPERATION(drop)
+				{
+					CTP_NEED(1);
+					--sp;
+					CTP_NEXT();
+				}
+				CTP_OPERATION(swap)
+				{
+					CTP_NEED(2);
+					std::swap(sp[-2], sp[-1]);
+					CTP_NEXT();
+				}
+				CTP_OPERATION(nop)
+				{
+					// never emitted
+					CTP_NEXT();
+				}
+				CTP_OPERATION(push)
+				{
+					CTP_ROOM(1);
+					*sp++ = ip->immediate;
+					++ip;
+					CTP_NEXT();
+				}
+				CTP_OPERATION(get)
+				{
+					CTP_ROOM(1);
+					*sp++ = locals[ip->index];
+					++ip;
+					CTP_NEXT();
+				}
+				CTP_OPERATION(set)
+				{
+					CTP_NEED(1);
+					locals[ip->index] = *--sp;
+					++ip;
+					CTP_NEXT();
+				}
+				CTP_OPERATION(address)
+				{
+					CTP_ROOM(1);
+					*sp++ = ip->immediate;
+					++ip;
+					CTP_NEXT();
+				}
+				CTP_OPERATION(call)
+				{
+					auto* callee = ip->function;
+					if (callee->entry == nullptr) { CTP_TRAP(trap_type::undefined_function); }
+
+					if constexpr (!Checked)
+					{
+						if (callee->native == nullptr && ++callee->calls == self->limits_.jit_threshold) { (void)self->compile(*callee); }
+						if (callee->native != nullptr)
+						{
+							// the machine code takes the arguments where they are and leaves the results there
+							const auto native_trap = self->run_native(
+									*callee,
+									{.base = sp - callee->sig.input, .locals = locals_top, .control = control, .depth = static_cast<size_type>(control_end - control)});
+							if (native_trap != trap_type::none) { CTP_TRAP(native_trap); }
+
+							sp = sp - callee->sig.input + callee->sig.output;
+							++ip;
+							CTP_NEXT();
+						}
+					}
+
+					if (static_cast<size_type>(locals_end - locals_top) < callee->local_count) { CTP_TRAP(trap_type::stack_overflow); }
+
+					CTP_PUSH_CONTROL(ip + 1, locals);
+					locals = locals_top;
+					std::fill_n(locals, callee->local_count, 0);
+					locals_top = locals + callee->local_count;
+					ip = callee->entry;
+					CTP_NEXT();
+				}
+				CTP_OPERATION(call_block)
+				{
+					CTP_PUSH_CONTROL(ip + 1, nullptr);
+					ip = ip->target;
+					CTP_NEXT();
+				}
+				CTP_OPERATION(if_)
+				{
+					CTP_NEED(1);
+					if (*--sp != 0)
+					{
+						CTP_PUSH_CONTROL(ip + 1, nullptr);
+						ip = ip->target;
+					}
+					else { ++ip; }
+					CTP_NEXT();
+				}
+				CTP_OPERATION(if_else)
+				{
+					CTP_NEED(1);
+					const auto* target = *--sp != 0 ? ip[0].target : ip[1].target;
+					CTP_PUSH_CONTROL(ip + 2, nullptr);
+					ip = target;
+					CTP_NEXT();
+				}
+				CTP_OPERATION(loop)
+				{
+					// returns to the loop_test cell
+					CTP_PUSH_CONTROL(ip + 1, nullptr);
+					ip = ip->target;
+					CTP_NEXT();
+				}
+				CTP_OPERATION(loop_test)
+				{
+					CTP_NEED(1);
+					ip = *--sp != 0 ? ip->target : ip + 1;
+					CTP_NEXT();
+				}
+				CTP_OPERATION(enter)
+				{
+					if constexpr (Checked)
+					{
+						// the inputs of the block must be above the floor of its caller
+						if (static_cast<size_type>(sp - floor) < ip[0].index) { CTP_TRAP(trap_type::stack_underflow); }
+
+						floor = sp - ip[0].index;
+						control[-1].expected_top = floor + ip[1].index;
+					}
+					else
+					{
+						// the only stack check of verified code
+						if (static_cast<size_type>(stack_end - sp) + ip[0].index < ip[2].index) { CTP_TRAP(trap_type::stack_overflow); }
+					}
+					ip += 3;
+					CTP_NEXT();
+				}
+				CTP_OPERATION(leave)
+				{
+					const auto& record = *--control;
+					if constexpr (Checked)
+					{
+						if (sp != record.expected_top) { CTP_TRAP(trap_type::stack_mismatch); }
+						floor = record.caller_floor;
+					}
+
+					if (record.caller_locals != nullptr)
+					{
+						locals_top = locals;
+						locals = record.caller_locals;
+					}
+					ip = record.return_to;
+					CTP_NEXT();
+				}
+				CTP_OPERATION(halt) { goto finish; }
+				CTP_OPERATION(invalid) { CTP_TRAP(trap_type::invalid_code); }
+		#if !CTP_THREADED_DISPATCH
+				default: { CTP_UNREACHABLE(); }
+			}
+		}
+		#endif
+
+	finish:
+		#undef CTP_BINARY
+		#undef CTP_PUSH_CONTROL
+		#undef CTP_ROOM
+		#undef CTP_NEED
+		#undef CTP_TRAP
+		#undef CTP_NEXT
+		#undef CTP_OPERATION
+
+		return trap;
+	}
+
+	auto Interpreter::run(function_info& function, const frame at) -> trap_type
+	{
+		if (function.native == nullptr && ++function.calls == limits_.jit_threshold) { (void)compile(function); }
+		if (function.native != nullptr) { return run_native(function, at); }
+		return execute<false>(this, &function, at);
+	}
+
+	auto Interpreter::run_native(const function_info& function, const frame at) -> trap_type
+	{
+		if (static_cast<size_type>(locals_.data() + locals_.size() - at.locals) < function.local_count) { return trap_type::stack_overflow; }
+		std::fill_n(at.locals, function.local_count, 0);
+
+		// the records below belong to the interpreted callers, if any
+		auto* const outer = std::exchange(control_top_, at.control);
+		const auto trap = static_cast<trap_type>(function.native(at.base, at.locals, this, at.depth));
+		control_top_ = outer;
+		return trap;
+	}
+
+	auto Interpreter::native_call(Interpreter* self, function_info* callee, value_type* base, const size_type depth, value_type* locals) -> std::uint32_t
+	{
+		if (callee->entry == nullptr) { return static_cast<std::uint32_t>(trap_type::undefined_function); }
+		return static_cast<std::uint32_t>(self->run(*callee, {.base = base, .locals = locals, .control = self->control_top_, .depth = depth}));
+	}
+
+	auto Interpreter::compile([[maybe_unused]] function_info& function) -> bool
+	{
+		#if CTP_JIT
+		using jit::arithmetic;
+		using jit::condition;
+		using jit::reg;
+
+		// the compiled code relies on the stack effects of the verifier
+		if (!verified_ || function.entry == nullptr) { return false; }
+
+		// not from the handlers, the compiler may merge handlers with the same code (`call_block` and `loop`)
+		const auto operation_at = [this](const cell* at) -> operation { return static_cast<operation>(operations_[static_cast<size_type>(at - code_.data())]); };
+
+		// Register assignment of the compiled code:
+		// rbx: the floor of the current block, its values are [rbx + 8 * height]
+		// r12: the locals of the function
+		// r13: the interpreter
+		// r14: the end of the value stack
+		// r15: rsp after the prologue, where a trap unwinds to
+		// rbp: how many calls may still nest
+		// Every block is a subroutine called with its floor in rbx, the heights of its values are known from the verifier so nothing
+		// but the floor is kept at runtime.
+		jit::Assembler assembler{};
+
+		const auto exit = assembler.new_label();
+		std::array<jit::Assembler::label, static_cast<std::size_t>(trap_type::invalid_code) + 1> traps{};
+		for (auto& trap: traps) { trap = assembler.new_label(); }
+		const auto trap_label = [&traps](const trap_type trap) { return traps[static_cast<std::size_t>(trap)]; };
+
+		std::unordered_map<const cell*, jit::Assembler::label> block_labels{};
+		const auto block_label = [&](const cell* target) -> jit::Assembler::label
+		{
+			if (const auto it = block_labels.find(target);
+				it != block_labels.end()) { return it->second; }
+			return block_labels.emplace(target, assembler.new_label()).first->second;
+		};
+
+		const auto value = [](const size_type height) { return static_cast<std::int32_t>(height * value_size); };
+
+		// runs the block of `target` on the values above `height`, returns the height after it
+		const auto call_block = [&](const cell* target, const size_type height) -> size_type
+		{
+			const auto input = target[1].index;
+			const auto output = target[2].index;
+			assembler.push(reg::rbx);
+			assembler.lea(reg::rbx, reg::rbx, value(height - input));
+			assembler.call(block_label(target));
+			assembler.pop(reg::rbx);
+			return height - input + output;
+		};
+
+		// prologue, (base, locals, self, depth) are in (rdi, rsi, rdx, rcx)
+		for (const auto saved: {reg::rbp, reg::rbx, reg::r12, reg::r13, reg::r14, reg::r15}) { assembler.push(saved); }
+		assembler.mov(reg::rbx, reg::rdi);
+		assembler.mov(reg::r12, reg::rsi);
+		assembler.mov(reg::r13, reg::rdx);
+		assembler.mov(reg::rbp, reg::rcx);
+		assembler.mov(reg::r14, static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(stack_.data() + stack_.size())));
+		assembler.mov(reg::r15, reg::rsp);
+		assembler.call(block_label(function.entry));
+		assembler.mov32(reg::rax, static_cast<std::uint32_t>(trap_type::none));
+
+		// epilogue, eax holds the trap
+		assembler.bind(exit);
+		assembler.mov(reg::rsp, reg::r15);
+		for (const auto saved: {reg::r15, reg::r14, reg::r13, reg::r12, reg::rbx, reg::rbp}) { assembler.pop(saved); }
+		assembler.ret();
+
+		for (std::size_t trap = 0; trap < traps.size(); ++trap)
+		{
+			assembler.bind(traps[trap]);
+			assembler.mov32(reg::rax, static_cast<std::uint32_t>(trap));
+			assembler.jmp(exit);
+		}
+
+		const auto memory_base = static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(memory_.data()));
+		const auto readable = memory_.size();
+		const auto writable = mutable_size_;
+
+		// `offset = rax - memory` into rax and `memory` into rcx, traps if 8 bytes at `offset` cannot be read
+		const auto memory_offset = [&]
+		{
+			assembler.mov(reg::rcx, memory_base);
+			assembler.compute(arithmetic::sub, reg::rax, reg::rcx);
+			if (readable < value_size) { assembler.jmp(trap_label(trap_type::out_of_bounds)); }
+			else
+			{
+				assembler.mov(reg::rdx, static_cast<std::uint64_t>(readable - value_size));
+				assembler.compute(arithmetic::cmp, reg::rax, reg::rdx);
+				assembler.jump_if(condition::above, trap_label(trap_type::out_of_bounds));
+			}
+		};
+
+		size_type height = 0;
+		for (const auto* at = function.entry; at != function.end;)
+		{
+			const auto op = operation_at(at);
+			const auto* operands = at + 1;
+			at = operands + operand_count(op);
+
+			switch (op)
+			{
+				case operation::add:
+				case operation::sub:
+				case operation::bit_and:
+				case operation::bit_or:
+				case operation::bit_xor:
+				{
+					constexpr auto arithmetic_of = [](const operation o)
+					{
+						switch (o)
+						{
+							case operation::add: { return arithmetic::add; }
+							case operation::sub: { return arithmetic::sub; }
+							case operation::bit_and: { return arithmetic::bit_and; }
+							case operation::bit_or: { return arithmetic::bit_or; }
+							default: { return arithmetic::bit_xor; }
+						}
+					};
+
+					assembler.load(reg::rax, reg::rbx, value(height - 2));
+					assembler.compute(arithmetic_of(op), reg::rax, reg::rbx, value(height - 1));
+					assembler.store(reg::rbx, value(height - 2), reg::rax);
+					--height;
+					break;
+				}
+				case operation::mul:
+				{
+					assembler.load(reg::rax, reg::rbx, value(height - 2));
+					assembler.imul(reg::rax, reg::rbx, value(height - 1));
+					assembler.store(reg::rbx, value(height - 2), reg::rax);
+					--height;
+					break;
+				}
+				case operation::div:
+				case operation::rem:
+				{
+					const auto divide = assembler.new_label();
+					const auto done = assembler.new_label();
+
+					assembler.load(reg::rcx, reg::rbx, value(height - 1));
+					assembler.test(reg::rcx, reg::rcx);
+					assembler.jump_if(condition::equal, trap_label(trap_type::division_by_zero));
+					// idiv faults on min / -1, which wraps around here
+					assembler.compute(arithmetic::cmp, reg::rcx, static_cast<std::int8_t>(-1));
+					assembler.jump_if(condition::not_equal, divide);
+					assembler.load(reg::rax, reg::rbx, value(height - 2));
+					if (op == operation::div) { assembler.neg(reg::rax); }
+					else { assembler.mov32(reg::rax, 0); }
+					assembler.store(reg::rbx, value(height - 2), reg::rax);
+					assembler.jmp(done);
+
+					assembler.bind(divide);
+					assembler.load(reg::rax, reg::rbx, value(height - 2));
+					assembler.cqo();
+					assembler.idiv(reg::rcx);
+					assembler.store(reg::rbx, value(height - 2), op == operation::div ? reg::rax : reg::rdx);
+					assembler.bind(done);
+					--height;
+					break;
+				}
+				case operation::shl:
+				case operation::shr:
+				{
+					// the count is masked to 6 bits by the instruction
+					assembler.load(reg::rcx, reg::rbx, value(height - 1));
+					assembler.load(reg::rax, reg::rbx, value(height - 2));
+					if (op == operation::shl) { assembler.shl_cl(reg::rax); }
+					else { assembler.sar_cl(reg::rax); }
+					assembler.store(reg::rbx, value(height - 2), reg::rax);
+					--height;
+					break;
+				}
+				case operation::eq:
+				case operation::ne:
+				case operation::lt:
+				case operation::le:
+				{
+					const auto when = op == operation::eq ? condition::equal : op == operation::ne ? condition::not_equal : op == operation::lt ? condition::less : condition::less_equal;
+
+					assembler.load(reg::rax, reg::rbx, value(height - 2));
+					assembler.compute(arithmetic::cmp, reg::rax, reg::rbx, value(height - 1));
+					assembler.set(when);
+					assembler.store(reg::rbx, value(height - 2), reg::rax);
+					--height;
+					break;
+				}
+				case operation::load:
+				{
+					assembler.load(reg::rax, reg::rbx, value(height - 1));
+					memory_offset();
+					assembler.load_indexed(reg::rax, reg::rcx, reg::rax);
+					assembler.store(reg::rbx, value(height - 1), reg::rax);
+					break;
+				}
+				case operation::store:
+				{
+					assembler.load(reg::rax, reg::rbx, value(height - 2));
+					memory_offset();
+					if (writable < value_size) { assembler.jmp(trap_label(trap_type::read_only)); }
+					else
+					{
+						assembler.mov(reg::rdx, static_cast<std::uint64_t>(writable - value_size));
+						assembler.compute(arithmetic::cmp, reg::rax, reg::rdx);
+						assembler.jump_if(condition::above, trap_label(trap_type::read_only));
+					}
+					assembler.load(reg::rdx, reg::rbx, value(height - 1));
+					assembler.store_indexed(reg::rcx, reg::rax, reg::rdx);
+					height -= 2;
+					break;
+				}
+				case operation::dup:
+				{
+					assembler.load(reg::rax, reg::rbx, value(height - 1));
+					assembler.store(reg::rbx, value(height), reg::rax);
+					++height;
+					break;
+				}
+				case operation::drop:
+				{
+					--height;
+					break;
+				}
+				case operation::swap:
+				{
+					assembler.load(reg::rax, reg::rbx, value(height - 2));
+					assembler.load(reg::rcx, reg::rbx, value(height - 1));
+					assembler.store(reg::rbx, value(height - 2), reg::rcx);
+					assembler.store(reg::rbx, value(height - 1), reg::rax);
+					break;
+				}
+				case operation::nop:
+				case operation::loop_test:
+				{
+					// `loop` tests its condition itself
+					break;
+				}
+				case operation::push:
+				case operation::address:
+				{
+					assembler.mov(reg::rax, static_cast<std::uint64_t>(operands[0].immediate));
+					assembler.store(reg::rbx, value(height), reg::rax);
+					++height;
+					break;
+				}
+				case operation::get:
+				{
+					assembler.load(reg::rax, reg::r12, value(operands[0].index));
+					assembler.store(reg::rbx, value(height), reg::rax);
+					++height;
+					break;
+				}
+				case operation::set:
+				{
+					--height;
+					assembler.load(reg::rax, reg::rbx, value(height));
+					assembler.store(reg::r12, value(operands[0].index), reg::rax);
+					break;
+				}
+				case operation::call:
+				{
+					auto* callee = operands[0].function;
+					const auto base = height - callee->sig.input;
+
+					// native_call(self, callee, base, depth, the locals above ours), on a 16-byte aligned stack
+					assembler.mov(reg::rax, reg::rsp);
+					assembler.compute(arithmetic::bit_and, reg::rsp, static_cast<std::int8_t>(-16));
+					assembler.compute(arithmetic::sub, reg::rsp, static_cast<std::int8_t>(16));
+					assembler.store(reg::rsp, 0, reg::rax);
+					assembler.mov(reg::rdi, reg::r13);
+					assembler.mov(reg::rsi, static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(callee)));
+					assembler.lea(reg::rdx, reg::rbx, value(base));
+					assembler.mov(reg::rcx, reg::rbp);
+					assembler.lea(reg::r8, reg::r12, value(function.local_count));
+					assembler.mov(reg::rax, static_cast<std::uint64_t>(reinterpret_cast<std::uintptr_t>(&native_call)));
+					assembler.call(reg::rax);
+					assembler.load(reg::rsp, reg::rsp, 0);
+					// the trap of the callee is ours, returned in eax (the upper half of rax is garbage)
+					assembler.test32(reg::rax, reg::rax);
+					assembler.jump_if(condition::not_equal, exit);
+
+					height = base + callee->sig.output;
+					break;
+				}
+				case operation::call_block:
+				{
+					height = call_block(operands[0].target, height);
+					break;
+				}
+				case operation::if_:
+				{
+					const auto skip = assembler.new_label();
+
+					--height;
+					assembler.load(reg::rax, reg::rbx, value(height));
+					assembler.test(reg::rax, reg::rax);
+					assembler.jump_if(condition::equal, skip);
+					(void)call_block(operands[0].target, height);
+					assembler.bind(skip);
+					break;
+				}
+				case operation::if_else:
+				{
+					const auto otherwise = assembler.new_label();
+					const auto done = assembler.new_label();
+
+					--height;
+					assembler.load(reg::rax, reg::rbx, value(height));
+					assembler.test(reg::rax, reg::rax);
+					assembler.jump_if(condition::equal, otherwise);
+					(void)call_block(operands[0].target, height);
+					assembler.jmp(done);
+					assembler.bind(otherwise);
+					height = call_block(operands[1].target, height);
+					assembler.bind(done);
+					break;
+				}
+				case operation::loop:
+				{
+					const auto again = assembler.new_label();
+
+					assembler.bind(again);
+					height = call_block(operands[0].target, height) - 1;
+					assembler.load(reg::rax, reg::rbx, value(height));
+					assembler.test(reg::rax, reg::rax);
+					assembler.jump_if(condition::not_equal, again);
+					break;
+				}
+				case operation::enter:
+				{
+					// a block deeper than a disp32 reaches is left to the interpreter
+					if (operands[2].index > static_cast<size_type>(std::numeric_limits<std::int32_t>::max()) / value_size) { return false; }
+
+					assembler.bind(block_label(operands - 1));
+					height = operands[0].index;
+
+					// the depth, then the room of the whole block, as the interpreter checks them
+					assembler.test(reg::rbp, reg::rbp);
+					assembler.jump_if(condition::equal, trap_label(trap_type::call_depth_exceeded));
+					assembler.dec(reg::rbp);
+					assembler.lea(reg::rax, reg::rbx, value(operands[2].index));
+					assembler.compute(arithmetic::cmp, reg::rax, reg::r14);
+					assembler.jump_if(condition::above, trap_label(trap_type::stack_overflow));
+					break;
+				}
+				case operation::leave:
+				{
+					assembler.inc(reg::rbp);
+					assembler.ret();
+					break;
+				}
+				case operation::halt:
+				case operation::invalid:
+				{
+					// not in verified code
+					return false;
+				}
+			}
+		}
+
+		const auto code = assembler.finish();
+		auto memory = jit::ExecutableMemory::make(code);
+		if (!memory) { return false; }
+
+		function.native = reinterpret_cast<native_function>(const_cast<void*>(memory.data()));
+		native_code_.push_back(std::move(memory));
+		return true;
+		#else
+		return false;
+		#endif
+	}
+
+	auto Interpreter::find(const std::string_view function) const -> std::optional<backend::index_type>
+	{
+		if (const auto it = function_names_.find(std::string{function});
+			it != function_names_.end()) { return it->second; }
+		return std::nullopt;
+	}
+
+	auto Interpreter::call(const backend::index_type function, const std::span<const value_type> arguments, const std::span<value_type> results) -> trap_type
+	{
+		if (function >= functions_.size()) { return trap_type::unknown_function; }
+
+		const auto& info = functions_[function];
+		if (info.entry == nullptr) { return trap_type::undefined_function; }
+		if (arguments.size() != info.sig.input || results.size() != info.sig.output) { return trap_type::signature_mismatch; }
+		if (arguments.size() > stack_.size()) { return trap_type::stack_overflow; }
+
+		std::ranges::copy(arguments, stack_.begin());
+		const frame at{.base = stack_.data(), .locals = locals_.data(), .control = control_.data(), .depth = control_.size()};
+		const auto trap = verified_ ? run(functions_[function], at) : execute<true>(this, &info, at);
+		// the entry block left exactly the results at the bottom of the stack
+		if (trap == trap_type::none) { std::ranges::copy_n(stack_.begin(), static_cast<std::ptrdiff_t>(results.size()), results.begin()); }
+		return trap;
+	}
+
+	auto Interpreter::call(const std::string_view function, const std::span<const value_type> arguments, const std::span<value_type> results) -> trap_type
+	{
+		const auto index = find(function);
+		if (!index.has_value()) { return trap_type::unknown_function; }
+		return call(*index, arguments, results);
+	}
+
+	auto Interpreter::compiled(const backend::index_type function) const noexcept -> bool { return function < functions_.size() && functions_[function].native != nullptr; }
+
+	auto Interpreter::global(const backend::index_type index) const noexcept -> std::span<const std::byte>
+	{
+		if (index >= globals_.size()) { return {}; }
+
+		const auto [offset, size] = globals_[index];
+		return {memory_.data() + offset, size};
+	}
+}
@@ -0,0 +1,260 @@
+#include <CMakeTemplateProject/jit.hpp>
+
+#include <cstring>
+#include <limits>
+
+#if CTP_JIT
+	#include <sys/mman.h>
+	#include <unistd.h>
+#endif
+
+namespace
+{
+	using execution::jit::reg;
+
+	[[nodiscard]] constexpr auto number(const reg value) noexcept -> std::uint8_t { return static_cast<std::uint8_t>(value); }
+
+	// the low 3 bits go into ModRM/SIB/the opcode, the high one into REX
+	[[nodiscard]] constexpr auto low(const std::uint8_t value) noexcept -> std::uint8_t { return value & 7; }
+
+	[[nodiscard]] constexpr auto high(const std::uint8_t value) noexcept -> std::uint8_t { return (value >> 3) & 1; }
+
+	constexpr auto unbound = std::numeric_limits<std::size_t>::max();
+}
+
+namespace execution::jit
+{
+	auto ExecutableMemory::make(const std::span<const std::uint8_t> code) noexcept -> ExecutableMemory
+	{
+		#if CTP_JIT
+		if (code.empty()) { return {}; }
+
+		const auto page = static_cast<size_type>(::sysconf(_SC_PAGESIZE));
+		const auto size = (code.size() + page - 1) / page * page;
+
+		auto* data = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (data == MAP_FAILED) { return {}; }
+
+		std::memcpy(data, code.data(), code.size());
+		if (::mprotect(data, size, PROT_READ | PROT_EXEC) != 0)
+		{
+			::munmap(data, size);
+			return {};
+		}
+
+		return ExecutableMemory{data, size};
+		#else
+		(void)code;
+		return {};
+		#endif
+	}
+
+	auto ExecutableMemory::unmap() noexcept -> void
+	{
+		#if CTP_JIT
+		if (data_ != nullptr) { ::munmap(data_, size_); }
+		#endif
+		data_ = nullptr;
+		size_ = 0;
+	}
+
+	auto Assembler::byte(const std::uint8_t value) -> void { code_.push_back(value); }
+
+	auto Assembler::dword(const std::uint32_t value) -> void
+	{
+		for (int i = 0; i < 4; ++i) { byte(static_cast<std::uint8_t>(value >> (8 * i))); }
+	}
+
+	auto Assembler::qword(const std::uint64_t value) -> void
+	{
+		for (int i = 0; i < 8; ++i) { byte(static_cast<std::uint8_t>(value >> (8 * i))); }
+	}
+
+	auto Assembler::rex(const bool wide, const std::uint8_t reg_field, const std::uint8_t index, const std::uint8_t base) -> void
+	{
+		const auto bits = static_cast<std::uint8_t>((wide ? 8 : 0) | high(reg_field) << 2 | high(index) << 1 | high(base));
+		if (bits != 0) { byte(0x40 | bits); }
+	}
+
+	auto Assembler::memory(const std::uint8_t reg_field, const reg base, const std::int32_t disp) -> void
+	{
+		// mod 10: [base + disp32]
+		byte(static_cast<std::uint8_t>(0x80 | low(reg_field) << 3 | low(number(base))));
+		// rsp and r12 as base need a SIB without index
+		if (low(number(base)) == number(reg::rsp)) { byte(0x24); }
+		dword(static_cast<std::uint32_t>(disp));
+	}
+
+	auto Assembler::register_form(const bool wide, const std::uint8_t opcode, const std::uint8_t reg_field, const reg rm) -> void
+	{
+		rex(wide, reg_field, 0, number(rm));
+		byte(opcode);
+		byte(static_cast<std::uint8_t>(0xc0 | low(reg_field) << 3 | low(number(rm))));
+	}
+
+	auto Assembler::memory_form(const std::uint8_t opcode, const std::uint8_t reg_field, const reg base, const std::int32_t disp) -> void
+	{
+		rex(true, reg_field, 0, number(base));
+		byte(opcode);
+		memory(reg_field, base, disp);
+	}
+
+	auto Assembler::rel32(const label target) -> void
+	{
+		fixups_.emplace_back(code_.size(), target);
+		dword(0);
+	}
+
+	auto Assembler::new_label() -> label
+	{
+		labels_.push_back(unbound);
+		return labels_.size() - 1;
+	}
+
+	auto Assembler::bind(const label target) -> void { labels_[target] = code_.size(); }
+
+	auto Assembler::mov(const reg dst, const reg src) -> void { register_form(true, 0x89, number(src), dst); }
+
+	auto Assembler::mov(const reg dst, const std::uint64_t immediate) -> void
+	{
+		rex(true, 0, 0, number(dst));
+		byte(static_cast<std::uint8_t>(0xb8 | low(number(dst))));
+		qword(immediate);
+	}
+
+	auto Assembler::load(const reg dst, const reg base, const std::int32_t disp) -> void { memory_form(0x8b, number(dst), base, disp); }
+
+	auto Assembler::store(const reg base, const std::int32_t disp, const reg src) -> void { memory_form(0x89, number(src), base, disp); }
+
+	auto Assembler::load_indexed(const reg dst, const reg base, const reg index) -> void
+	{
+		// mod 01 + disp8 0: rbp and r13 have no mod 00 form
+		rex(true, number(dst), number(index), number(base));
+		byte(0x8b);
+		byte(static_cast<std::uint8_t>(0x44 | low(number(dst)) << 3));
+		byte(static_cast<std::uint8_t>(low(number(index)) << 3 | low(number(base))));
+		byte(0);
+	}
+
+	auto Assembler::store_indexed(const reg base, const reg index, const reg src) -> void
+	{
+		rex(true, number(src), number(index), number(base));
+		byte(0x89);
+		byte(static_cast<std::uint8_t>(0x44 | low(number(src)) << 3));
+		byte(static_cast<std::uint8_t>(low(number(index)) << 3 | low(number(base))));
+		byte(0);
+	}
+
+	auto Assembler::lea(const reg dst, const reg base, const std::int32_t disp) -> void { memory_form(0x8d, number(dst), base, disp); }
+
+	auto Assembler::compute(const arithmetic op, const reg dst, const reg base, const std::int32_t disp) -> void { memory_form(static_cast<std::uint8_t>(op), number(dst), base, disp); }
+
+	auto Assembler::compute(const arithmetic op, const reg dst, const reg src) -> void { register_form(true, static_cast<std::uint8_t>(op), number(dst), src); }
+
+	auto Assembler::compute(const arithmetic op, const reg dst, const std::int8_t immediate) -> void
+	{
+		// 83 /n ib, the extension is the group of the opcode
+		register_form(true, 0x83, static_cast<std::uint8_t>(op) >> 3, dst);
+		byte(static_cast<std::uint8_t>(immediate));
+	}
+
+	auto Assembler::imul(const reg dst, const reg base, const std::int32_t disp) -> void
+	{
+		rex(true, number(dst), 0, number(base));
+		byte(0x0f);
+		byte(0xaf);
+		memory(number(dst), base, disp);
+	}
+
+	auto Assembler::test(const reg lhs, const reg rhs) -> void { register_form(true, 0x85, number(rhs), lhs); }
+
+	auto Assembler::test32(const reg lhs, const reg rhs) -> void { register_form(false, 0x85, number(rhs), lhs); }
+
+	auto Assembler::neg(const reg value) -> void { register_form(true, 0xf7, 3, value); }
+
+	auto Assembler::inc(const reg value) -> void { register_form(true, 0xff, 0, value); }
+
+	auto Assembler::dec(const reg value) -> void { register_form(true, 0xff, 1, value); }
+
+	auto Assembler::cqo() -> void
+	{
+		byte(0x48);
+		byte(0x99);
+	}
+
+	auto Assembler::idiv(const reg divisor) -> void { register_form(true, 0xf7, 7, divisor); }
+
+	auto Assembler::shl_cl(const reg value) -> void { register_form(true, 0xd3, 4, value); }
+
+	auto Assembler::sar_cl(const reg value) -> void { register_form(true, 0xd3, 7, value); }
+
+	auto Assembler::set(const condition when) -> void
+	{
+		// setcc al
+		byte(0x0f);
+		byte(static_cast<std::uint8_t>(0x90 | static_cast<std::uint8_t>(when)));
+		byte(0xc0);
+		// movzx eax, al
+		byte(0x0f);
+		byte(0xb6);
+		byte(0xc0);
+	}
+
+	auto Assembler::mov32(const reg dst, const std::uint32_t immediate) -> void
+	{
+		rex(false, 0, 0, number(dst));
+		byte(static_cast<std::uint8_t>(0xb8 | low(number(dst))));
+		dword(immediate);
+	}
+
+	auto Assembler::push(const reg value) -> void
+	{
+		rex(false, 0, 0, number(value));
+		byte(static_cast<std::uint8_t>(0x50 | low(number(value))));
+	}
+
+	auto Assembler::pop(const reg value) -> void
+	{
+		rex(false, 0, 0, number(value));
+		byte(static_cast<std::uint8_t>(0x58 | low(number(value))));
+	}
+
+	auto Assembler::call(const label target) -> void
+	{
+		byte(0xe8);
+		rel32(target);
+	}
+
+	auto Assembler::call(const reg target) -> void { register_form(false, 0xff, 2, target); }
+
+	auto Assembler::jmp(const label target) -> void
+	{
+		byte(0xe9);
+		rel32(target);
+	}
+
+	auto Assembler::jump_if(const condition when, const label target) -> void
+	{
+		byte(0x0f);
+		byte(static_cast<std::uint8_t>(0x80 | static_cast<std::uint8_t>(when)));
+		rel32(target);
+	}
+
+	auto Assembler::ret() -> void { byte(0xc3); }
+
+	auto Assembler::finish() -> std::vector<std::uint8_t>
+	{
+		for (const auto& [offset, target]: fixups_)
+		{
+			if (labels_[target] == unbound) { return {}; }
+
+			// relative to the end of the rel32
+			const auto distance = static_cast<std::int64_t>(labels_[target]) - static_cast<std::int64_t>(offset + 4);
+			const auto value = static_cast<std::uint32_t>(static_cast<std::int32_t>(distance));
+			for (int i = 0; i < 4; ++i) { code_[offset + static_cast<std::size_t>(i)] = static_cast<std::uint8_t>(value >> (8 * i)); }
+		}
+
+		fixups_.clear();
+		return std::move(code_);
+	}
+}
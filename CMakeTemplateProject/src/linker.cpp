@@ -0,0 +1,288 @@
+#include <CMakeTemplateProject/linker.hpp>
+#include <CMakeTemplateProject/bytecode.hpp>
+#include <CMakeTemplateProject/thread_pool.hpp>
+
+#include <array>
+#include <compare>
+#include <functional>
+#include <limits>
+#include <mutex>
+#include <string_view>
+#include <unordered_map>
+
+namespace
+{
+	using backend::index_type;
+	using backend::Function;
+	using backend::Global;
+
+	// where a symbol is declared, the smallest one is the first declaration
+	struct location
+	{
+		// position of the module in the input
+		std::size_t module;
+		index_type index;
+
+		friend constexpr auto operator<=>(const location&, const location&) noexcept = default;
+	};
+
+	constexpr location nowhere{.module = std::numeric_limits<std::size_t>::max(), .index = std::numeric_limits<index_type>::max()};
+
+	struct symbol
+	{
+		location first;
+		// of the first declaration
+		Function::signature sig;
+		location definition;
+		// in the linked module, given by the first declaration
+		index_type linked;
+	};
+
+	[[nodiscard]] constexpr auto same_signature(const Function::signature lhs, const Function::signature rhs) noexcept -> bool { return lhs.input == rhs.input && lhs.output == rhs.output; }
+
+	// name => symbol, the shards are locked apart so that every module is declared at the same time
+	// once all the declarations are in, the table is only read
+	class SymbolTable final
+	{
+	public:
+		// Records a declaration (a definition if `defined`), the earliest ones are kept whatever order they come in.
+		auto declare(const std::string_view name, const location where, const Function::signature sig, const bool defined) -> void
+		{
+			auto& shard = shard_of(name);
+			const std::lock_guard lock{shard.mutex};
+
+			const auto [it, inserted] = shard.symbols.try_emplace(name, symbol{.first = where, .sig = sig, .definition = nowhere, .linked = 0});
+			auto& s = it->second;
+			if (!inserted && where < s.first)
+			{
+				s.first = where;
+				s.sig = sig;
+			}
+			if (defined && where < s.definition) { s.definition = where; }
+		}
+
+		// the name must be declared, the symbol stays where it is
+		[[nodiscard]] auto find(const std::string_view name) -> symbol& { return shard_of(name).symbols.find(name)->second; }
+
+	private:
+		constexpr static std::size_t shard_count = 64;
+
+		struct shard
+		{
+			std::mutex mutex;
+			std::unordered_map<std::string_view, symbol> symbols;
+		};
+
+		std::array<shard, shard_count> shards_;
+
+		[[nodiscard]] auto shard_of(const std::string_view name) -> shard& { return shards_[std::hash<std::string_view>{}(name) % shard_count]; }
+	};
+
+	struct module_state
+	{
+		// by index
+		std::vector<const Function*> functions;
+		std::vector<const Global*> globals;
+		std::vector<symbol*> function_symbols;
+		std::vector<symbol*> global_symbols;
+
+		std::vector<backend::linker::error> errors;
+		std::vector<backend::symbol_name_type> unresolved;
+
+		// the symbols first declared by this module
+		index_type new_functions;
+		index_type new_globals;
+		// the linked index of the first of them
+		index_type first_function;
+		index_type first_global;
+	};
+
+	// An operand out of range stays out of range (`count` is the number of linked symbols).
+	[[nodiscard]] auto relocate(const std::vector<symbol*>& symbols, const std::size_t count, const std::uint64_t operand) -> std::uint64_t { return operand < symbols.size() ? symbols[operand]->linked : count + (operand - symbols.size()); }
+}
+
+namespace backend::linker
+{
+	auto link(const std::span<const Module* const> modules, symbol_name_type name, concurrency::ThreadPool& pool) -> result
+	{
+		std::vector<module_state> states(modules.size());
+		SymbolTable functions{};
+		SymbolTable globals{};
+
+		// every task works on its own module (and state), only the symbol tables are shared
+
+		pool.parallel_for(
+				modules.size(),
+				[&](const std::size_t m)
+				{
+					const auto& mod = *modules[m];
+					auto& state = states[m];
+
+					state.functions.resize(mod.functions().size());
+					mod.functions().for_each([&state](const Function& function) { state.functions[function.index] = &function; });
+					state.globals.resize(mod.globals().size());
+					mod.globals().for_each([&state](const Global& global) { state.globals[global.index] = &global; });
+
+					for (const auto* function: state.functions) { functions.declare(function->name, {.module = m, .index = function->index}, function->sig, !function->blocks.empty()); }
+					for (const auto* global: state.globals) { globals.declare(global->name, {.module = m, .index = global->index}, {.input = 0, .output = 0}, true); }
+				});
+
+		pool.parallel_for(
+				modules.size(),
+				[&](const std::size_t m)
+				{
+					auto& state = states[m];
+
+					state.function_symbols.reserve(state.functions.size());
+					for (const auto* function: state.functions)
+					{
+						auto& s = functions.find(function->name);
+						state.function_symbols.push_back(&s);
+
+						const location where{.module = m, .index = function->index};
+						if (s.first == where)
+						{
+							++state.new_functions;
+							if (s.definition == nowhere) { state.unresolved.push_back(function->name); }
+						}
+						else if (!same_signature(s.sig, function->sig)) { state.errors.push_back({.type = error_type::conflicting_signature, .module = m, .name = function->name}); }
+
+						if (!function->blocks.empty() && s.definition != where) { state.errors.push_back({.type = error_type::duplicate_definition, .module = m, .name = function->name}); }
+					}
+
+					state.global_symbols.reserve(state.globals.size());
+					for (const auto* global: state.globals)
+					{
+						auto& s = globals.find(global->name);
+						state.global_symbols.push_back(&s);
+
+						if (s.first == location{.module = m, .index = global->index}) { ++state.new_globals; }
+						else { state.errors.push_back({.type = error_type::duplicate_definition, .module = m, .name = global->name}); }
+					}
+				});
+
+		index_type function_count = 0;
+		index_type global_count = 0;
+		for (auto& state: states)
+		{
+			state.first_function = function_count;
+			state.first_global = global_count;
+			function_count += state.new_functions;
+			global_count += state.new_globals;
+		}
+
+		pool.parallel_for(
+				modules.size(),
+				[&](const std::size_t m)
+				{
+					auto& state = states[m];
+
+					auto next = state.first_function;
+					for (std::size_t i = 0; i < state.functions.size(); ++i)
+					{
+						if (auto& s = *state.function_symbols[i];
+							s.first == location{.module = m, .index = static_cast<index_type>(i)}) { s.linked = next++; }
+					}
+
+					next = state.first_global;
+					for (std::size_t i = 0; i < state.globals.size(); ++i)
+					{
+						if (auto& s = *state.global_symbols[i];
+							s.first == location{.module = m, .index = static_cast<index_type>(i)}) { s.linked = next++; }
+					}
+				});
+
+		// the pools of a module are not shared between threads, everything is registered here, in the linked order
+		result linked{.module = std::make_unique<Module>(std::move(name)), .errors = {}, .unresolved = {}};
+		auto& mod = *linked.module;
+
+		// linked index => the function and its definition (null for a declaration)
+		std::vector<Function*> linked_functions{};
+		std::vector<const symbol*> definitions{};
+		linked_functions.reserve(function_count);
+		definitions.reserve(function_count);
+		for (std::size_t m = 0; m < modules.size(); ++m)
+		{
+			auto& state = states[m];
+			for (std::size_t i = 0; i < state.functions.size(); ++i)
+			{
+				if (const auto& s = *state.function_symbols[i];
+					s.first == location{.module = m, .index = static_cast<index_type>(i)})
+				{
+					linked_functions.push_back(mod.register_function(state.functions[i]->name, s.sig));
+					definitions.push_back(&s);
+				}
+			}
+
+			for (std::size_t i = 0; i < state.globals.size(); ++i)
+			{
+				if (state.global_symbols[i]->first != location{.module = m, .index = static_cast<index_type>(i)}) { continue; }
+
+				const auto& global = *state.globals[i];
+				if (global.kind == Global::kind_type::mutable_data) { (void)mod.register_global_mutable_data(global.name, data_type{global.data}); }
+				else
+				{
+					// interned again as the payload itself, not as a data around it
+					const auto* payload = global.data.payload();
+					(void)mod.register_global_immutable_data(global.name, data_type{payload != nullptr ? *payload : global.data});
+				}
+			}
+
+			linked.errors.insert(linked.errors.end(), std::make_move_iterator(state.errors.begin()), std::make_move_iterator(state.errors.end()));
+			linked.unresolved.insert(linked.unresolved.end(), std::make_move_iterator(state.unresolved.begin()), std::make_move_iterator(state.unresolved.end()));
+		}
+
+		LocalBuilder builder{mod};
+		for (index_type index = 0; index < function_count; ++index)
+		{
+			const auto& definition = definitions[index]->definition;
+			if (definition == nowhere) { continue; }
+
+			const auto& function = *states[definition.module].functions[definition.index];
+			builder.begin_function(*linked_functions[index]);
+			for (const auto* local: function.locals) { (void)builder.register_local(local->name); }
+			for (const auto* block: function.blocks) { (void)builder.register_block(block->sig); }
+		}
+
+		// the blocks are in place, their code is relocated in parallel (every task writes the blocks of its own function)
+		pool.parallel_for(
+				function_count,
+				[&](const std::size_t index)
+				{
+					const auto& definition = definitions[index]->definition;
+					if (definition == nowhere) { return; }
+
+					const auto& state = states[definition.module];
+					const auto& function = *state.functions[definition.index];
+					const auto& blocks = linked_functions[index]->blocks;
+					for (std::size_t slot = 0; slot < blocks.size(); ++slot)
+					{
+						const auto& code = function.blocks[slot]->code;
+						auto& relocated = blocks[slot]->code;
+						relocated.reserve(code.size());
+
+						const auto decoded = bytecode::rewrite_operands(
+								code,
+								relocated,
+								[&](const bytecode::opcode op, std::size_t, const std::uint64_t operand) -> std::uint64_t
+								{
+									switch (op)
+									{
+										case bytecode::opcode::call: { return relocate(state.function_symbols, function_count, operand); }
+										case bytecode::opcode::address: { return relocate(state.global_symbols, global_count, operand); }
+										default: { return operand; }
+									}
+								});
+						if (!decoded) { relocated = code; }
+					}
+				});
+
+		return linked;
+	}
+
+	auto link(const std::span<const Module* const> modules, symbol_name_type name) -> result
+	{
+		concurrency::ThreadPool pool{};
+		return link(modules, std::move(name), pool);
+	}
+}
@@ -0,0 +1,107 @@
+#include <CMakeTemplateProject/mapped_file.hpp>
+
+#if defined(_WIN32)
+	#ifndef WIN32_LEAN_AND_MEAN
+		#define WIN32_LEAN_AND_MEAN
+	#endif
+	#ifndef NOMINMAX
+		#define NOMINMAX
+	#endif
+	#include <Windows.h>
+#else
+	#include <fcntl.h>
+	#include <sys/mman.h>
+	#include <sys/stat.h>
+	#include <unistd.h>
+#endif
+
+namespace io
+{
+#if defined(_WIN32)
+	MappedFile::MappedFile(const char* path) noexcept
+		: MappedFile{}
+	{
+		const auto file = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+		if (file == INVALID_HANDLE_VALUE) { return; }
+
+		LARGE_INTEGER size;
+		if (!GetFileSizeEx(file, &size))
+		{
+			CloseHandle(file);
+			return;
+		}
+
+		if (size.QuadPart == 0)
+		{
+			// CreateFileMapping does not accept empty files
+			CloseHandle(file);
+			valid_ = true;
+			return;
+		}
+
+		const auto mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+		// the view keeps the file alive
+		CloseHandle(file);
+		if (mapping == nullptr) { return; }
+
+		const auto* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+		CloseHandle(mapping);
+		if (view == nullptr) { return; }
+
+		data_ = static_cast<const char*>(view);
+		size_ = static_cast<size_type>(size.QuadPart);
+		valid_ = true;
+	}
+
+	auto MappedFile::unmap() noexcept -> void
+	{
+		if (data_ != nullptr) { UnmapViewOfFile(data_); }
+		data_ = nullptr;
+		size_ = 0;
+		valid_ = false;
+	}
+#else
+	MappedFile::MappedFile(const char* path) noexcept
+		: MappedFile{}
+	{
+		const auto file = ::open(path, O_RDONLY | O_CLOEXEC);
+		if (file == -1) { return; }
+
+		struct stat status{};
+		if (::fstat(file, &status) == -1 || !S_ISREG(status.st_mode))
+		{
+			::close(file);
+			return;
+		}
+
+		if (status.st_size == 0)
+		{
+			// mmap does not accept empty files
+			::close(file);
+			valid_ = true;
+			return;
+		}
+
+		const auto size = static_cast<size_type>(status.st_size);
+		auto* view = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file, 0);
+		// the mapping keeps the file alive
+		::close(file);
+		if (view == MAP_FAILED) { return; }
+
+		// we parse front to back, let the kernel read ahead aggressively
+		(void)::madvise(view, size, MADV_SEQUENTIAL);
+
+		data_ = static_cast<const char*>(view);
+		size_ = size;
+		valid_ = true;
+	}
+
+	auto MappedFile::unmap() noexcept -> void
+	{
+		if (data_ != nullptr) { (void)::munmap(const_cast<char*>(data_), size_); }
+		data_ = nullptr;
+		size_ = 0;
+		valid_ = false;
+	}
+#endif
+}
@@ -0,0 +1,203 @@
+#include <CMakeTemplateProject/reachability.hpp>
+#include <CMakeTemplateProject/bytecode.hpp>
+
+#include <limits>
+#include <string_view>
+#include <unordered_map>
+
+namespace
+{
+	using backend::bytecode::opcode;
+
+	// old index/slot => new one, `removed` if it is not kept
+	constexpr std::uint64_t removed = std::numeric_limits<std::uint64_t>::max();
+
+	// Gives every kept element its new index, in the old order, and returns how many are kept.
+	auto renumber(const std::vector<bool>& kept, std::vector<std::uint64_t>& map) -> std::uint64_t
+	{
+		map.assign(kept.size(), removed);
+		std::uint64_t next = 0;
+		for (std::size_t i = 0; i < kept.size(); ++i)
+		{
+			if (kept[i]) { map[i] = next++; }
+		}
+		return next;
+	}
+
+	// An operand out of range stays out of range (`count` is the new number of elements).
+	[[nodiscard]] auto remap(const std::vector<std::uint64_t>& map, const std::uint64_t count, const std::uint64_t operand) -> std::uint64_t { return operand < map.size() ? map[operand] : count + (operand - map.size()); }
+}
+
+namespace backend
+{
+	auto eliminate_dead_symbols(const Module& mod, const reachability_roots& roots) -> stripped_module
+	{
+		std::vector<const Function*> functions(mod.functions().size(), nullptr);
+		mod.functions().for_each([&functions](const Function& function) { functions[function.index] = &function; });
+		std::vector<const Global*> globals(mod.globals().size(), nullptr);
+		mod.globals().for_each([&globals](const Global& global) { globals[global.index] = &global; });
+
+		stripped_module result{.module = std::make_unique<Module>(symbol_name_type{mod.module_name}), .removed_functions = 0, .removed_globals = 0, .removed_blocks = 0, .missing_roots = {}};
+
+		std::vector<bool> live_functions(functions.size(), false);
+		std::vector<bool> live_globals(globals.size(), false);
+		// index => slot => reachable from the entry
+		std::vector<std::vector<bool>> live_blocks(functions.size());
+		std::vector<backend::index_type> pending{};
+
+		const auto reach_function = [&](const std::uint64_t index)
+		{
+			if (index >= functions.size() || live_functions[index]) { return; }
+			live_functions[index] = true;
+			pending.push_back(static_cast<index_type>(index));
+		};
+		const auto reach_global = [&](const std::uint64_t index)
+		{
+			if (index < globals.size()) { live_globals[index] = true; }
+		};
+
+		{
+			std::unordered_map<std::string_view, index_type> function_names{};
+			for (const auto* function: functions) { function_names.emplace(function->name, function->index); }
+			std::unordered_map<std::string_view, index_type> global_names{};
+			for (const auto* global: globals) { global_names.emplace(global->name, global->index); }
+
+			for (const auto& name: roots.functions)
+			{
+				if (const auto it = function_names.find(name);
+					it != function_names.end()) { reach_function(it->second); }
+				else { result.missing_roots.push_back(name); }
+			}
+			for (const auto& name: roots.globals)
+			{
+				if (const auto it = global_names.find(name);
+					it != global_names.end()) { reach_global(it->second); }
+				else { result.missing_roots.push_back(name); }
+			}
+		}
+
+		while (!pending.empty())
+		{
+			const auto& function = *functions[pending.back()];
+			pending.pop_back();
+
+			auto& blocks = live_blocks[function.index];
+			blocks.assign(function.blocks.size(), false);
+			if (blocks.empty()) { continue; }
+
+			std::vector<std::size_t> pending_blocks{0};
+			blocks[0] = true;
+			const auto reach_block = [&](const std::uint64_t slot)
+			{
+				if (slot >= blocks.size() || blocks[slot]) { return; }
+				blocks[slot] = true;
+				pending_blocks.push_back(static_cast<std::size_t>(slot));
+			};
+
+			while (!pending_blocks.empty())
+			{
+				const auto& block = *function.blocks[pending_blocks.back()];
+				pending_blocks.pop_back();
+
+				(void)bytecode::for_each_instruction(
+						block.code,
+						[&](const bytecode::instruction& instruction)
+						{
+							switch (instruction.op)
+							{
+								case opcode::call:
+								{
+									reach_function(instruction.operands[0]);
+									break;
+								}
+								case opcode::address:
+								{
+									reach_global(instruction.operands[0]);
+									break;
+								}
+								case opcode::if_else:
+								{
+									reach_block(instruction.operands[1]);
+									[[fallthrough]];
+								}
+								case opcode::call_block:
+								case opcode::if_:
+								case opcode::loop:
+								{
+									reach_block(instruction.operands[0]);
+									break;
+								}
+								default: { break; }
+							}
+						});
+			}
+		}
+
+		std::vector<std::uint64_t> function_map{};
+		const auto function_count = renumber(live_functions, function_map);
+		std::vector<std::uint64_t> global_map{};
+		const auto global_count = renumber(live_globals, global_map);
+
+		result.removed_functions = functions.size() - function_count;
+		result.removed_globals = globals.size() - global_count;
+
+		auto& stripped = *result.module;
+		LocalBuilder builder{stripped};
+		for (const auto* function: functions)
+		{
+			if (!live_functions[function->index])
+			{
+				result.removed_blocks += function->blocks.size();
+				continue;
+			}
+
+			auto* copy = stripped.register_function(function->name, function->sig);
+			builder.begin_function(*copy);
+			for (const auto* local: function->locals) { (void)builder.register_local(local->name); }
+
+			std::vector<std::uint64_t> block_map{};
+			const auto block_count = renumber(live_blocks[function->index], block_map);
+			result.removed_blocks += function->blocks.size() - block_count;
+
+			for (const auto* block: function->blocks)
+			{
+				if (block_map[block->slot] == removed) { continue; }
+
+				auto& code = builder.register_block(block->sig)->code;
+				code.reserve(block->code.size());
+				const auto decoded = bytecode::rewrite_operands(
+						block->code,
+						code,
+						[&](const opcode op, std::size_t, const std::uint64_t operand) -> std::uint64_t
+						{
+							switch (op)
+							{
+								case opcode::call: { return remap(function_map, function_count, operand); }
+								case opcode::address: { return remap(global_map, global_count, operand); }
+								case opcode::call_block:
+								case opcode::if_:
+								case opcode::if_else:
+								case opcode::loop: { return remap(block_map, block_count, operand); }
+								default: { return operand; }
+							}
+						});
+				if (!decoded) { code = block->code; }
+			}
+		}
+
+		for (const auto* global: globals)
+		{
+			if (!live_globals[global->index]) { continue; }
+
+			if (global->kind == Global::kind_type::mutable_data) { (void)stripped.register_global_mutable_data(global->name, data_type{global->data}); }
+			else
+			{
+				// interned again as the payload itself, not as a data around it
+				const auto* payload = global->data.payload();
+				(void)stripped.register_global_immutable_data(global->name, data_type{payload != nullptr ? *payload : global->data});
+			}
+		}
+
+		return result;
+	}
+}
@@ -0,0 +1,141 @@
+#include <CMakeTemplateProject/scanning.hpp>
+
+#include <bit>
+#include <cstring>
+
+// eve does not support MSVC
+#if __has_include(<eve/wide.hpp>) && !defined(CMakeTemplateProject_COMPILER_MSVC) && !defined(_MSC_VER)
+#define CTP_SCANNING_EVE 1
+#include <eve/wide.hpp>
+#include <eve/module/core.hpp>
+#else
+#define CTP_SCANNING_EVE 0
+#endif
+
+namespace
+{
+	#if CTP_SCANNING_EVE
+	// index of the first character of the next eve::wide which is not of the class, `width` if there is none
+	struct vector_kernel
+	{
+		using wide_type = eve::wide<std::uint8_t>;
+
+		constexpr static std::size_t width = wide_type::size();
+
+		[[nodiscard]] static auto first_of(const auto mask) noexcept -> std::ptrdiff_t
+		{
+			if (const auto first = eve::first_true(mask); first.has_value()) { return *first; }
+			return static_cast<std::ptrdiff_t>(width);
+		}
+
+		[[nodiscard]] static auto first_non_identifier(const char8_t* p) noexcept -> std::ptrdiff_t
+		{
+			const wide_type c{reinterpret_cast<const std::uint8_t*>(p)};
+
+			// the subtractions wrap around, everything below the lower bound ends up above the upper one
+			const auto alpha = ((c | std::uint8_t{0x20}) - std::uint8_t{'a'}) < std::uint8_t{26};
+			const auto digit = (c - std::uint8_t{'0'}) < std::uint8_t{10};
+			const auto other = (c == std::uint8_t{'_'}) || (c == std::uint8_t{'.'});
+
+			return first_of(!(alpha || digit || other));
+		}
+
+		[[nodiscard]] static auto first_non_space(const char8_t* p) noexcept -> std::ptrdiff_t
+		{
+			const wide_type c{reinterpret_cast<const std::uint8_t*>(p)};
+
+			// '\t' '\n' '\v' '\f' '\r'
+			const auto control = (c - std::uint8_t{'\t'}) < std::uint8_t{5};
+
+			return first_of(!(control || (c == std::uint8_t{' '})));
+		}
+	};
+	#else
+	// SWAR, 8 bytes in a 64-bit word
+	struct vector_kernel
+	{
+		constexpr static std::size_t width = sizeof(std::uint64_t);
+
+		constexpr static std::uint64_t ones = 0x0101'0101'0101'0101;
+		constexpr static std::uint64_t high = 0x8080'8080'8080'8080;
+
+		// high bit of every byte (< 0x80) which is >= k
+		[[nodiscard]] constexpr static auto at_least(const std::uint64_t x, const std::uint8_t k) noexcept -> std::uint64_t { return ((x | high) - ones * k) & high; }
+
+		// high bit of every byte (< 0x80) in [low, high]
+		[[nodiscard]] constexpr static auto in_range(const std::uint64_t x, const std::uint8_t low, const std::uint8_t up) noexcept -> std::uint64_t { return at_least(x, low) & ~at_least(x, static_cast<std::uint8_t>(up + 1)); }
+
+		[[nodiscard]] static auto load(const char8_t* p) noexcept -> std::uint64_t
+		{
+			std::uint64_t word;
+			std::memcpy(&word, p, sizeof(word));
+			// byte 0 is the lowest one
+			if constexpr (std::endian::native == std::endian::big) { word = std::byteswap(word); }
+			return word;
+		}
+
+		// `valid` has the high bit of every byte of the class set, non ASCII bytes never are
+		[[nodiscard]] static auto first_invalid(const std::uint64_t word, const std::uint64_t valid) noexcept -> std::ptrdiff_t { return std::countr_zero((~valid & high) | (word & high)) / 8; }
+
+		[[nodiscard]] static auto first_non_identifier(const char8_t* p) noexcept -> std::ptrdiff_t
+		{
+			const auto word = load(p);
+			const auto x = word & ~high;
+
+			return first_invalid(
+					word,
+					in_range(x | (ones * 0x20), 'a', 'z') |
+					in_range(x, '0', '9') |
+					in_range(x, '_', '_') |
+					in_range(x, '.', '.'));
+		}
+
+		[[nodiscard]] static auto first_non_space(const char8_t* p) noexcept -> std::ptrdiff_t
+		{
+			const auto word = load(p);
+			const auto x = word & ~high;
+
+			return first_invalid(word, in_range(x, '\t', '\r') | in_range(x, ' ', ' '));
+		}
+	};
+	#endif
+
+	// The first character in [begin, end) which is not of the class, a vector at a time and then one at a time for the tail.
+	template<auto FirstNotOfVector, auto IsOfClass>
+	[[nodiscard]] auto skip(const char8_t* begin, const char8_t* end) noexcept -> const char8_t*
+	{
+		auto* p = begin;
+		for (; static_cast<std::size_t>(end - p) >= vector_kernel::width; p += vector_kernel::width)
+		{
+			if (const auto first = FirstNotOfVector(p);
+				first != static_cast<std::ptrdiff_t>(vector_kernel::width)) { return p + first; }
+		}
+
+		while (p != end && IsOfClass(*p)) { ++p; }
+		return p;
+	}
+}
+
+namespace scanning
+{
+	auto identifier_length(const char8_t* begin, const char8_t* end) noexcept -> std::size_t
+	{
+		return static_cast<std::size_t>(skip<vector_kernel::first_non_identifier, is_identifier_character>(begin, end) - begin);
+	}
+
+	auto whitespace_length(const char8_t* begin, const char8_t* end) noexcept -> std::size_t
+	{
+		auto* p = begin;
+		while (true)
+		{
+			p = skip<vector_kernel::first_non_space, is_space>(p, end);
+			if (p == end || *p != u8'#') { break; }
+
+			// a comment runs up to (and including) the end of the line, an unterminated one is left to the caller
+			const auto* newline = static_cast<const char8_t*>(std::memchr(p, '\n', static_cast<std::size_t>(end - p)));
+			if (newline == nullptr) { break; }
+			p = newline + 1;
+		}
+		return static_cast<std::size_t>(p - begin);
+	}
+}
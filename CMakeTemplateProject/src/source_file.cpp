@@ -0,0 +1,37 @@
+#include <CMakeTemplateProject/source_file.hpp>
+
+#include <lexy/input/file.hpp>
+
+#include <cstring>
+
+namespace io
+{
+	auto SourceFile::open(const char* path) -> std::optional<SourceFile>
+	{
+		if (MappedFile mapped{path};
+			mapped)
+		{
+			constexpr char bom[] = {'\xef', '\xbb', '\xbf'};
+			const auto skipped = mapped.size() >= sizeof(bom) && std::memcmp(mapped.data(), bom, sizeof(bom)) == 0 ? sizeof(bom) : 0;
+			return SourceFile{std::move(mapped), skipped};
+		}
+
+		// the byte order mark is dropped by lexy
+		if (auto file = lexy::read_file<lexy::utf8_encoding>(path);
+			file) { return SourceFile{std::move(file).buffer(), 0}; }
+
+		return std::nullopt;
+	}
+
+	auto SourceFile::data() const noexcept -> const char_type*
+	{
+		if (const auto* mapped = std::get_if<MappedFile>(&storage_)) { return mapped->data() == nullptr ? nullptr : reinterpret_cast<const char_type*>(mapped->data()) + skipped_; }
+		return std::get<lexy::buffer<lexy::utf8_encoding>>(storage_).data();
+	}
+
+	auto SourceFile::size() const noexcept -> size_type
+	{
+		if (const auto* mapped = std::get_if<MappedFile>(&storage_)) { return mapped->size() - skipped_; }
+		return std::get<lexy::buffer<lexy::utf8_encoding>>(storage_).size();
+	}
+}
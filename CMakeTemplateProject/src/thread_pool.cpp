@@ -0,0 +1,135 @@
+#include <CMakeTemplateProject/thread_pool.hpp>
+
+namespace
+{
+	// the queue owned by the current thread, if it is one of our workers
+	thread_local const void* this_thread_pool = nullptr;
+	thread_local std::size_t this_thread_queue = 0;
+}
+
+namespace concurrency
+{
+	ThreadPool::ThreadPool(size_type thread_count)
+		: stopping_{false},
+		queued_{0},
+		next_queue_{0}
+	{
+		if (thread_count == 0) { thread_count = 1; }
+
+		queues_.reserve(thread_count);
+		for (size_type i = 0; i < thread_count; ++i) { queues_.push_back(std::make_unique<worker_queue>()); }
+
+		workers_.reserve(thread_count);
+		for (size_type i = 0; i < thread_count; ++i) { workers_.emplace_back([this, i] { work(i); }); }
+	}
+
+	ThreadPool::~ThreadPool() noexcept
+	{
+		{
+			const std::lock_guard lock{sleep_mutex_};
+			stopping_ = true;
+		}
+		wake_worker_.notify_all();
+
+		// std::jthread joins on destruction
+		workers_.clear();
+	}
+
+	auto ThreadPool::push(task_type&& task) -> void
+	{
+		// workers push into their own queue (nested parallelism stays local), everybody else round-robin
+		const auto index =
+				this_thread_pool == this
+					? this_thread_queue
+					: next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+
+		{
+			auto& queue = *queues_[index];
+			const std::lock_guard lock{queue.mutex};
+			queue.tasks.push_back(std::move(task));
+			queued_.fetch_add(1, std::memory_order_release);
+		}
+
+		// take the lock so that a worker which just checked `queued_` cannot miss the notification
+		{
+			const std::lock_guard lock{sleep_mutex_};
+		}
+		wake_worker_.notify_one();
+		wake_waiter_.notify_all();
+	}
+
+	auto ThreadPool::try_pop(const size_type preferred_queue, task_type& task) -> bool
+	{
+		if (queued_.load(std::memory_order_acquire) == 0) { return false; }
+
+		// own queue first (LIFO, the data is most likely still in cache)
+		{
+			auto& queue = *queues_[preferred_queue];
+			const std::lock_guard lock{queue.mutex};
+			if (!queue.tasks.empty())
+			{
+				task = std::move(queue.tasks.back());
+				queue.tasks.pop_back();
+				queued_.fetch_sub(1, std::memory_order_release);
+				return true;
+			}
+		}
+
+		// then steal (FIFO, the oldest tasks are most likely the biggest)
+		for (size_type offset = 1; offset < queues_.size(); ++offset)
+		{
+			auto& queue = *queues_[(preferred_queue + offset) % queues_.size()];
+			const std::lock_guard lock{queue.mutex};
+			if (!queue.tasks.empty())
+			{
+				task = std::move(queue.tasks.front());
+				queue.tasks.pop_front();
+				queued_.fetch_sub(1, std::memory_order_release);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	auto ThreadPool::work(const size_type index) -> void
+	{
+		this_thread_pool = this;
+		this_thread_queue = index;
+
+		task_type task;
+		while (true)
+		{
+			if (try_pop(index, task))
+			{
+				task();
+				task = nullptr;
+				continue;
+			}
+
+			std::unique_lock lock{sleep_mutex_};
+			wake_worker_.wait(lock, [this] { return stopping_ || queued_.load(std::memory_order_acquire) != 0; });
+			if (stopping_ && queued_.load(std::memory_order_acquire) == 0) { return; }
+		}
+	}
+
+	auto ThreadPool::help_until(const std::function<bool()>& done) -> void
+	{
+		const auto index = this_thread_pool == this ? this_thread_queue : 0;
+
+		task_type task;
+		while (!done())
+		{
+			if (try_pop(index, task))
+			{
+				task();
+				task = nullptr;
+				continue;
+			}
+
+			// nothing left to steal, the remaining tasks are running on other threads
+			std::unique_lock lock{sleep_mutex_};
+			wake_waiter_.wait(lock, [this, &done] { return done() || queued_.load(std::memory_order_acquire) != 0; });
+		}
+	}
+}
@@ -0,0 +1,61 @@
+#include <CMakeTemplateProject/verifier.hpp>
+#include <CMakeTemplateProject/thread_pool.hpp>
+
+namespace
+{
+	// function index => function
+	[[nodiscard]] auto function_table(const backend::Module& mod) -> std::vector<const backend::Function*>
+	{
+		std::vector<const backend::Function*> result(mod.functions().size(), nullptr);
+		mod.functions().for_each([&result](const backend::Function& function) { result[function.index] = &function; });
+		return result;
+	}
+
+	auto verify_range(const backend::Module& mod, const std::span<const backend::Function* const> functions, const std::size_t begin, const std::size_t end, std::vector<backend::verifier::function_error>& errors) -> void
+	{
+		const auto callee = [functions](const std::uint64_t index) -> std::optional<backend::Function::signature>
+		{
+			if (index >= functions.size()) { return std::nullopt; }
+			return functions[index]->sig;
+		};
+
+		for (auto i = begin; i != end; ++i)
+		{
+			if (const auto error = backend::verifier::verify_function(*functions[i], mod.globals().size(), callee);
+				error.has_value()) { errors.push_back({.function = functions[i], .what = *error}); }
+		}
+	}
+}
+
+namespace backend::verifier
+{
+	auto verify_module(const Module& mod) -> std::vector<function_error>
+	{
+		const auto functions = function_table(mod);
+
+		std::vector<function_error> errors{};
+		verify_range(mod, functions, 0, functions.size(), errors);
+		return errors;
+	}
+
+	auto verify_module(const Module& mod, concurrency::ThreadPool& pool) -> std::vector<function_error>
+	{
+		const auto functions = function_table(mod);
+
+		// a few chunks per worker, most functions are too small to be worth a task of their own
+		const auto chunk_count = std::min(functions.size(), std::max<std::size_t>(pool.size(), 1) * 4);
+		std::vector<std::vector<function_error>> chunk_errors(chunk_count);
+		pool.parallel_for(
+				chunk_count,
+				[&](const std::size_t index)
+				{
+					const auto begin = functions.size() * index / chunk_count;
+					const auto end = functions.size() * (index + 1) / chunk_count;
+					verify_range(mod, functions, begin, end, chunk_errors[index]);
+				});
+
+		std::vector<function_error> errors{};
+		for (auto& chunk: chunk_errors) { errors.insert(errors.end(), chunk.begin(), chunk.end()); }
+		return errors;
+	}
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+
+namespace benchmark
+{
+	// The shape of a generated module.
+	// The same options (and seed) always give the same text.
+	struct GeneratorOptions
+	{
+		std::uint64_t seed;
+
+		std::size_t globals;
+		std::size_t functions;
+
+		std::size_t locals_per_function;
+		// 0 => the body is a plain instruction list (the entry block only)
+		std::size_t blocks_per_function;
+		std::size_t instructions_per_block;
+
+		// nesting level of the `[...] * n` repetitions in data expressions, and the number of items per level
+		std::size_t data_depth;
+		std::size_t data_width;
+
+		// fraction [0, 1] of the declarations preceded by a `#` comment line
+		double comment_density;
+	};
+
+	struct GeneratedModule
+	{
+		std::uint64_t bytes;
+		// top-level (global/function) declarations
+		std::size_t declarations;
+	};
+
+	// Writes a valid module, globals and functions are interleaved in proportion.
+	auto generate_module(const GeneratorOptions& options, std::ostream& out) -> GeneratedModule;
+
+	// Scales the number of globals and functions of `shape` so that the module is about `target_bytes` long.
+	[[nodiscard]] auto options_for_size(std::uint64_t target_bytes, const GeneratorOptions& shape) -> GeneratorOptions;
+}
@@ -0,0 +1,185 @@
+#include <module_generator.hpp>
+
+#include <CMakeTemplateProject/frontend.hpp>
+
+#include <fmt/format.h>
+
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#include <psapi.h>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace
+{
+	// the shape every size is scaled from, roughly what our generated modules look like
+	constexpr benchmark::GeneratorOptions default_shape{
+			.seed = 0x00c0'ffee,
+			.globals = 64,
+			.functions = 64,
+			.locals_per_function = 4,
+			.blocks_per_function = 3,
+			.instructions_per_block = 4,
+			.data_depth = 2,
+			.data_width = 3,
+			.comment_density = 0.25};
+
+	constexpr std::uint64_t kb = 1024;
+	constexpr std::uint64_t mb = 1024 * kb;
+	constexpr std::uint64_t gb = 1024 * mb;
+
+	// every size is parsed at least that long (after one warm-up run)
+	constexpr std::chrono::seconds minimum_duration{1};
+	constexpr std::size_t minimum_iterations = 3;
+
+	[[nodiscard]] auto peak_rss() -> std::uint64_t
+	{
+		#if defined(_WIN32)
+		PROCESS_MEMORY_COUNTERS counters{};
+		if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) { return 0; }
+		return counters.PeakWorkingSetSize;
+		#else
+		rusage usage{};
+		if (getrusage(RUSAGE_SELF, &usage) != 0) { return 0; }
+		#if defined(__APPLE__)
+		return static_cast<std::uint64_t>(usage.ru_maxrss);
+		#else
+		// kilobytes
+		return static_cast<std::uint64_t>(usage.ru_maxrss) * kb;
+		#endif
+		#endif
+	}
+
+	// 64K, 16M, 1G...
+	[[nodiscard]] auto parse_size(const std::string_view text) -> std::optional<std::uint64_t>
+	{
+		if (text.empty()) { return std::nullopt; }
+
+		std::uint64_t unit = 1;
+		auto digits = text;
+		switch (text.back())
+		{
+			case 'k':
+			case 'K': { unit = kb; break; }
+			case 'm':
+			case 'M': { unit = mb; break; }
+			case 'g':
+			case 'G': { unit = gb; break; }
+			default: { break; }
+		}
+		if (unit != 1) { digits.remove_suffix(1); }
+
+		std::uint64_t value = 0;
+		if (digits.empty()) { return std::nullopt; }
+		for (const auto c: digits)
+		{
+			if (c < '0' || c > '9') { return std::nullopt; }
+			value = value * 10 + static_cast<std::uint64_t>(c - '0');
+		}
+		return value * unit;
+	}
+
+	struct measurement
+	{
+		std::uint64_t bytes;
+		std::size_t declarations;
+		std::size_t iterations;
+		std::chrono::duration<double> elapsed;
+	};
+
+	[[nodiscard]] auto run(const std::uint64_t target_bytes, const std::filesystem::path& path) -> std::optional<measurement>
+	{
+		const auto options = benchmark::options_for_size(target_bytes, default_shape);
+
+		benchmark::GeneratedModule generated{};
+		{
+			std::ofstream out{path, std::ios::binary | std::ios::trunc};
+			if (!out)
+			{
+				fmt::print(stderr, "cannot write '{}'\n", path.string());
+				return std::nullopt;
+			}
+			generated = benchmark::generate_module(options, out);
+		}
+
+		const auto filename = path.string();
+		// warm-up, also checks the generator
+		if (const auto result = frontend::parse_file(filename, 16);
+			!result.succeeded())
+		{
+			fmt::print(stderr, "generated module does not parse ({} errors):\n{}", result.error_count, result.diagnostics);
+			return std::nullopt;
+		}
+
+		measurement m{.bytes = generated.bytes, .declarations = generated.declarations, .iterations = 0, .elapsed = {}};
+		const auto begin = std::chrono::steady_clock::now();
+		do
+		{
+			(void)frontend::parse_file(filename);
+			++m.iterations;
+			m.elapsed = std::chrono::steady_clock::now() - begin;
+		} while (m.elapsed < minimum_duration || m.iterations < minimum_iterations);
+
+		return m;
+	}
+}
+
+// CMakeTemplateProject-benchmark [size...]
+// Sizes take an optional K/M/G suffix, the default is 64K 1M 16M 256M.
+// The peak RSS is the one of the whole process so far, so sizes should be given in ascending order.
+auto main(const int argc, const char* argv[]) -> int
+{
+	std::vector<std::uint64_t> sizes{};
+	for (int i = 1; i < argc; ++i)
+	{
+		const auto size = parse_size(argv[i]);
+		if (!size.has_value() || *size == 0)
+		{
+			fmt::print(stderr, "invalid size '{}'\n", argv[i]);
+			return 1;
+		}
+		sizes.push_back(*size);
+	}
+	if (sizes.empty()) { sizes = {64 * kb, mb, 16 * mb, 256 * mb}; }
+
+	const auto path = std::filesystem::temp_directory_path() / "CMakeTemplateProject-benchmark.ctp";
+
+	fmt::print("{:>12} {:>12} {:>8} {:>10} {:>14} {:>12}\n", "size", "declarations", "runs", "MB/s", "declarations/s", "peak RSS MB");
+	for (const auto target: sizes)
+	{
+		const auto m = run(target, path);
+		if (!m.has_value())
+		{
+			std::error_code error{};
+			std::filesystem::remove(path, error);
+			return 1;
+		}
+
+		const auto seconds = m->elapsed.count() / static_cast<double>(m->iterations);
+		fmt::print(
+				"{:>12} {:>12} {:>8} {:>10.1f} {:>14.0f} {:>12.1f}\n",
+				m->bytes,
+				m->declarations,
+				m->iterations,
+				static_cast<double>(m->bytes) / static_cast<double>(mb) / seconds,
+				static_cast<double>(m->declarations) / seconds,
+				static_cast<double>(peak_rss()) / static_cast<double>(mb));
+		(void)std::fflush(stdout);
+	}
+
+	std::error_code error{};
+	std::filesystem::remove(path, error);
+}
@@ -0,0 +1,236 @@
+#include <module_generator.hpp>
+
+#include <fmt/format.h>
+
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+#include <string>
+#include <string_view>
+
+namespace
+{
+	// splitmix64, good enough and identical everywhere (unlike the std distributions)
+	class Random
+	{
+	public:
+		explicit Random(const std::uint64_t seed) noexcept
+			: state_{seed} {}
+
+		auto next() noexcept -> std::uint64_t
+		{
+			auto z = (state_ += 0x9e37'79b9'7f4a'7c15);
+			z = (z ^ (z >> 30)) * 0xbf58'476d'1ce4'e5b9;
+			z = (z ^ (z >> 27)) * 0x94d0'49bb'1331'11eb;
+			return z ^ (z >> 31);
+		}
+
+		// [0, bound)
+		auto below(const std::uint64_t bound) noexcept -> std::uint64_t { return bound == 0 ? 0 : next() % bound; }
+
+		// [0, 1)
+		auto fraction() noexcept -> double { return static_cast<double>(next() >> 11) * 0x1.0p-53; }
+
+	private:
+		std::uint64_t state_;
+	};
+
+	class Generator
+	{
+	public:
+		Generator(const benchmark::GeneratorOptions& options, std::ostream& out)
+			: options_{options},
+			out_{out},
+			random_{options.seed},
+			written_{0} {}
+
+		auto run() -> benchmark::GeneratedModule
+		{
+			fmt::format_to(std::back_inserter(buffer_), "# generated, seed {}\nmodule @bench;\n\n", options_.seed);
+
+			// spread the globals evenly between the functions
+			const auto total = options_.globals + options_.functions;
+			std::size_t globals = 0;
+			std::size_t functions = 0;
+			for (std::size_t i = 0; i < total; ++i)
+			{
+				if (random_.fraction() < options_.comment_density) { fmt::format_to(std::back_inserter(buffer_), "# declaration {}, {}\n", i, random_.next()); }
+
+				if (globals < options_.globals && (functions == options_.functions || globals * total <= i * options_.globals)) { global(globals++); }
+				else { function(functions++); }
+
+				if (buffer_.size() >= flush_size) { flush(); }
+			}
+			flush();
+
+			return {.bytes = written_, .declarations = total};
+		}
+
+	private:
+		constexpr static std::size_t flush_size = 1024 * 1024;
+
+		const benchmark::GeneratorOptions& options_;
+		std::ostream& out_;
+		Random random_;
+
+		std::string buffer_;
+		std::uint64_t written_;
+
+		auto flush() -> void
+		{
+			out_.write(buffer_.data(), static_cast<std::streamsize>(buffer_.size()));
+			written_ += buffer_.size();
+			buffer_.clear();
+		}
+
+		auto data(const std::size_t depth) -> void
+		{
+			const auto width = std::max<std::size_t>(options_.data_width, 1);
+			for (std::size_t i = 0; i < width; ++i)
+			{
+				if (i != 0) { buffer_.append(", "); }
+
+				switch (const auto choice = depth == 0 ? random_.below(2) : random_.below(3))
+				{
+					case 0:
+					{
+						fmt::format_to(std::back_inserter(buffer_), "{:02x}", random_.below(256));
+						break;
+					}
+					case 1:
+					{
+						buffer_.push_back('"');
+						for (auto n = 1 + random_.below(12); n != 0; --n) { buffer_.push_back(static_cast<char>('a' + random_.below(26))); }
+						buffer_.push_back('"');
+						break;
+					}
+					default:
+					{
+						(void)choice;
+						buffer_.push_back('[');
+						data(depth - 1);
+						fmt::format_to(std::back_inserter(buffer_), "] * {}", 1 + random_.below(16));
+						break;
+					}
+				}
+			}
+		}
+
+		auto global(const std::size_t index) -> void
+		{
+			fmt::format_to(std::back_inserter(buffer_), "global {}@g{} = ", random_.below(2) == 0 ? "const " : "", index);
+			data(options_.data_depth);
+			buffer_.append(";\n");
+		}
+
+		// A mix of every kind of operand, only locals of the function are used.
+		// The stack never goes below the inputs of the block and ends with its outputs, so that the module verifies.
+		auto instructions(const std::size_t indent, const std::size_t input, const std::size_t output) -> void
+		{
+			struct builtin
+			{
+				std::string_view name;
+				std::size_t input;
+				std::size_t output;
+			};
+
+			constexpr builtin builtins[]{{"add", 2, 1}, {"sub", 2, 1}, {"mul", 2, 1}, {"xor", 2, 1}, {"eq", 2, 1}, {"lt", 2, 1}, {"dup", 1, 2}, {"drop", 1, 0}, {"swap", 2, 2}};
+
+			const auto push = [this](std::size_t& height)
+			{
+				fmt::format_to(std::back_inserter(buffer_), "push {}\n", static_cast<std::int64_t>(random_.below(2000)) - 1000);
+				++height;
+			};
+
+			auto height = input;
+			const auto count = std::max<std::size_t>(options_.instructions_per_block, 1);
+			for (std::size_t i = 0; i < count; ++i)
+			{
+				fmt::format_to(std::back_inserter(buffer_), "{:\t>{}}", "", indent);
+				switch (random_.below(options_.locals_per_function == 0 ? 3 : 5))
+				{
+					case 0:
+					{
+						buffer_.append("dummy\n");
+						break;
+					}
+					case 1:
+					{
+						push(height);
+						break;
+					}
+					case 2:
+					{
+						const auto& b = builtins[random_.below(std::size(builtins))];
+						if (height < b.input) { push(height); }
+						else
+						{
+							fmt::format_to(std::back_inserter(buffer_), "${}\n", b.name);
+							height = height - b.input + b.output;
+						}
+						break;
+					}
+					default:
+					{
+						const auto get = height == 0 || random_.below(2) == 0;
+						fmt::format_to(std::back_inserter(buffer_), "{} %l{}\n", get ? "get" : "set", random_.below(options_.locals_per_function));
+						height = get ? height + 1 : height - 1;
+						break;
+					}
+				}
+			}
+
+			for (; height > output; --height) { fmt::format_to(std::back_inserter(buffer_), "{:\t>{}}$drop\n", "", indent); }
+			while (height < output)
+			{
+				fmt::format_to(std::back_inserter(buffer_), "{:\t>{}}", "", indent);
+				push(height);
+			}
+		}
+
+		auto function(const std::size_t index) -> void
+		{
+			const auto input = random_.below(4);
+			const auto output = random_.below(4);
+			fmt::format_to(std::back_inserter(buffer_), "function @f{} [{}=>{}]\n{{\n", index, input, output);
+
+			for (std::size_t i = 0; i < options_.locals_per_function; ++i) { fmt::format_to(std::back_inserter(buffer_), "\tlocal %l{};\n", i); }
+
+			if (options_.blocks_per_function == 0) { instructions(1, input, output); }
+			else
+			{
+				for (std::size_t i = 0; i < options_.blocks_per_function; ++i)
+				{
+					// the first block is the entry, it has the signature of the function
+					const auto block_input = i == 0 ? input : random_.below(4);
+					const auto block_output = i == 0 ? output : random_.below(4);
+					fmt::format_to(std::back_inserter(buffer_), "\tblock %b{} [{}=>{}]\n\t{{\n", i, block_input, block_output);
+					instructions(2, block_input, block_output);
+					buffer_.append("\t}\n");
+				}
+			}
+
+			buffer_.append("}\n\n");
+		}
+	};
+}
+
+namespace benchmark
+{
+	auto generate_module(const GeneratorOptions& options, std::ostream& out) -> GeneratedModule { return Generator{options, out}.run(); }
+
+	auto options_for_size(const std::uint64_t target_bytes, const GeneratorOptions& shape) -> GeneratorOptions
+	{
+		// measure a sample of the shape, then scale it linearly
+		std::ostringstream sample{};
+		const auto [bytes, declarations] = generate_module(shape, sample);
+
+		if (bytes == 0 || declarations == 0) { return shape; }
+
+		const auto scale = static_cast<double>(target_bytes) / static_cast<double>(bytes);
+		auto result = shape;
+		result.globals = std::max<std::size_t>(1, static_cast<std::size_t>(static_cast<double>(shape.globals) * scale));
+		result.functions = std::max<std::size_t>(1, static_cast<std::size_t>(static_cast<double>(shape.functions) * scale));
+		return result;
+	}
+}
@@ -0,0 +1,54 @@
+#include <CMakeTemplateProject/arena.hpp>
+
+#define BOOST_UT_DISABLE_MODULE
+
+#include <boost/ut.hpp>
+
+#include <string>
+
+using namespace boost::ut;
+
+suite test_arena = []
+{
+	"bump allocation"_test = []
+	{
+		memory::Arena arena{64};
+
+		auto* i = arena.make<int>(42);
+		auto* d = arena.make<double>(3.14);
+		expect(*i == 42_i);
+		expect(*d == 3.14_d);
+		expect(reinterpret_cast<std::uintptr_t>(d) % alignof(double) == 0_ul);
+
+		// larger than the block size
+		(void)arena.allocate(1024, alignof(std::max_align_t));
+		expect(arena.bytes_reserved() >= 1024_ul);
+
+		arena.release();
+		expect(arena.bytes_used() == 0_ul);
+	};
+
+	"object pool"_test = []
+	{
+		memory::Arena arena{};
+
+		int destroyed = 0;
+		{
+			struct counter
+			{
+				int* destroyed;
+				std::string payload;
+
+				~counter() noexcept { ++*destroyed; }
+			};
+
+			memory::ObjectPool<counter> pool{arena};
+			for (int i = 0; i < 1000; ++i) { (void)pool.make(&destroyed, std::to_string(i)); }
+			expect(pool.size() == 1000_ul);
+
+			int index = 0;
+			pool.for_each([&index](const counter& c) { expect(c.payload == std::to_string(index++)); });
+		}
+		expect(destroyed == 1000_i);
+	};
+};
@@ -0,0 +1,30 @@
+#include <CMakeTemplateProject/builtin.hpp>
+
+#define BOOST_UT_DISABLE_MODULE
+
+#include <boost/ut.hpp>
+
+using namespace boost::ut;
+
+suite test_builtin = []
+{
+	"every builtin is found by its name"_test = []
+	{
+		for (const auto& function: backend::builtin::functions.entries()) { expect(backend::builtin::functions.find(function.name) == &function) << function.name; }
+		for (const auto& type: backend::builtin::types.entries()) { expect(backend::builtin::types.find(type.name) == &type) << type.name; }
+	};
+
+	"unknown names are not found"_test = []
+	{
+		expect(backend::builtin::functions.find("") == nullptr);
+		expect(backend::builtin::functions.find("addd") == nullptr);
+		expect(backend::builtin::functions.find("i32") == nullptr);
+		expect(backend::builtin::types.find("add") == nullptr);
+	};
+
+	"lookups are constant expressions"_test = []
+	{
+		static_assert(backend::builtin::functions.find("swap")->sig.input == 2);
+		static_assert(backend::builtin::types.find("i64")->size == 8);
+	};
+};
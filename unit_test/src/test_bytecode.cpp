@@ -0,0 +1,70 @@
+#include <CMakeTemplateProject/bytecode.hpp>
+
+#define BOOST_UT_DISABLE_MODULE
+
+#include <boost/ut.hpp>
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+using namespace boost::ut;
+using namespace backend::bytecode;
+
+suite test_bytecode = []
+{
+	"instructions read back as written"_test = []
+	{
+		const std::vector<std::int64_t> immediates{0, 1, -1, 63, -64, 64, std::numeric_limits<std::int64_t>::max(), std::numeric_limits<std::int64_t>::min()};
+
+		code_type code{};
+		for (const auto immediate: immediates) { emit_push(code, immediate); }
+		emit(code, opcode::get, 127);
+		emit(code, opcode::if_else, 128, 3);
+		emit(code, builtin_opcode(backend::BuiltinFunction::id_type::swap));
+
+		std::vector<instruction> instructions{};
+		expect((for_each_instruction(code, [&instructions](const instruction& i) { instructions.push_back(i); })) >> fatal);
+		expect((instructions.size() == immediates.size() + 3) >> fatal);
+
+		for (std::size_t i = 0; i < immediates.size(); ++i)
+		{
+			expect(instructions[i].op == opcode::push);
+			expect(instructions[i].immediate() == immediates[i]);
+		}
+		expect(instructions[8].op == opcode::get and instructions[8].operands[0] == 127_ull);
+		expect(instructions[9].op == opcode::if_else and instructions[9].operands[0] == 128_ull and instructions[9].operands[1] == 3_ull);
+		expect(instructions[10].op == opcode::swap);
+		expect(instructions[10].next == code.size());
+	};
+
+	"small operands take one byte"_test = []
+	{
+		code_type code{};
+		emit(code, opcode::call, 127);
+		emit_push(code, -64);
+		emit(code, opcode::nop);
+
+		expect(code.size() == 5_ul);
+	};
+
+	"malformed code is rejected"_test = []
+	{
+		const auto walk = [](const code_type& code) { return for_each_instruction(code, [](const instruction&) {}); };
+
+		expect(not walk({static_cast<std::uint8_t>(opcode_count)}));
+		// truncated operand
+		expect(not walk({static_cast<std::uint8_t>(opcode::get), 0x80}));
+		expect(not walk({static_cast<std::uint8_t>(opcode::if_else), 1}));
+		// more than 64 bits
+		expect(not walk({static_cast<std::uint8_t>(opcode::call), 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01}));
+		// the tenth byte may only hold the 64th bit
+		expect(not walk({static_cast<std::uint8_t>(opcode::call), 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x02}));
+		expect(not walk({static_cast<std::uint8_t>(opcode::call), 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x7f}));
+		std::size_t offset = 0;
+		const code_type largest{0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01};
+		expect(decode_unsigned(largest, offset) == std::numeric_limits<std::uint64_t>::max());
+		expect(offset == largest.size());
+		expect(walk({}));
+	};
+};
@@ -0,0 +1,135 @@
+#include <CMakeTemplateProject/compiled_module.hpp>
+#include <CMakeTemplateProject/bytecode.hpp>
+
+#define BOOST_UT_DISABLE_MODULE
+
+#include <boost/ut.hpp>
+
+#include <cstddef>
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+
+using namespace boost::ut;
+
+suite test_compiled_module = []
+{
+	"round trip"_test = []
+	{
+		backend::Module mod{"test"};
+		backend::LocalBuilder builder{mod};
+
+		auto* function = mod.register_function("f", {.input = 1, .output = 2});
+		builder.begin_function(*function);
+		(void)builder.register_local("a");
+		auto* block = builder.register_block({.input = 1, .output = 2});
+		backend::bytecode::emit(block->code, backend::bytecode::opcode::set, 0);
+		backend::bytecode::emit(block->code, backend::bytecode::opcode::get, 0);
+		backend::bytecode::emit(block->code, backend::bytecode::opcode::dup);
+		(void)mod.register_function("forward", {.input = 0, .output = 0});
+		(void)mod.register_global_mutable_data("counter", backend::data_type::repeat(backend::data_type{std::string(1, '\0')}, 1024 * 1024));
+		(void)mod.register_global_immutable_data("message", backend::data_type{"hello"});
+
+		// ["ab", [00] * 2] * 3
+		auto pattern = backend::data_type{"ab"};
+		pattern.append(backend::data_type::repeat(backend::data_type{std::string(1, '\0')}, 2));
+		(void)mod.register_global_immutable_data("nested", backend::data_type::repeat(std::move(pattern), 3));
+
+		auto image = backend::serialize(mod, 0x1234, 42);
+		const auto compiled = backend::CompiledModule::from_bytes(std::move(image));
+
+		expect((compiled.has_value()) >> fatal);
+		expect(compiled->module_name() == "test");
+		expect(compiled->source_hash() == 0x1234_ull);
+		expect((compiled->functions().size() == 2_ul) >> fatal);
+		expect(compiled->string(compiled->functions()[0].name) == "f");
+		expect(compiled->blocks_of(compiled->functions()[0]).size() == 1_ul);
+		expect(compiled->blocks_of(compiled->functions()[1]).empty());
+		expect(compiled->functions()[0].local_count == 1_u);
+		expect(compiled->code(compiled->blocks()[0]).size() == block->code.size());
+		expect((compiled->globals().size() == 3_ul) >> fatal);
+		// stored as a single segment, not a megabyte of zeros
+		expect(compiled->segments_of(compiled->globals()[0]).size() == 1_ul);
+		expect(compiled->bytes().size() < 1024_ul);
+		expect(compiled->globals()[0].data_size == 1024_ull * 1024);
+		expect(compiled->data(compiled->globals()[0]).all_zero());
+		expect(compiled->expand(compiled->globals()[1]) == "hello");
+		expect(compiled->expand(compiled->globals()[2]) == std::string{"ab\0\0ab\0\0ab\0\0", 12});
+
+		const auto loaded = compiled->load();
+		expect(loaded->functions().size() == 2_ul);
+		expect(loaded->globals().size() == 3_ul);
+		expect(loaded->blocks().size() == 1_ul);
+		expect(loaded->locals().size() == 1_ul);
+		loaded->blocks().for_each([block](const backend::Block& b) { expect(b.code == block->code); });
+	};
+
+	"code with an operand out of range"_test = []
+	{
+		backend::Module mod{"test"};
+		backend::LocalBuilder builder{mod};
+
+		builder.begin_function(*mod.register_function("f", {.input = 0, .output = 0}));
+		// no such local
+		backend::bytecode::emit(builder.register_block({.input = 0, .output = 0})->code, backend::bytecode::opcode::get, 0);
+
+		expect(not backend::CompiledModule::from_bytes(backend::serialize(mod, 0, 0)).has_value());
+	};
+
+	"a block claimed by another function"_test = []
+	{
+		backend::Module mod{"test"};
+		backend::LocalBuilder builder{mod};
+
+		builder.begin_function(*mod.register_function("f", {.input = 0, .output = 0}));
+		(void)builder.register_block({.input = 0, .output = 0});
+		builder.begin_function(*mod.register_function("g", {.input = 0, .output = 0}));
+		(void)builder.register_block({.input = 0, .output = 0});
+
+		auto image = backend::serialize(mod, 0, 0);
+		expect(backend::CompiledModule::from_bytes(std::vector<std::byte>{image}).has_value());
+
+		// the first block (of f) now names g, whose operands would be checked against the wrong blocks
+		backend::image::header header{};
+		std::memcpy(&header, image.data(), sizeof(header));
+		constexpr std::uint32_t g = 1;
+		std::memcpy(image.data() + header.blocks_offset + offsetof(backend::image::block_record, function), &g, sizeof(g));
+		expect(not backend::CompiledModule::from_bytes(std::move(image)).has_value());
+	};
+
+	"corrupted image"_test = []
+	{
+		const backend::Module mod{"test"};
+
+		auto image = backend::serialize(mod, 0, 0);
+		image[0] = std::byte{'X'};
+		expect(not backend::CompiledModule::from_bytes(std::move(image)).has_value());
+
+		auto truncated = backend::serialize(mod, 0, 0);
+		truncated.pop_back();
+		expect(not backend::CompiledModule::from_bytes(std::move(truncated)).has_value());
+	};
+
+	"a failed write leaves no temporary file"_test = []
+	{
+		const backend::Module mod{"test"};
+		const auto image = backend::serialize(mod, 0, 0);
+
+		const auto directory = std::filesystem::temp_directory_path() / "test_compiled_module_write";
+		std::filesystem::remove_all(directory);
+		std::filesystem::create_directories(directory / "target");
+
+		// the temporary file is written, but cannot replace a directory
+		expect(not backend::write_compiled_module(image, (directory / "target").string().c_str()));
+		// the temporary file cannot even be created
+		expect(not backend::write_compiled_module(image, (directory / "missing" / "target").string().c_str()));
+
+		const auto entries = std::distance(std::filesystem::directory_iterator{directory}, std::filesystem::directory_iterator{});
+		expect(entries == 1_i);
+
+		expect(backend::write_compiled_module(image, (directory / "module").string().c_str()));
+		expect(std::filesystem::file_size(directory / "module") == image.size());
+		std::filesystem::remove_all(directory);
+	};
+};
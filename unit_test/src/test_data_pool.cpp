@@ -0,0 +1,136 @@
+#include <CMakeTemplateProject/backend.hpp>
+#include <CMakeTemplateProject/thread_pool.hpp>
+
+#define BOOST_UT_DISABLE_MODULE
+
+#include <boost/ut.hpp>
+
+#include <limits>
+#include <string>
+#include <vector>
+
+using namespace boost::ut;
+
+namespace
+{
+	[[nodiscard]] auto table() -> backend::data_type
+	{
+		// "0123456789", [ff] * 64
+		auto result = backend::data_type{"0123456789"};
+		result.append(backend::data_type::repeat(backend::data_type{std::string(1, '\xff')}, 64));
+		return result;
+	}
+
+	[[nodiscard]] auto payload_of(const backend::Module& mod, const backend::index_type index) -> const backend::data_type*
+	{
+		const backend::data_type* result = nullptr;
+		mod.globals().for_each([&](const backend::Global& global) { if (global.index == index) { result = global.data.payload(); } });
+		return result;
+	}
+}
+
+suite test_data_pool = []
+{
+	"identical immutable globals share their data"_test = []
+	{
+		backend::Module mod{"test"};
+		(void)mod.register_global_immutable_data("a", table());
+		(void)mod.register_global_immutable_data("b", table());
+		(void)mod.register_global_immutable_data("c", backend::data_type{"0123456789"});
+		(void)mod.register_global_mutable_data("d", table());
+
+		expect((payload_of(mod, 0) != nullptr) >> fatal);
+		expect(payload_of(mod, 0) == payload_of(mod, 1));
+		expect(payload_of(mod, 0) != payload_of(mod, 2));
+		// mutable data is never shared
+		expect(payload_of(mod, 3) == nullptr);
+
+		mod.globals().for_each([](const backend::Global& global) { expect(global.index == 2 or global.data.expand() == table().expand()); });
+
+		const auto stats = mod.data_pool().stats();
+		expect(stats.payloads == 2_ul);
+		expect(stats.reused == 1_ul);
+		expect(stats.bytes_saved == table().stored_size());
+		expect(stats.bytes_saved == 11_ull);
+		expect(stats.expanded_bytes_saved == 74_ull);
+	};
+
+	"modules share their data only when asked to"_test = []
+	{
+		const backend::Module alone_a{"a"};
+		const backend::Module alone_b{"b"};
+		expect(&alone_a.data_pool() != &alone_b.data_pool());
+
+		backend::DataPool::share_across_modules(true);
+		backend::Module a{"a"};
+		backend::Module b{"b"};
+		backend::DataPool::share_across_modules(false);
+
+		expect(&a.data_pool() == &backend::DataPool::process());
+		expect(&b.data_pool() == &backend::DataPool::process());
+
+		(void)a.register_global_immutable_data("x", table());
+		(void)b.register_global_immutable_data("y", table());
+		expect(payload_of(a, 0) == payload_of(b, 0));
+	};
+
+	"the pool is safe to share between threads"_test = []
+	{
+		backend::DataPool pool{};
+		concurrency::ThreadPool threads{4};
+
+		std::vector<std::shared_ptr<const backend::data_type>> payloads(256);
+		threads.parallel_for(payloads.size(), [&](const std::size_t index) { payloads[index] = pool.intern(index % 2 == 0 ? table() : backend::data_type{"odd"}); });
+
+		for (std::size_t i = 2; i < payloads.size(); ++i) { expect(payloads[i] == payloads[i % 2]); }
+		expect(pool.stats().payloads == 2_ul);
+		expect(pool.stats().reused == 254_ul);
+	};
+
+	"sizes that overflow are flagged"_test = []
+	{
+		constexpr auto big = backend::data_type::size_type{1} << 32;
+		const auto byte = [] { return backend::data_type{std::string(1, '\0')}; };
+
+		expect(not backend::data_type::repeat(byte(), big).too_large());
+		expect(backend::data_type::repeat(backend::data_type::repeat(byte(), big), big).too_large());
+		// nested patterns
+		auto pattern = backend::data_type{"ab"};
+		pattern.append(backend::data_type::repeat(backend::data_type::repeat(byte(), big), big));
+		expect(pattern.too_large());
+		expect(backend::data_type::repeat(std::move(pattern), 2).too_large());
+		// concatenation
+		auto sum = backend::data_type::repeat(byte(), std::numeric_limits<backend::data_type::size_type>::max());
+		expect(not sum.too_large());
+		sum.append(byte());
+		expect(sum.too_large());
+		backend::data_type empty{};
+		empty.append(std::move(sum));
+		expect(empty.too_large());
+	};
+
+	"released data is not kept by the pool"_test = []
+	{
+		backend::DataPool pool{};
+
+		std::weak_ptr<const backend::data_type> first = pool.intern(table());
+		expect(first.expired());
+
+		const auto second = pool.intern(table());
+		expect(pool.stats().payloads == 2_ul);
+		expect(pool.stats().reused == 0_ul);
+	};
+
+	"released data does not leave its hash behind"_test = []
+	{
+		backend::DataPool pool{};
+
+		const auto kept = pool.intern(table());
+		for (std::size_t i = 0; i < 10000; ++i) { (void)pool.intern(backend::data_type{std::to_string(i)}); }
+
+		expect(pool.stats().payloads == 10001_ul);
+		// only the live payload and the buckets added since the last sweep remain
+		expect(pool.stats().buckets < 1000_ul) << pool.stats().buckets;
+		expect(pool.intern(table()) == kept);
+	};
+};
@@ -0,0 +1,126 @@
+#include <CMakeTemplateProject/elf_object.hpp>
+
+#define BOOST_UT_DISABLE_MODULE
+
+#include <boost/ut.hpp>
+
+#include <cstring>
+#include <string>
+#include <string_view>
+
+using namespace boost::ut;
+using backend::elf::section_index;
+
+namespace
+{
+	template<typename T>
+	[[nodiscard]] auto read(const std::vector<std::byte>& object, const std::uint64_t offset) -> T
+	{
+		T result{};
+		std::memcpy(&result, object.data() + offset, sizeof(T));
+		return result;
+	}
+
+	[[nodiscard]] auto section(const std::vector<std::byte>& object, const section_index index) -> backend::elf::section_header
+	{
+		const auto header = read<backend::elf::file_header>(object, 0);
+		return read<backend::elf::section_header>(object, header.section_headers_offset + static_cast<std::uint64_t>(index) * sizeof(backend::elf::section_header));
+	}
+
+	[[nodiscard]] auto string(const std::vector<std::byte>& object, const section_index table, const std::uint32_t offset) -> std::string_view
+	{
+		return {reinterpret_cast<const char*>(object.data() + section(object, table).offset + offset)};
+	}
+}
+
+suite test_elf_object = []
+{
+	"globals are placed into their sections with their symbols"_test = []
+	{
+		backend::Module mod{"test"};
+		(void)mod.register_global_mutable_data("counter", backend::data_type{std::string{"\x05\0\0\0\0\0\0\0", 8}});
+		(void)mod.register_global_mutable_data("buffer", backend::data_type::repeat(backend::data_type{std::string(1, '\0')}, 1024 * 1024));
+		(void)mod.register_global_immutable_data("message", backend::data_type{"hello"});
+		// ["ab", [00] * 2] * 3
+		auto pattern = backend::data_type{"ab"};
+		pattern.append(backend::data_type::repeat(backend::data_type{std::string(1, '\0')}, 2));
+		(void)mod.register_global_immutable_data("nested", backend::data_type::repeat(std::move(pattern), 3));
+
+		const auto object = backend::write_elf_object(mod);
+
+		const auto header = read<backend::elf::file_header>(object, 0);
+		expect(std::memcmp(header.ident.data(), backend::elf::magic.data(), backend::elf::magic.size()) == 0_i);
+		expect(header.ident[backend::elf::ident_class] == backend::elf::class_64);
+		expect(header.type == backend::elf::type_relocatable);
+		expect((header.section_header_count == backend::elf::section_count) >> fatal);
+		// the megabyte of zeros is not in the file
+		expect(object.size() < 1024_ul);
+
+		expect(string(object, section_index::shstrtab, section(object, section_index::data).name) == ".data");
+		expect(string(object, section_index::shstrtab, section(object, section_index::rodata).name) == ".rodata");
+		expect(string(object, section_index::shstrtab, section(object, section_index::bss).name) == ".bss");
+		expect(section(object, section_index::data).flags == (backend::elf::flag_alloc | backend::elf::flag_write));
+		expect(section(object, section_index::rodata).flags == backend::elf::flag_alloc);
+		expect(section(object, section_index::bss).type == backend::elf::section_nobits);
+		expect(section(object, section_index::bss).size == 1024_ull * 1024);
+
+		const auto symtab = section(object, section_index::symtab);
+		expect((symtab.size == 6 * sizeof(backend::elf::symbol)) >> fatal);
+		// null, file, then the globals in index order
+		expect(symtab.info == 2_u);
+
+		const auto symbol = [&](const std::size_t index) { return read<backend::elf::symbol>(object, symtab.offset + index * sizeof(backend::elf::symbol)); };
+		const auto content = [&](const backend::elf::symbol& s) -> std::string
+		{
+			const auto in = section(object, static_cast<section_index>(s.section));
+			return {reinterpret_cast<const char*>(object.data() + in.offset + s.value), static_cast<std::size_t>(s.size)};
+		};
+
+		expect(string(object, section_index::strtab, symbol(1).name) == "test");
+
+		const auto counter = symbol(2);
+		expect(string(object, section_index::strtab, counter.name) == "counter");
+		expect(counter.section == static_cast<std::uint16_t>(section_index::data));
+		expect(content(counter) == std::string{"\x05\0\0\0\0\0\0\0", 8});
+
+		const auto buffer = symbol(3);
+		expect(buffer.section == static_cast<std::uint16_t>(section_index::bss));
+		expect(buffer.size == 1024_ull * 1024);
+
+		const auto message = symbol(4);
+		const auto nested = symbol(5);
+		expect(string(object, section_index::strtab, nested.name) == "nested");
+		expect(message.section == static_cast<std::uint16_t>(section_index::rodata));
+		expect(content(message) == "hello");
+		// aligned to 8 bytes
+		expect(nested.value == 8_ull);
+		expect(content(nested) == std::string{"ab\0\0ab\0\0ab\0\0", 12});
+	};
+
+	"globals sharing their data share their place"_test = []
+	{
+		backend::Module mod{"test"};
+		(void)mod.register_global_immutable_data("first", backend::data_type{"table"});
+		(void)mod.register_global_immutable_data("other", backend::data_type{"other"});
+		(void)mod.register_global_immutable_data("second", backend::data_type{"table"});
+
+		const auto object = backend::write_elf_object(mod);
+		const auto symtab = section(object, section_index::symtab);
+		const auto symbol = [&](const std::size_t index) { return read<backend::elf::symbol>(object, symtab.offset + index * sizeof(backend::elf::symbol)); };
+
+		expect(section(object, section_index::rodata).size == 16_ull);
+		expect(symbol(2).value == 0_ull);
+		expect(symbol(3).value == 8_ull);
+		expect(symbol(4).value == 0_ull);
+		expect(symbol(4).size == 5_ull);
+	};
+
+	"a module without globals is a valid empty object"_test = []
+	{
+		const backend::Module mod{"empty"};
+
+		const auto object = backend::write_elf_object(mod);
+		expect(section(object, section_index::data).size == 0_ull);
+		expect(section(object, section_index::symtab).size == 2 * sizeof(backend::elf::symbol));
+	};
+};
@@ -1,9 +1,17 @@
 #include <CMakeTemplateProject/frontend.hpp>
+#include <CMakeTemplateProject/bytecode.hpp>
+#include <CMakeTemplateProject/thread_pool.hpp>
 
 #define BOOST_UT_DISABLE_MODULE
 
 #include <boost/ut.hpp>
 
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <utility>
+#include <vector>
+
 using namespace boost::ut;
 
 suite test_frontend = [] {
@@ -11,3 +19,494 @@ suite test_frontend = [] {
 
 	frontend::parse_file_and_print(target_file);
 };
+
+suite test_frontend_batch = []
+{
+	"results keep the input order"_test = []
+	{
+		const std::vector<std::string> files{"missing_0.txt", "missing_1.txt", "missing_2.txt", "missing_3.txt"};
+
+		const auto results = frontend::parse_files(files);
+
+		expect((results.size() == files.size()) >> fatal);
+		for (std::size_t i = 0; i < files.size(); ++i)
+		{
+			expect(results[i].filename == files[i]);
+			expect(not results[i].succeeded());
+			expect(results[i].diagnostics.find(files[i]) != std::string::npos);
+		}
+	};
+};
+
+suite test_frontend_parallel = []
+{
+	"the module is the same as the one parsed serially"_test = []
+	{
+		const auto path = (std::filesystem::temp_directory_path() / "test_frontend_parallel.txt").string();
+		{
+			std::ofstream out{path, std::ios::trunc};
+			out << "module @m;\n";
+			for (int i = 0; i < 200; ++i)
+			{
+				out << "# function " << i << "\n";
+				out << "global @g" << i << " = " << (i % 10) << "0, [\"x\"] * " << i << ";\n";
+				if (i % 3 == 0) { out << "function @f" << i << " [1=>1] { local %a; local %b; dummy }\n"; }
+				else { out << "function @f" << i << " [0=>1] { local %a; block %x [0=>1] { address @g" << i << " $drop call %y } block %y [0=>1] { push " << i << " set %a get %a call @f0 } }\n"; }
+			}
+		}
+
+		concurrency::ThreadPool pool{4};
+		const auto serial = frontend::parse_file(path);
+		const auto parallel = frontend::parse_file_parallel(path, pool);
+		std::filesystem::remove(path);
+
+		expect((serial.succeeded()) >> fatal) << serial.diagnostics;
+		expect((parallel.succeeded()) >> fatal) << parallel.diagnostics;
+
+		expect(parallel.module->functions().size() == serial.module->functions().size());
+		expect(parallel.module->globals().size() == serial.module->globals().size());
+		expect(parallel.module->locals().size() == serial.module->locals().size());
+		expect(parallel.module->blocks().size() == serial.module->blocks().size());
+
+		const auto shape = [](const backend::Module& mod)
+		{
+			std::vector<std::pair<std::string, std::size_t>> result{};
+			mod.functions().for_each(
+					[&result](const backend::Function& function)
+					{
+						result.emplace_back(function.name, function.blocks.size());
+						for (const auto* block: function.blocks) { result.emplace_back(std::string(block->code.begin(), block->code.end()), block->slot); }
+					});
+			return result;
+		};
+		expect(shape(*parallel.module) == shape(*serial.module));
+	};
+
+	"a second body in another chunk is reported as serially"_test = []
+	{
+		const auto path = (std::filesystem::temp_directory_path() / "test_frontend_parallel_duplicate.txt").string();
+		{
+			std::ofstream out{path, std::ios::trunc};
+			out << "module @m;\n";
+			for (int i = 0; i < 200; ++i) { out << "function @f" << i << " [0=>1] { push " << i << " }\n"; }
+			out << "function @f0 [0=>1] { push -1 }\n";
+		}
+
+		concurrency::ThreadPool pool{4};
+		const auto serial = frontend::parse_file(path);
+		const auto parallel = frontend::parse_file_parallel(path, pool);
+		std::filesystem::remove(path);
+
+		expect(serial.error_count == 1_ul) << serial.diagnostics;
+		expect(parallel.error_count == serial.error_count) << parallel.diagnostics;
+		expect(parallel.diagnostics.find("duplicate function declaration named 'f0'") != std::string::npos) << parallel.diagnostics;
+	};
+};
+
+suite test_frontend_lazy = []
+{
+	"bodies are parsed on first use"_test = []
+	{
+		const auto path = (std::filesystem::temp_directory_path() / "test_frontend_lazy.txt").string();
+		{
+			std::ofstream out{path, std::ios::trunc};
+			out << R"(module @m;
+global @a = 01, 02;
+function @f [1=>1] { local %a; local %b; dummy }
+function @g [0=>1];
+function @g [0=>1] { block %x [0=>1] { push 1 } block %y { dummy } }
+)";
+		}
+
+		auto lazy = frontend::LazyModule::open(path);
+		const auto serial = frontend::parse_file(path);
+		std::filesystem::remove(path);
+
+		expect((lazy.module() != nullptr) >> fatal) << lazy.diagnostics();
+		expect(lazy.module()->functions().size() == 2_ul);
+		expect(lazy.module()->globals().size() == 1_ul);
+		expect(lazy.module()->locals().size() == 0_ul);
+		expect(lazy.module()->blocks().size() == 0_ul);
+		expect(not lazy.body_parsed("g"));
+
+		expect(lazy.parse_body("g")) << lazy.diagnostics();
+		expect(lazy.body_parsed("g"));
+		expect(not lazy.body_parsed("f"));
+		// the entry block and two others
+		expect(lazy.module()->blocks().size() == 3_ul);
+		expect(not lazy.parse_body("h"));
+
+		expect(lazy.parse_bodies()) << lazy.diagnostics();
+		expect(lazy.error_count() == 0_ul) << lazy.diagnostics();
+		expect((serial.succeeded()) >> fatal) << serial.diagnostics;
+		expect(lazy.module()->locals().size() == serial.module->locals().size());
+		expect(lazy.module()->blocks().size() == serial.module->blocks().size());
+	};
+};
+
+suite test_frontend_incremental = []
+{
+	"only edited declarations are parsed again"_test = []
+	{
+		frontend::IncrementalParser parser{"incremental.txt"};
+
+		const auto first = parser.parse(u8R"(module @m;
+global @a = 01, 02;
+function @f [1=>1];
+function @g [0=>0] { dummy }
+)");
+		expect(first.full_parse);
+		expect(first.parsed == 3_ul);
+		expect(parser.module() != nullptr);
+		expect(parser.error_count() == 0_ul) << parser.diagnostics();
+
+		const auto second = parser.parse(u8R"(module @m;
+global @a = 01, 02;
+function @f [1=>1];
+function @g [0=>0] { dummy dummy }
+)");
+		expect(not second.full_parse);
+		expect(second.reused == 2_ul);
+		expect(second.parsed == 1_ul);
+		expect(parser.error_count() == 0_ul) << parser.diagnostics();
+		// the edited function replaces the previous one
+		expect(parser.module()->functions().size() == 2_ul);
+		expect(parser.module()->globals().size() == 1_ul);
+	};
+
+	"unchanged callers reach the edited declarations"_test = []
+	{
+		frontend::IncrementalParser parser{"incremental.txt"};
+
+		(void)parser.parse(u8R"(module @m;
+global @a = 01;
+function @g [0=>1] { push 1 }
+function @main [0=>1] { address @a $drop call @g }
+)");
+		expect((parser.error_count() == 0_ul) >> fatal) << parser.diagnostics();
+
+		const auto second = parser.parse(u8R"(module @m;
+global @b = 02;
+global @a = 01;
+function @h [0=>0] { dummy }
+function @g [0=>1] { push 2 }
+function @main [0=>1] { address @a $drop call @g }
+)");
+		expect((parser.error_count() == 0_ul) >> fatal) << parser.diagnostics();
+		expect(second.reused == 2_ul);
+		expect(second.parsed == 3_ul);
+
+		const auto& mod = *parser.module();
+		expect(mod.functions().size() == 3_ul);
+		expect(mod.globals().size() == 2_ul);
+
+		const backend::Function* g = nullptr;
+		const backend::Function* main = nullptr;
+		mod.functions().for_each(
+				[&](const backend::Function& function)
+				{
+					if (function.name == "g") { g = &function; }
+					if (function.name == "main") { main = &function; }
+				});
+		backend::index_type a = 0;
+		mod.globals().for_each([&a](const backend::Global& global) { if (global.name == "a") { a = global.index; } });
+
+		expect((g != nullptr and main != nullptr) >> fatal);
+		expect(g->index == 1_u);
+		expect(a == 1_u);
+		expect((g->blocks.size() == 1_ul and main->blocks.size() == 1_ul) >> fatal);
+
+		const auto push = backend::bytecode::decode(g->blocks[0]->code, 0);
+		expect((push.has_value()) >> fatal);
+		expect(push->immediate() == 2);
+
+		// the code of the unchanged caller follows the new indices
+		std::vector<backend::bytecode::instruction> instructions{};
+		expect(backend::bytecode::for_each_instruction(main->blocks[0]->code, [&](const backend::bytecode::instruction& i) { instructions.push_back(i); }));
+		expect((instructions.size() == 3_ul) >> fatal);
+		expect(instructions[0].op == backend::bytecode::opcode::address);
+		expect(instructions[0].operands[0] == a);
+		expect(instructions[2].op == backend::bytecode::opcode::call);
+		expect(instructions[2].operands[0] == g->index);
+	};
+
+	"removed declarations leave the module"_test = []
+	{
+		frontend::IncrementalParser parser{"incremental.txt"};
+
+		(void)parser.parse(u8R"(module @m;
+global @a = 01;
+global @b = 02;
+function @f [0=>0] { dummy }
+function @g [0=>0] { dummy }
+)");
+		const auto second = parser.parse(u8R"(module @m;
+global @b = 02;
+function @g [0=>0] { dummy }
+)");
+		expect(parser.error_count() == 0_ul) << parser.diagnostics();
+		expect(second.reused == 2_ul);
+		expect(second.parsed == 0_ul);
+		expect(parser.module()->functions().size() == 1_ul);
+		expect(parser.module()->globals().size() == 1_ul);
+		parser.module()->functions().for_each([](const backend::Function& function) { expect(function.name == "g" and function.index == 0_u); });
+	};
+
+	"a body kept declared by its forward declaration is replaced"_test = []
+	{
+		frontend::IncrementalParser parser{"incremental.txt"};
+
+		(void)parser.parse(u8R"(module @m;
+function @f [1=>1];
+function @f [1=>1] { local %x; push 1 $add }
+)");
+		const auto second = parser.parse(u8R"(module @m;
+function @f [1=>1];
+function @f [1=>1] { push 2 $add }
+)");
+		expect((parser.error_count() == 0_ul) >> fatal) << parser.diagnostics();
+		expect(second.reused == 1_ul);
+		expect(second.parsed == 1_ul);
+		expect((parser.module()->functions().size() == 1_ul) >> fatal);
+
+		parser.module()->functions().for_each(
+				[](const backend::Function& function)
+				{
+					expect(function.locals.empty());
+					expect((function.blocks.size() == 1_ul) >> fatal);
+
+					const auto push = backend::bytecode::decode(function.blocks[0]->code, 0);
+					expect((push.has_value()) >> fatal);
+					expect(push->immediate() == 2);
+				});
+	};
+
+	"unchanged bodies that refer to a removed global are reported"_test = []
+	{
+		frontend::IncrementalParser parser{"incremental.txt"};
+
+		(void)parser.parse(u8R"(module @m;
+global @a = 01;
+function @f [0=>0] { address @a $drop }
+)");
+		const auto second = parser.parse(u8R"(module @m;
+function @f [0=>0] { address @a $drop }
+)");
+		expect(second.reused == 0_ul);
+		expect(second.parsed == 1_ul);
+		expect(parser.error_count() != 0_ul) << parser.diagnostics();
+		expect(parser.diagnostics().find("unknown global name 'a'") != std::string_view::npos) << parser.diagnostics();
+	};
+};
+
+suite test_frontend_diagnostics = []
+{
+	"quoted and unquoted names are the same symbol"_test = []
+	{
+		const auto parsed = frontend::parse_source("names.txt", u8R"(module @m;
+global @a = 01;
+global @'a' = 02;
+global @'a b' = 03;
+)");
+		expect(parsed.error_count == 1_ul) << parsed.diagnostics;
+		expect(parsed.diagnostics.find("duplicate global declaration named 'a'") != std::string::npos) << parsed.diagnostics;
+	};
+
+	"data whose size overflows is reported"_test = []
+	{
+		const auto parsed = frontend::parse_source("data.txt", u8R"(module @m;
+global @a = [[00] * 4294967296] * 4294967296;
+global @b = [00, 01] * 4294967296, [02] * 18446744073709551615;
+global @c = [00] * 4294967296;
+)");
+		expect(parsed.error_count == 2_ul) << parsed.diagnostics;
+		expect(parsed.diagnostics.find("data too large in global declaration named 'a'") != std::string::npos) << parsed.diagnostics;
+		expect(parsed.diagnostics.find("data too large in global declaration named 'b'") != std::string::npos) << parsed.diagnostics;
+	};
+
+
+	"diagnostics point at the right line"_test = []
+	{
+		const auto parsed = frontend::parse_source("diagnostics.txt", u8R"(module @m;
+global @a = 01;
+global @b = 02;
+global @a = 03;
+global @c = 04;
+global @b = 05;
+)");
+		expect(parsed.error_count == 2_ul) << parsed.diagnostics;
+		// the annotation quotes the offending line
+		expect(parsed.diagnostics.find("global @a = 03") != std::string::npos) << parsed.diagnostics;
+		expect(parsed.diagnostics.find("global @b = 05") != std::string::npos) << parsed.diagnostics;
+		expect(parsed.diagnostics.find("global @c = 04") == std::string::npos) << parsed.diagnostics;
+	};
+
+	"only the first errors are rendered"_test = []
+	{
+		const auto parsed = frontend::parse_source("diagnostics.txt", u8R"(module @m;
+global @a = 01;
+global @a = 02;
+global @a = 03;
+global @a = 04;
+)", 1);
+		// every error is counted
+		expect(parsed.error_count == 3_ul) << parsed.diagnostics;
+		expect(parsed.diagnostics.find("global @a = 02") != std::string::npos) << parsed.diagnostics;
+		expect(parsed.diagnostics.find("global @a = 03") == std::string::npos) << parsed.diagnostics;
+		expect(parsed.diagnostics.find("2 more error(s) not shown") != std::string::npos) << parsed.diagnostics;
+	};
+};
+
+suite test_frontend_slots = []
+{
+	"locals and blocks are numbered per function in declaration order"_test = []
+	{
+		const auto parsed = frontend::parse_source("slots.txt", u8R"(module @m;
+function @f [1=>1] { local %a; local %b; block %x { dummy } dummy }
+function @g [0=>0] { local %c; block %y [0=>0] { dummy } block %z { dummy } }
+)");
+		expect((parsed.error_count == 0_ul) >> fatal) << parsed.diagnostics;
+
+		parsed.module->functions().for_each(
+				[](const backend::Function& function)
+				{
+					for (std::size_t i = 0; i < function.locals.size(); ++i) { expect(function.locals[i]->slot == i); }
+					for (std::size_t i = 0; i < function.blocks.size(); ++i) { expect(function.blocks[i]->slot == i); }
+
+					// the entry block comes first
+					if (function.name == "f") { expect(function.locals.size() == 2_ul and function.blocks.size() == 2_ul); }
+					if (function.name == "g") { expect(function.locals.size() == 1_ul and function.blocks.size() == 3_ul); }
+				});
+	};
+};
+
+suite test_frontend_instructions = []
+{
+	using backend::bytecode::opcode;
+
+	const auto opcodes = [](const backend::Block& block)
+	{
+		std::vector<opcode> result{};
+		expect(backend::bytecode::for_each_instruction(block.code, [&result](const backend::bytecode::instruction& i) { result.push_back(i.op); }));
+		return result;
+	};
+
+	"instructions are encoded into their block"_test = [opcodes]
+	{
+		const auto parsed = frontend::parse_source("instructions.txt", u8R"(module @m;
+global @a = 01, 02;
+function @f [1=>1] { local %x; set %x push -3 get %x $add dummy address @a $load $drop }
+function @g [0=>1] { push 2 call @f [1=>1] call @h [0=>0] }
+)");
+		expect((parsed.error_count == 0_ul) >> fatal) << parsed.diagnostics;
+
+		parsed.module->functions().for_each(
+				[&](const backend::Function& function)
+				{
+					if (function.name == "f")
+					{
+						expect((function.blocks.size() == 1_ul) >> fatal);
+						expect(opcodes(*function.blocks[0]) == std::vector{opcode::set, opcode::push, opcode::get, opcode::add, opcode::nop, opcode::address, opcode::load, opcode::drop});
+
+						const auto push = backend::bytecode::decode(function.blocks[0]->code, 2);
+						expect((push.has_value()) >> fatal);
+						expect(push->immediate() == -3);
+					}
+					if (function.name == "g")
+					{
+						expect((function.blocks.size() == 1_ul) >> fatal);
+						expect(opcodes(*function.blocks[0]) == std::vector{opcode::push, opcode::call, opcode::call});
+					}
+				});
+		// declared by its call
+		expect(parsed.module->functions().size() == 3_ul);
+	};
+
+	"blocks may be used before their declaration"_test = [opcodes]
+	{
+		const auto parsed = frontend::parse_source("blocks.txt", u8R"(module @m;
+function @f [1=>1]
+{
+	block %entry [1=>1] { if %then else %otherwise loop %again }
+	block %then [0=>1] { push 1 }
+	block %otherwise [0=>1] { push 2 }
+	block %again [1=>2] { push 0 }
+}
+)");
+		expect((parsed.error_count == 0_ul) >> fatal) << parsed.diagnostics;
+
+		parsed.module->functions().for_each(
+				[&](const backend::Function& function)
+				{
+					expect((function.blocks.size() == 4_ul) >> fatal);
+					expect(opcodes(*function.blocks[0]) == std::vector{opcode::if_else, opcode::loop});
+					// the signature of the declaration
+					expect(function.blocks[1]->sig.output == 1);
+					expect(function.blocks[3]->sig.input == 1);
+				});
+	};
+
+	"undeclared and duplicate blocks are reported"_test = []
+	{
+		const auto parsed = frontend::parse_source("blocks.txt", u8R"(module @m;
+function @f [0=>0] { block %a { call %missing } block %a { dummy } }
+)");
+		expect(parsed.error_count == 2_ul) << parsed.diagnostics;
+		expect(parsed.diagnostics.find("unknown block name 'missing'") != std::string::npos) << parsed.diagnostics;
+		expect(parsed.diagnostics.find("duplicate block declaration named 'a'") != std::string::npos) << parsed.diagnostics;
+	};
+
+	"bodies that break their signature are reported"_test = []
+	{
+		const auto parsed = frontend::parse_source("stack.txt", u8R"(module @m;
+function @good [2=>1] { $add }
+function @short [0=>1] { dummy }
+function @underflow [1=>1] { $add }
+function @f [0=>0]
+{
+	block %entry [0=>0] { push 1 if %then }
+	block %then [0=>1] { push 2 }
+}
+function @g [1=>1] { block %entry [0=>0] { dummy } }
+)");
+		expect(parsed.error_count == 4_ul) << parsed.diagnostics;
+		expect(parsed.diagnostics.find("wrong number of results in function declaration named 'short'") != std::string::npos) << parsed.diagnostics;
+		expect(parsed.diagnostics.find("stack underflow in function declaration named 'underflow'") != std::string::npos) << parsed.diagnostics;
+		expect(parsed.diagnostics.find("unbalanced branches in block declaration named 'entry'") != std::string::npos) << parsed.diagnostics;
+		// the entry block must have the signature of its function
+		expect(parsed.diagnostics.find("conflicting signature in block declaration named 'entry'") != std::string::npos) << parsed.diagnostics;
+	};
+
+	"a second body is reported and leaves the first one as it is"_test = []
+	{
+		const auto parsed = frontend::parse_source("bodies.txt", u8R"(module @m;
+function @f [0=>1] { push 1 }
+function @f [0=>1];
+function @f [0=>1] { local %x; push 2 }
+)");
+		expect(parsed.error_count == 1_ul) << parsed.diagnostics;
+		expect(parsed.diagnostics.find("duplicate function declaration named 'f'") != std::string::npos) << parsed.diagnostics;
+
+		expect((parsed.module != nullptr) >> fatal);
+		expect((parsed.module->functions().size() == 1_ul) >> fatal);
+		parsed.module->functions().for_each(
+				[](const backend::Function& function)
+				{
+					expect(function.locals.empty());
+					expect((function.blocks.size() == 1_ul) >> fatal);
+
+					const auto push = backend::bytecode::decode(function.blocks[0]->code, 0);
+					expect((push.has_value()) >> fatal);
+					expect(push->immediate() == 1);
+				});
+	};
+
+	"bodies with other errors are not verified"_test = []
+	{
+		const auto parsed = frontend::parse_source("stack.txt", u8R"(module @m;
+function @f [0=>1] { get %missing }
+)");
+		expect(parsed.error_count == 1_ul) << parsed.diagnostics;
+		expect(parsed.diagnostics.find("unknown local name 'missing'") != std::string::npos) << parsed.diagnostics;
+	};
+};
@@ -0,0 +1,192 @@
+#include <CMakeTemplateProject/interpreter.hpp>
+#include <CMakeTemplateProject/frontend.hpp>
+#include <CMakeTemplateProject/bytecode.hpp>
+
+#define BOOST_UT_DISABLE_MODULE
+
+#include <boost/ut.hpp>
+
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+
+using namespace boost::ut;
+using execution::trap_type;
+
+suite test_interpreter = []
+{
+	"functions compute with locals, calls and builtins"_test = []
+	{
+		const auto parsed = frontend::parse_source("interpreter.txt", u8R"(module @m;
+function @square [1=>1] { $dup $mul }
+function @f [2=>1] { local %x; set %x call @square [1=>1] get %x $sub }
+)");
+		expect((parsed.error_count == 0_ul) >> fatal) << parsed.diagnostics;
+
+		execution::Interpreter interpreter{*parsed.module};
+
+		std::array<execution::value_type, 1> result{};
+		// the last argument is on top
+		expect(interpreter.call("f", std::array<execution::value_type, 2>{7, 3}, result) == trap_type::none);
+		expect(result[0] == 46);
+		expect(interpreter.call("square", std::array<execution::value_type, 1>{-5}, result) == trap_type::none);
+		expect(result[0] == 25);
+	};
+
+	"blocks run conditionally and in loops"_test = []
+	{
+		const auto parsed = frontend::parse_source("interpreter.txt", u8R"(module @m;
+function @factorial [1=>1]
+{
+	local %n;
+	local %result;
+	block %entry [1=>1] { set %n push 1 set %result get %n push 0 $lt if %negative get %n if %step get %result }
+	block %negative [0=>0] { push 0 set %n push 0 set %result }
+	block %step [0=>0] { loop %multiply }
+	block %multiply [0=>1] { get %result get %n $mul set %result get %n push -1 $add $dup set %n }
+}
+)");
+		expect((parsed.error_count == 0_ul) >> fatal) << parsed.diagnostics;
+
+		execution::Interpreter interpreter{*parsed.module};
+
+		std::array<execution::value_type, 1> result{};
+		expect(interpreter.call("factorial", std::array<execution::value_type, 1>{10}, result) == trap_type::none);
+		expect(result[0] == 3628800);
+		expect(interpreter.call("factorial", std::array<execution::value_type, 1>{-2}, result) == trap_type::none);
+		expect(result[0] == 0);
+	};
+
+	"globals are read and written through their addresses"_test = []
+	{
+		const auto parsed = frontend::parse_source("interpreter.txt", u8R"(module @m;
+global const @counter = 00, 00, 00, 00, 00, 00, 00, 00;
+global @table = 2a, 00, 00, 00, 00, 00, 00, 00;
+function @bump [0=>1] { address @counter address @counter $load address @table $load $add $store address @counter $load }
+function @overwrite [0=>0] { address @table push 1 $store }
+)");
+		expect((parsed.error_count == 0_ul) >> fatal) << parsed.diagnostics;
+
+		execution::Interpreter interpreter{*parsed.module};
+
+		std::array<execution::value_type, 1> result{};
+		expect(interpreter.call("bump", {}, result) == trap_type::none);
+		expect(interpreter.call("bump", {}, result) == trap_type::none);
+		expect(result[0] == 84);
+
+		std::int64_t counter = 0;
+		expect((interpreter.global(0).size() == 8_ul) >> fatal);
+		std::memcpy(&counter, interpreter.global(0).data(), sizeof(counter));
+		expect(counter == 84);
+
+		expect(interpreter.call("overwrite", {}, {}) == trap_type::read_only);
+	};
+
+	"traps stop the call"_test = []
+	{
+		const auto parsed = frontend::parse_source("interpreter.txt", u8R"(module @m;
+function @divide [2=>1] { $div }
+function @forever [0=>0] { call @forever [0=>0] }
+function @later [0=>0];
+function @wild [0=>1] { push 1 $load }
+)");
+		expect((parsed.error_count == 0_ul) >> fatal) << parsed.diagnostics;
+
+		execution::Interpreter interpreter{*parsed.module, {.stack_size = 16, .locals_size = 16, .call_depth = 64}};
+		expect(interpreter.verified());
+
+		std::array<execution::value_type, 1> result{};
+		expect(interpreter.call("divide", std::array<execution::value_type, 2>{1, 0}, result) == trap_type::division_by_zero);
+		expect(interpreter.call("divide", std::array<execution::value_type, 2>{-7, 2}, result) == trap_type::none);
+		expect(result[0] == -3);
+		expect(interpreter.call("divide", std::array<execution::value_type, 1>{1}, result) == trap_type::signature_mismatch);
+		expect(interpreter.call("forever", {}, {}) == trap_type::call_depth_exceeded);
+		expect(interpreter.call("later", {}, {}) == trap_type::undefined_function);
+		expect(interpreter.call("missing", {}, {}) == trap_type::unknown_function);
+		expect(interpreter.call("wild", {}, result) == trap_type::out_of_bounds);
+
+		// a trap does not break the following calls
+		expect(interpreter.call("divide", std::array<execution::value_type, 2>{9, 3}, result) == trap_type::none);
+		expect(result[0] == 3);
+	};
+
+	"a module that does not verify is run with stack checks"_test = []
+	{
+		// the frontend would not accept these bodies
+		backend::Module mod{"test"};
+		backend::LocalBuilder builder{mod};
+
+		auto* underflow = mod.register_function("underflow", {.input = 1, .output = 0});
+		builder.begin_function(*underflow);
+		auto* block = builder.register_block({.input = 1, .output = 0});
+		backend::bytecode::emit(block->code, backend::bytecode::opcode::drop);
+		backend::bytecode::emit(block->code, backend::bytecode::opcode::drop);
+
+		auto* extra = mod.register_function("extra", {.input = 0, .output = 0});
+		builder.begin_function(*extra);
+		block = builder.register_block({.input = 0, .output = 0});
+		backend::bytecode::emit_push(block->code, 1);
+
+		execution::Interpreter interpreter{mod};
+		expect(not interpreter.verified());
+		expect(interpreter.call("underflow", std::array<execution::value_type, 1>{1}, {}) == trap_type::stack_underflow);
+		expect(interpreter.call("extra", {}, {}) == trap_type::stack_mismatch);
+	};
+
+	"verified code still checks the room of each block"_test = []
+	{
+		const auto parsed = frontend::parse_source("interpreter.txt", u8R"(module @m;
+function @deep [0=>0] { push 1 push 2 push 3 push 4 $add $add $add $drop }
+)");
+		expect((parsed.error_count == 0_ul) >> fatal) << parsed.diagnostics;
+
+		execution::Interpreter interpreter{*parsed.module, {.stack_size = 3, .locals_size = 16, .call_depth = 64}};
+		expect(interpreter.verified());
+		expect(interpreter.call("deep", {}, {}) == trap_type::stack_overflow);
+	};
+
+	"hot functions run as machine code with the same results and traps"_test = []
+	{
+		const auto parsed = frontend::parse_source("interpreter.txt", u8R"(module @m;
+global const @cell = 00, 00, 00, 00, 00, 00, 00, 00;
+function @fib [1=>1]
+{
+	local %n;
+	block %entry [1=>1] { set %n get %n push 2 $lt if %small else %large }
+	block %small [0=>1] { get %n }
+	block %large [0=>1] { get %n push -1 $add call @fib [1=>1] get %n push -2 $add call @fib [1=>1] $add }
+}
+function @mix [2=>1] { $add $dup $mul push 3 $shl address @cell $swap $store address @cell $load push 7 $rem }
+function @divide [2=>1] { $div }
+function @forever [0=>0] { call @forever [0=>0] }
+)");
+		expect((parsed.error_count == 0_ul) >> fatal) << parsed.diagnostics;
+
+		execution::Interpreter interpreted{*parsed.module, {.jit_threshold = 0}};
+		execution::Interpreter tiered{*parsed.module, {.stack_size = 1024, .locals_size = 1024, .call_depth = 64, .jit_threshold = 2}};
+
+		std::array<execution::value_type, 1> expected{};
+		std::array<execution::value_type, 1> result{};
+		for (execution::value_type n = -2; n < 16; ++n)
+		{
+			expect(interpreted.call("fib", std::array<execution::value_type, 1>{n}, expected) == trap_type::none);
+			expect(tiered.call("fib", std::array<execution::value_type, 1>{n}, result) == trap_type::none);
+			expect(result[0] == expected[0]);
+
+			expect(interpreted.call("mix", std::array<execution::value_type, 2>{1, n}, expected) == trap_type::none);
+			expect(tiered.call("mix", std::array<execution::value_type, 2>{1, n}, result) == trap_type::none);
+			expect(result[0] == expected[0]);
+		}
+		expect(not interpreted.compiled(*interpreted.find("fib")));
+		if constexpr (CTP_JIT) { expect(tiered.compiled(*tiered.find("fib"))); }
+
+		for (int i = 0; i < 4; ++i)
+		{
+			expect(tiered.call("divide", std::array<execution::value_type, 2>{1, 0}, result) == trap_type::division_by_zero);
+			expect(tiered.call("divide", std::array<execution::value_type, 2>{std::numeric_limits<execution::value_type>::min(), -1}, result) == trap_type::none);
+			expect(result[0] == std::numeric_limits<execution::value_type>::min());
+			expect(tiered.call("forever", {}, {}) == trap_type::call_depth_exceeded);
+		}
+	};
+};
@@ -0,0 +1,167 @@
+#include <CMakeTemplateProject/linker.hpp>
+#include <CMakeTemplateProject/interpreter.hpp>
+#include <CMakeTemplateProject/bytecode.hpp>
+#include <CMakeTemplateProject/thread_pool.hpp>
+
+#define BOOST_UT_DISABLE_MODULE
+
+#include <boost/ut.hpp>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace boost::ut;
+using backend::bytecode::opcode;
+using execution::trap_type;
+
+namespace
+{
+	auto declare(backend::Module& mod, const backend::symbol_name_view_type name, const backend::Function::signature sig) -> backend::index_type { return mod.register_function(name, sig)->index; }
+
+	// the function gets a single block, filled by `body`
+	template<typename Body>
+	auto define(backend::Module& mod, const backend::symbol_name_view_type name, const backend::Function::signature sig, Body&& body) -> backend::index_type
+	{
+		backend::LocalBuilder builder{mod};
+		auto* function = mod.register_function(name, sig);
+		builder.begin_function(*function);
+		body(builder.register_block(sig)->code);
+		return function->index;
+	}
+
+	[[nodiscard]] auto pointers(const std::vector<std::unique_ptr<backend::Module>>& modules) -> std::vector<const backend::Module*>
+	{
+		std::vector<const backend::Module*> result{};
+		for (const auto& mod: modules) { result.push_back(mod.get()); }
+		return result;
+	}
+}
+
+suite test_linker = []
+{
+	"declarations are resolved to the definitions of other modules"_test = []
+	{
+		std::vector<std::unique_ptr<backend::Module>> modules{};
+
+		// module @main;   global @offset = 03 ...;   function @twice [1=>1];   function @main [1=>1] { call @twice address @offset $load $add }
+		auto& main = *modules.emplace_back(std::make_unique<backend::Module>("main"));
+		(void)main.register_global_mutable_data("offset", backend::data_type{std::string{"\x03\0\0\0\0\0\0\0", 8}});
+		const auto twice = declare(main, "twice", {.input = 1, .output = 1});
+		(void)define(main, "main", {.input = 1, .output = 1}, [twice](backend::bytecode::code_type& code)
+		{
+			backend::bytecode::emit(code, opcode::call, twice);
+			backend::bytecode::emit(code, opcode::address, 0);
+			backend::bytecode::emit(code, opcode::load);
+			backend::bytecode::emit(code, opcode::add);
+		});
+
+		// module @lib;   global @scale = 02 ...;   function @unused [0=>0] {}   function @twice [1=>1] { address @scale $load $mul }
+		auto& lib = *modules.emplace_back(std::make_unique<backend::Module>("lib"));
+		(void)lib.register_global_immutable_data("scale", backend::data_type{std::string{"\x02\0\0\0\0\0\0\0", 8}});
+		(void)define(lib, "unused", {.input = 0, .output = 0}, [](backend::bytecode::code_type&) {});
+		(void)define(lib, "twice", {.input = 1, .output = 1}, [](backend::bytecode::code_type& code)
+		{
+			backend::bytecode::emit(code, opcode::address, 0);
+			backend::bytecode::emit(code, opcode::load);
+			backend::bytecode::emit(code, opcode::mul);
+		});
+
+		concurrency::ThreadPool pool{4};
+		const auto result = backend::linker::link(pointers(modules), "linked", pool);
+		expect(result.succeeded() >> fatal);
+		expect(result.unresolved.empty());
+
+		const auto& linked = *result.module;
+		expect(linked.module_name == "linked");
+		// the symbols of the first module come first
+		std::vector<std::string> functions(linked.functions().size());
+		linked.functions().for_each([&functions](const backend::Function& function) { functions[function.index] = function.name; });
+		expect(functions == std::vector<std::string>{"twice", "main", "unused"});
+		expect(linked.globals().size() == 2_ul);
+
+		execution::Interpreter interpreter{linked};
+		std::array<execution::value_type, 1> value{};
+		expect(interpreter.call("main", std::array<execution::value_type, 1>{5}, value) == trap_type::none);
+		expect(value[0] == 13);
+	};
+
+	"conflicts and duplicates are reported, missing definitions are left declared"_test = []
+	{
+		std::vector<std::unique_ptr<backend::Module>> modules{};
+
+		auto& a = *modules.emplace_back(std::make_unique<backend::Module>("a"));
+		(void)declare(a, "missing", {.input = 0, .output = 1});
+		(void)define(a, "f", {.input = 1, .output = 1}, [](backend::bytecode::code_type&) {});
+		(void)a.register_global_mutable_data("x", backend::data_type{"a"});
+
+		auto& b = *modules.emplace_back(std::make_unique<backend::Module>("b"));
+		(void)declare(b, "f", {.input = 2, .output = 1});
+		(void)define(b, "g", {.input = 0, .output = 0}, [](backend::bytecode::code_type&) {});
+
+		auto& c = *modules.emplace_back(std::make_unique<backend::Module>("c"));
+		(void)define(c, "f", {.input = 1, .output = 1}, [](backend::bytecode::code_type&) {});
+		(void)c.register_global_mutable_data("x", backend::data_type{"c"});
+
+		const auto result = backend::linker::link(pointers(modules), "linked");
+		expect(not result.succeeded());
+		expect((result.errors.size() == 3_ul) >> fatal);
+
+		expect(result.errors[0].type == backend::linker::error_type::conflicting_signature);
+		expect(result.errors[0].module == 1_ul);
+		expect(result.errors[0].name == "f");
+		expect(result.errors[1].type == backend::linker::error_type::duplicate_definition);
+		expect(result.errors[1].module == 2_ul);
+		expect(result.errors[1].name == "f");
+		expect(result.errors[2].type == backend::linker::error_type::duplicate_definition);
+		expect(result.errors[2].name == "x");
+
+		expect(result.unresolved == std::vector<backend::symbol_name_type>{"missing"});
+		expect(result.module->functions().size() == 3_ul);
+		expect(result.module->globals().size() == 1_ul);
+	};
+
+	"thousands of modules link the same whatever the number of threads"_test = []
+	{
+		constexpr std::size_t count = 2000;
+
+		// module i defines @f<i> [1=>1] { push 1 $add call @f<i + 1> } and declares @f<i + 1>, the last one is { push 1 $add }
+		std::vector<std::unique_ptr<backend::Module>> modules{};
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			auto& mod = *modules.emplace_back(std::make_unique<backend::Module>("m" + std::to_string(i)));
+			const auto next = i + 1 == count ? backend::index_type{0} : declare(mod, "f" + std::to_string(i + 1), {.input = 1, .output = 1});
+			(void)define(mod, "f" + std::to_string(i), {.input = 1, .output = 1}, [i, next](backend::bytecode::code_type& code)
+			{
+				backend::bytecode::emit_push(code, 1);
+				backend::bytecode::emit(code, opcode::add);
+				if (i + 1 != count) { backend::bytecode::emit(code, opcode::call, next); }
+			});
+		}
+
+		concurrency::ThreadPool one{1};
+		concurrency::ThreadPool many{8};
+		const auto serial = backend::linker::link(pointers(modules), "linked", one);
+		const auto parallel = backend::linker::link(pointers(modules), "linked", many);
+		expect((serial.succeeded() and parallel.succeeded()) >> fatal);
+
+		std::vector<const backend::Function*> serial_functions(serial.module->functions().size());
+		serial.module->functions().for_each([&](const backend::Function& function) { serial_functions[function.index] = &function; });
+		std::vector<const backend::Function*> parallel_functions(parallel.module->functions().size());
+		parallel.module->functions().for_each([&](const backend::Function& function) { parallel_functions[function.index] = &function; });
+
+		expect((serial_functions.size() == count) >> fatal);
+		expect((parallel_functions.size() == count) >> fatal);
+		for (std::size_t i = 0; i < count; ++i)
+		{
+			expect(serial_functions[i]->name == parallel_functions[i]->name);
+			expect(serial_functions[i]->blocks.front()->code == parallel_functions[i]->blocks.front()->code);
+		}
+
+		execution::Interpreter interpreter{*parallel.module};
+		std::array<execution::value_type, 1> value{};
+		expect(interpreter.call("f0", std::array<execution::value_type, 1>{0}, value) == trap_type::none);
+		expect(value[0] == static_cast<execution::value_type>(count));
+	};
+};
@@ -0,0 +1,107 @@
+#include <CMakeTemplateProject/mapped_file.hpp>
+#include <CMakeTemplateProject/frontend.hpp>
+
+#define BOOST_UT_DISABLE_MODULE
+
+#include <boost/ut.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <utility>
+
+using namespace boost::ut;
+
+namespace
+{
+	[[nodiscard]] auto write_file(const std::string_view name, const std::string_view content) -> std::string
+	{
+		const auto path = (std::filesystem::temp_directory_path() / name).string();
+		std::ofstream out{path, std::ios::binary | std::ios::trunc};
+		out.write(content.data(), static_cast<std::streamsize>(content.size()));
+		return path;
+	}
+
+	[[nodiscard]] auto content_of(const io::MappedFile& file) -> std::string_view { return {file.data(), file.size()}; }
+}
+
+suite test_mapped_file = []
+{
+	"a file is mapped with its whole content"_test = []
+	{
+		const auto path = write_file("test_mapped_file.txt", "module @m;\n");
+		{
+			const io::MappedFile file{path.c_str()};
+			expect((static_cast<bool>(file)) >> fatal);
+			expect(content_of(file) == "module @m;\n");
+		}
+		std::filesystem::remove(path);
+	};
+
+	"an empty file is a valid empty mapping"_test = []
+	{
+		const auto path = write_file("test_mapped_file_empty.txt", "");
+		{
+			const io::MappedFile file{path.c_str()};
+			expect(static_cast<bool>(file));
+			expect(file.data() == nullptr);
+			expect(file.size() == 0_ul);
+		}
+		std::filesystem::remove(path);
+	};
+
+	"missing and non-regular files are not mapped"_test = []
+	{
+		const io::MappedFile missing{"test_mapped_file_missing.txt"};
+		expect(not static_cast<bool>(missing));
+		expect(missing.data() == nullptr);
+
+		const io::MappedFile directory{std::filesystem::temp_directory_path().string().c_str()};
+		expect(not static_cast<bool>(directory));
+
+#if !defined(_WIN32)
+		const io::MappedFile device{"/dev/null"};
+		expect(not static_cast<bool>(device));
+#endif
+	};
+
+	"a moved mapping is owned by its new object only"_test = []
+	{
+		const auto first_path = write_file("test_mapped_file_first.txt", "first");
+		const auto second_path = write_file("test_mapped_file_second.txt", "second");
+		{
+			io::MappedFile first{first_path.c_str()};
+			io::MappedFile moved{std::move(first)};
+			expect(not static_cast<bool>(first));
+			expect(first.data() == nullptr);
+			expect(first.size() == 0_ul);
+			expect((static_cast<bool>(moved)) >> fatal);
+			expect(content_of(moved) == "first");
+
+			// the old mapping of `assigned` is released, it takes over the other one
+			io::MappedFile assigned{second_path.c_str()};
+			assigned = std::move(moved);
+			expect(not static_cast<bool>(moved));
+			expect(content_of(assigned) == "first");
+
+			// unmapped by its destructor
+			assigned = io::MappedFile{};
+			expect(not static_cast<bool>(assigned));
+			expect(assigned.data() == nullptr);
+		}
+		std::filesystem::remove(first_path);
+		std::filesystem::remove(second_path);
+	};
+
+#if !defined(_WIN32)
+	"files that cannot be mapped are read instead"_test = []
+	{
+		// not a regular file, read (empty) rather than mapped, so the grammar reports the missing header instead of a read error
+		const auto result = frontend::parse_file("/dev/null");
+		expect(not result.succeeded());
+		expect(result.error_count != 0_ul);
+		expect(result.diagnostics.find("cannot read file") == std::string::npos) << result.diagnostics;
+	};
+#endif
+};
@@ -0,0 +1,152 @@
+#include <CMakeTemplateProject/reachability.hpp>
+#include <CMakeTemplateProject/interpreter.hpp>
+#include <CMakeTemplateProject/bytecode.hpp>
+
+#define BOOST_UT_DISABLE_MODULE
+
+#include <boost/ut.hpp>
+
+#include <array>
+#include <string>
+#include <vector>
+
+using namespace boost::ut;
+using backend::bytecode::opcode;
+using execution::trap_type;
+
+namespace
+{
+	[[nodiscard]] auto names_of_functions(const backend::Module& mod) -> std::vector<std::string>
+	{
+		std::vector<std::string> result(mod.functions().size());
+		mod.functions().for_each([&result](const backend::Function& function) { result[function.index] = function.name; });
+		return result;
+	}
+
+	[[nodiscard]] auto names_of_globals(const backend::Module& mod) -> std::vector<std::string>
+	{
+		std::vector<std::string> result(mod.globals().size());
+		mod.globals().for_each([&result](const backend::Global& global) { result[global.index] = global.name; });
+		return result;
+	}
+
+	// globals: @unused (mutable) = 00, @table (immutable) = 42, @limit (mutable) = 10
+	// function @dead [0=>1] { call @twice }
+	// function @twice [1=>1] { push 2 $mul }
+	// function @main [1=>1] { address @table $load $lt if { call @twice } else { push 0 } }   (and a block nothing runs)
+	// function @spare [0=>0] {}
+	auto build(backend::Module& mod) -> void
+	{
+		(void)mod.register_global_mutable_data("unused", backend::data_type{std::string(1, '\0')});
+		(void)mod.register_global_immutable_data("table", backend::data_type{std::string{"\x2a\0\0\0\0\0\0\0", 8}});
+		(void)mod.register_global_mutable_data("limit", backend::data_type{std::string{"\x0a\0\0\0\0\0\0\0", 8}});
+
+		backend::LocalBuilder builder{mod};
+
+		auto* dead = mod.register_function("dead", {.input = 0, .output = 1});
+		builder.begin_function(*dead);
+		auto* dead_entry = builder.register_block({.input = 0, .output = 1});
+		backend::bytecode::emit_push(dead_entry->code, 1);
+		backend::bytecode::emit(dead_entry->code, opcode::call, 1);
+
+		auto* twice = mod.register_function("twice", {.input = 1, .output = 1});
+		builder.begin_function(*twice);
+		auto* twice_entry = builder.register_block({.input = 1, .output = 1});
+		backend::bytecode::emit_push(twice_entry->code, 2);
+		backend::bytecode::emit(twice_entry->code, opcode::mul);
+
+		auto* main = mod.register_function("main", {.input = 1, .output = 1});
+		builder.begin_function(*main);
+		(void)builder.register_local("n");
+		auto* main_entry = builder.register_block({.input = 1, .output = 1});
+		auto* never = builder.register_block({.input = 0, .output = 0});
+		auto* then = builder.register_block({.input = 1, .output = 1});
+		auto* otherwise = builder.register_block({.input = 1, .output = 1});
+		backend::bytecode::emit(main_entry->code, opcode::set, 0);
+		backend::bytecode::emit(main_entry->code, opcode::get, 0);
+		backend::bytecode::emit(main_entry->code, opcode::get, 0);
+		backend::bytecode::emit(main_entry->code, opcode::address, 1);
+		backend::bytecode::emit(main_entry->code, opcode::load);
+		backend::bytecode::emit(main_entry->code, opcode::lt);
+		backend::bytecode::emit(main_entry->code, opcode::if_else, 2, 3);
+		backend::bytecode::emit(never->code, opcode::address, 2);
+		backend::bytecode::emit(never->code, opcode::drop);
+		backend::bytecode::emit(then->code, opcode::call, 1);
+		backend::bytecode::emit(otherwise->code, opcode::drop);
+		backend::bytecode::emit_push(otherwise->code, 0);
+
+		auto* spare = mod.register_function("spare", {.input = 0, .output = 0});
+		builder.begin_function(*spare);
+		(void)builder.register_block({.input = 0, .output = 0});
+	}
+}
+
+suite test_reachability = []
+{
+	"only what the roots reach is kept"_test = []
+	{
+		backend::Module mod{"test"};
+		build(mod);
+
+		const auto result = backend::eliminate_dead_symbols(mod, {.functions = {"main"}, .globals = {}});
+		expect((result.module != nullptr) >> fatal);
+		const auto& stripped = *result.module;
+
+		expect(stripped.module_name == "test");
+		expect(names_of_functions(stripped) == std::vector<std::string>{"twice", "main"});
+		expect(names_of_globals(stripped) == std::vector<std::string>{"table"});
+		expect(result.removed_functions == 2_ul);
+		expect(result.removed_globals == 2_ul);
+		// the blocks of @dead and @spare, and the one of @main nothing runs
+		expect(result.removed_blocks == 3_ul);
+		expect(result.missing_roots.empty());
+
+		stripped.functions().for_each(
+				[](const backend::Function& function)
+				{
+					if (function.name != "main") { return; }
+
+					expect((function.blocks.size() == 3_ul) >> fatal);
+					expect(function.locals.size() == 1_ul);
+					for (std::size_t slot = 0; slot < function.blocks.size(); ++slot) { expect(function.blocks[slot]->slot == slot); }
+				});
+
+		execution::Interpreter interpreter{stripped};
+		std::array<execution::value_type, 1> value{};
+		expect(interpreter.call("main", std::array<execution::value_type, 1>{5}, value) == trap_type::none);
+		expect(value[0] == 10);
+		expect(interpreter.call("main", std::array<execution::value_type, 1>{50}, value) == trap_type::none);
+		expect(value[0] == 0);
+	};
+
+	"global roots are kept and missing roots are reported"_test = []
+	{
+		backend::Module mod{"test"};
+		build(mod);
+
+		const auto result = backend::eliminate_dead_symbols(mod, {.functions = {"dead", "missing"}, .globals = {"limit"}});
+		const auto& stripped = *result.module;
+
+		expect(names_of_functions(stripped) == std::vector<std::string>{"dead", "twice"});
+		expect(names_of_globals(stripped) == std::vector<std::string>{"limit"});
+		expect(result.missing_roots == std::vector<backend::symbol_name_type>{"missing"});
+
+		// the kept functions keep their order
+		execution::Interpreter interpreter{stripped};
+		std::array<execution::value_type, 1> value{};
+		expect(interpreter.call("dead", {}, value) == trap_type::none);
+		expect(value[0] == 2);
+	};
+
+	"without roots nothing is kept"_test = []
+	{
+		backend::Module mod{"test"};
+		build(mod);
+
+		const auto result = backend::eliminate_dead_symbols(mod, {});
+		expect(result.module->functions().size() == 0_ul);
+		expect(result.module->globals().size() == 0_ul);
+		expect(result.removed_functions == 4_ul);
+		expect(result.removed_blocks == 7_ul);
+	};
+};
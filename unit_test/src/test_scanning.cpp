@@ -0,0 +1,74 @@
+#include <CMakeTemplateProject/scanning.hpp>
+
+#define BOOST_UT_DISABLE_MODULE
+
+#include <boost/ut.hpp>
+
+#include <string>
+
+using namespace boost::ut;
+
+suite test_scanning = []
+{
+	"identifier length"_test = []
+	{
+		const auto length = [](const std::u8string_view text) { return scanning::identifier_length(text.data(), text.data() + text.size()); };
+
+		expect(length(u8"") == 0_ul);
+		expect(length(u8" abc") == 0_ul);
+		expect(length(u8"abc") == 3_ul);
+		expect(length(u8"a.b_c9;") == 6_ul);
+		// longer than any vector, the end falls in the tail
+		expect(length(u8"a_very_long.identifier_that_spans_several_vectors_of_input_0123456789 = 1") == 69_ul);
+
+		// every position of the mismatch, inside and across vectors
+		for (std::size_t i = 0; i < 80; ++i)
+		{
+			std::u8string text(100, u8'x');
+			text[i] = u8'\xC3';
+			expect(length(text) == i) << i;
+		}
+	};
+
+	"whitespace length"_test = []
+	{
+		const auto length = [](const std::u8string_view text) { return scanning::whitespace_length(text.data(), text.data() + text.size()); };
+
+		expect(length(u8"") == 0_ul);
+		expect(length(u8"module") == 0_ul);
+		expect(length(u8" \t\r\n\v\fmodule") == 6_ul);
+		expect(length(u8"  # comment\n\t# another one\r\n  global") == 30_ul);
+		// the last comment has no newline
+		expect(length(u8"\n\n# unterminated") == 2_ul);
+		// spans several vectors
+		std::u8string indented(68, u8'\t');
+		indented += u8"dummy";
+		expect(length(indented) == 68_ul);
+	};
+
+	"keywords"_test = []
+	{
+		expect(scanning::classify_keyword(u8"module") == scanning::keyword_type::module_);
+		expect(scanning::classify_keyword(u8"global") == scanning::keyword_type::global);
+		expect(scanning::classify_keyword(u8"const") == scanning::keyword_type::const_);
+		expect(scanning::classify_keyword(u8"function") == scanning::keyword_type::function);
+		expect(scanning::classify_keyword(u8"local") == scanning::keyword_type::local);
+		expect(scanning::classify_keyword(u8"block") == scanning::keyword_type::block);
+		expect(scanning::classify_keyword(u8"dummy") == scanning::keyword_type::dummy);
+		expect(scanning::classify_keyword(u8"push") == scanning::keyword_type::push);
+		expect(scanning::classify_keyword(u8"get") == scanning::keyword_type::get);
+		expect(scanning::classify_keyword(u8"set") == scanning::keyword_type::set);
+		expect(scanning::classify_keyword(u8"address") == scanning::keyword_type::address);
+		expect(scanning::classify_keyword(u8"call") == scanning::keyword_type::call);
+		expect(scanning::classify_keyword(u8"if") == scanning::keyword_type::if_);
+		expect(scanning::classify_keyword(u8"else") == scanning::keyword_type::else_);
+		expect(scanning::classify_keyword(u8"loop") == scanning::keyword_type::loop);
+
+		expect(scanning::classify_keyword(u8"globals") == scanning::keyword_type::none);
+		expect(scanning::classify_keyword(u8"blocks") == scanning::keyword_type::none);
+		expect(scanning::classify_keyword(u8"Module") == scanning::keyword_type::none);
+		expect(scanning::classify_keyword(u8"in") == scanning::keyword_type::none);
+		expect(scanning::classify_keyword(u8"lock") == scanning::keyword_type::none);
+		expect(scanning::classify_keyword(u8"") == scanning::keyword_type::none);
+	};
+};
@@ -0,0 +1,68 @@
+#include <CMakeTemplateProject/source_file.hpp>
+#include <CMakeTemplateProject/frontend.hpp>
+
+#define BOOST_UT_DISABLE_MODULE
+
+#include <boost/ut.hpp>
+
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+using namespace boost::ut;
+
+namespace
+{
+	[[nodiscard]] auto write_file(const std::string_view name, const std::string_view content) -> std::string
+	{
+		const auto path = (std::filesystem::temp_directory_path() / name).string();
+		std::ofstream out{path, std::ios::binary | std::ios::trunc};
+		out.write(content.data(), static_cast<std::streamsize>(content.size()));
+		return path;
+	}
+
+	[[nodiscard]] auto content_of(const io::SourceFile& file) -> std::u8string_view { return {file.data(), file.size()}; }
+}
+
+suite test_source_file = []
+{
+	"a byte order mark is not part of the text"_test = []
+	{
+		const auto path = write_file("test_source_file_bom.txt", "\xef\xbb\xbfmodule @m;\nfunction @f [1=>1] { dummy }\n");
+		{
+			const auto file = io::SourceFile::open(path.c_str());
+			expect((file.has_value()) >> fatal);
+			expect(content_of(*file).starts_with(u8"module @m;"));
+
+			const auto result = frontend::parse_file(path);
+			expect(result.succeeded()) << result.diagnostics;
+		}
+		std::filesystem::remove(path);
+	};
+
+	"short files are not mistaken for a byte order mark"_test = []
+	{
+		const auto path = write_file("test_source_file_short.txt", "\xef\xbb");
+		{
+			const auto file = io::SourceFile::open(path.c_str());
+			expect((file.has_value()) >> fatal);
+			expect(file->size() == 2_ul);
+		}
+		std::filesystem::remove(path);
+	};
+
+	"missing files cannot be opened"_test = []
+	{
+		expect(not io::SourceFile::open("test_source_file_missing.txt").has_value());
+	};
+
+#if !defined(_WIN32)
+	"files that cannot be mapped are read instead"_test = []
+	{
+		const auto file = io::SourceFile::open("/dev/null");
+		expect((file.has_value()) >> fatal);
+		expect(file->size() == 0_ul);
+	};
+#endif
+};
@@ -0,0 +1,66 @@
+#include <CMakeTemplateProject/symbol_table.hpp>
+
+#define BOOST_UT_DISABLE_MODULE
+
+#include <boost/ut.hpp>
+
+#include <random>
+#include <string>
+#include <unordered_map>
+
+using namespace boost::ut;
+using symbols::symbol_id;
+
+suite test_symbol_table = []
+{
+	"names are interned once"_test = []
+	{
+		symbols::SymbolInterner interner{};
+
+		const auto a = interner.intern("a");
+		const auto b = interner.intern("b");
+		expect(a != b);
+		expect(interner.intern(std::string{"a"}) == a);
+		expect(interner.find("b") == b);
+		expect(interner.find("c") == symbols::invalid_symbol);
+		expect(interner.name(b) == "b");
+
+		for (int i = 0; i < 1000; ++i) { (void)interner.intern("name" + std::to_string(i)); }
+		expect(interner.size() == 1002_ul);
+		expect(interner.find("name999") == symbol_id{1001});
+		expect(interner.name(a) == "a");
+	};
+
+	"random inserts agree with a map, across clears"_test = []
+	{
+		symbols::SymbolTable<int> table{};
+		std::unordered_map<symbol_id, int> expected{};
+
+		std::mt19937 random{42};
+		std::uniform_int_distribution<symbol_id> key{0, 5000};
+		for (int round = 0; round < 20; ++round)
+		{
+			// a few big tables between small ones, the capacity goes up and down
+			const auto count = round % 5 == 0 ? 3000 : 10;
+			for (int i = 0; i < count; ++i)
+			{
+				const auto k = key(random);
+				expect(table.set(k, i) == expected.emplace(k, i).second);
+			}
+
+			expect(table.size() == expected.size());
+			for (symbol_id k = 0; k <= 5000; ++k)
+			{
+				const auto value = table.get(k);
+				if (const auto it = expected.find(k);
+					it == expected.end()) { expect(not value.has_value()); }
+				else { expect(value.has_value() and value->get() == it->second); }
+			}
+
+			table.clear();
+			expected.clear();
+			expect(table.size() == 0_ul);
+			expect(not table.get(key(random)).has_value());
+		}
+	};
+};
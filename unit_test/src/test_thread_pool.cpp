@@ -0,0 +1,33 @@
+#include <CMakeTemplateProject/thread_pool.hpp>
+
+#define BOOST_UT_DISABLE_MODULE
+
+#include <boost/ut.hpp>
+
+#include <atomic>
+#include <vector>
+
+using namespace boost::ut;
+
+suite test_thread_pool = []
+{
+	"parallel for"_test = []
+	{
+		concurrency::ThreadPool pool{4};
+
+		std::vector<int> out(1000, 0);
+		pool.parallel_for(out.size(), [&out](const std::size_t i) { out[i] = static_cast<int>(i) * 2; });
+
+		for (std::size_t i = 0; i < out.size(); ++i) { expect(out[i] == static_cast<int>(i) * 2); }
+	};
+
+	"nested parallel for"_test = []
+	{
+		concurrency::ThreadPool pool{2};
+
+		std::atomic<int> count{0};
+		pool.parallel_for(16, [&](std::size_t) { pool.parallel_for(16, [&](std::size_t) { count.fetch_add(1); }); });
+
+		expect(count.load() == 256_i);
+	};
+};
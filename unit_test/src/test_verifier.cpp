@@ -0,0 +1,144 @@
+#include <CMakeTemplateProject/verifier.hpp>
+#include <CMakeTemplateProject/thread_pool.hpp>
+
+#define BOOST_UT_DISABLE_MODULE
+
+#include <boost/ut.hpp>
+
+#include <array>
+#include <optional>
+#include <string>
+
+using namespace boost::ut;
+using backend::bytecode::opcode;
+using backend::verifier::error_type;
+
+suite test_verifier = []
+{
+	const auto no_callee = [](std::uint64_t) -> std::optional<backend::Function::signature> { return std::nullopt; };
+
+	"blocks that honour their signatures verify"_test = [no_callee]
+	{
+		backend::Module mod{"test"};
+		backend::LocalBuilder builder{mod};
+
+		auto* function = mod.register_function("f", {.input = 1, .output = 1});
+		builder.begin_function(*function);
+		(void)builder.register_local("n");
+		auto* entry = builder.register_block({.input = 1, .output = 1});
+		auto* then = builder.register_block({.input = 1, .output = 1});
+		auto* body = builder.register_block({.input = 0, .output = 1});
+
+		// set %n push 1 get %n if %then loop %body
+		backend::bytecode::emit(entry->code, opcode::set, 0);
+		backend::bytecode::emit_push(entry->code, 1);
+		backend::bytecode::emit(entry->code, opcode::get, 0);
+		backend::bytecode::emit(entry->code, opcode::if_, 1);
+		backend::bytecode::emit(entry->code, opcode::loop, 2);
+		// $dup $mul
+		backend::bytecode::emit(then->code, opcode::dup);
+		backend::bytecode::emit(then->code, opcode::mul);
+		// push 0
+		backend::bytecode::emit_push(body->code, 0);
+
+		std::array<std::size_t, 3> max_heights{};
+		expect(not backend::verifier::verify_function(*function, 0, no_callee, max_heights).has_value());
+		expect(max_heights[0] == 2_ul);
+		expect(max_heights[1] == 2_ul);
+		expect(max_heights[2] == 1_ul);
+	};
+
+	"the first broken block is reported"_test = [no_callee]
+	{
+		const auto verify = [no_callee](const backend::Function::signature sig, const auto& build) -> std::optional<backend::verifier::error>
+		{
+			backend::Module mod{"test"};
+			backend::LocalBuilder builder{mod};
+
+			auto* function = mod.register_function("f", sig);
+			builder.begin_function(*function);
+			build(builder);
+			return backend::verifier::verify_function(*function, 0, no_callee);
+		};
+
+		const auto underflow = verify({.input = 1, .output = 1}, [](backend::LocalBuilder& builder)
+		{
+			auto* block = builder.register_block({.input = 1, .output = 1});
+			backend::bytecode::emit(block->code, opcode::add);
+		});
+		expect((underflow.has_value()) >> fatal);
+		expect(underflow->type == error_type::stack_underflow);
+		expect(underflow->offset == 0_ul);
+
+		const auto mismatch = verify({.input = 0, .output = 0}, [](backend::LocalBuilder& builder)
+		{
+			(void)builder.register_block({.input = 0, .output = 0});
+			auto* block = builder.register_block({.input = 0, .output = 0});
+			backend::bytecode::emit_push(block->code, 1);
+		});
+		expect((mismatch.has_value()) >> fatal);
+		expect(mismatch->type == error_type::output_mismatch);
+		expect(mismatch->block == 1_u);
+
+		const auto branch = verify({.input = 1, .output = 0}, [](backend::LocalBuilder& builder)
+		{
+			auto* block = builder.register_block({.input = 1, .output = 0});
+			(void)builder.register_block({.input = 0, .output = 1});
+			backend::bytecode::emit(block->code, opcode::if_, 1);
+		});
+		expect((branch.has_value()) >> fatal);
+		expect(branch->type == error_type::unbalanced_branch);
+
+		const auto loop = verify({.input = 0, .output = 0}, [](backend::LocalBuilder& builder)
+		{
+			auto* block = builder.register_block({.input = 0, .output = 0});
+			(void)builder.register_block({.input = 0, .output = 0});
+			backend::bytecode::emit(block->code, opcode::loop, 1);
+		});
+		expect((loop.has_value()) >> fatal);
+		expect(loop->type == error_type::unbalanced_loop);
+
+		const auto entry = verify({.input = 1, .output = 1}, [](backend::LocalBuilder& builder) { (void)builder.register_block({.input = 0, .output = 0}); });
+		expect((entry.has_value()) >> fatal);
+		expect(entry->type == error_type::entry_signature);
+
+		const auto range = verify({.input = 0, .output = 1}, [](backend::LocalBuilder& builder)
+		{
+			auto* block = builder.register_block({.input = 0, .output = 1});
+			backend::bytecode::emit(block->code, opcode::address, 0);
+		});
+		expect((range.has_value()) >> fatal);
+		expect(range->type == error_type::operand_out_of_range);
+	};
+
+	"every function of a module is verified, in parallel or not"_test = []
+	{
+		backend::Module mod{"test"};
+		backend::LocalBuilder builder{mod};
+
+		for (int i = 0; i < 100; ++i)
+		{
+			auto* function = mod.register_function("f" + std::to_string(i), {.input = 0, .output = 1});
+			builder.begin_function(*function);
+			auto* block = builder.register_block({.input = 0, .output = 1});
+			// every 7th function calls the next one
+			if (i % 7 == 0) { backend::bytecode::emit(block->code, opcode::call, i + 1); }
+			// every 10th function forgets its result
+			else if (i % 10 != 0) { backend::bytecode::emit_push(block->code, i); }
+		}
+
+		concurrency::ThreadPool pool{4};
+		const auto serial = backend::verifier::verify_module(mod);
+		const auto parallel = backend::verifier::verify_module(mod, pool);
+
+		// 10, 20, 30, 40, 50, 60, 80, 90 (70 calls 71)
+		expect((serial.size() == 8_ul) >> fatal);
+		expect((parallel.size() == serial.size()) >> fatal);
+		for (std::size_t i = 0; i < serial.size(); ++i)
+		{
+			expect(parallel[i].function == serial[i].function);
+			expect(serial[i].what.type == error_type::output_mismatch);
+		}
+		expect(serial.front().function->name == "f10");
+	};
+};